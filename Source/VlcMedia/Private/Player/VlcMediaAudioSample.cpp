@@ -0,0 +1,222 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaAudioSample.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/PlatformMisc.h"
+
+
+/* FVlcMediaAudioRingBuffer structors
+ *****************************************************************************/
+
+FVlcMediaAudioRingBuffer::FVlcMediaAudioRingBuffer()
+	: Channels(0)
+	, ChunkFrames(0)
+	, ChunkTime(FTimespan::Zero())
+	, FrameSize(0)
+	, Generation(0)
+	, Head(0)
+	, ProducerFlushCount(0)
+	, SampleFormat(EMediaAudioSampleFormat::Undefined)
+	, SampleRate(0)
+	, Tail(0)
+	, WrittenFrames(0)
+	, Writing(false)
+{
+	static_assert((NumChunks & (NumChunks - 1)) == 0, "NumChunks must be a power of two");
+
+	FMemory::Memzero(ChunkGenerations, sizeof(ChunkGenerations));
+	Chunks.Reserve(NumChunks);
+
+	for (uint32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+	{
+		Chunks.Add(MakeShared<FVlcMediaAudioSample, ESPMode::ThreadSafe>());
+	}
+}
+
+
+/* FVlcMediaAudioRingBuffer producer interface
+ *****************************************************************************/
+
+void FVlcMediaAudioRingBuffer::Discard()
+{
+	WrittenFrames = 0;
+
+	++Generation;
+	DiscardGeneration.Set(Generation);
+}
+
+
+void FVlcMediaAudioRingBuffer::Drain()
+{
+	if (Writing && (WrittenFrames > 0))
+	{
+		Publish(WrittenFrames);
+	}
+}
+
+
+void FVlcMediaAudioRingBuffer::Write(const void* Buffer, uint32 NumFrames, FTimespan Time)
+{
+	// discard partially written chunk if the consumer flushed
+	const int32 CurrentFlushCount = FlushCount.GetValue();
+
+	if (CurrentFlushCount != ProducerFlushCount)
+	{
+		ProducerFlushCount = CurrentFlushCount;
+		WrittenFrames = 0;
+	}
+
+	if ((Buffer == nullptr) || (ChunkFrames == 0))
+	{
+		return;
+	}
+
+	const uint8* Source = (const uint8*)Buffer;
+	uint32 Offset = 0;
+
+	while (Offset < NumFrames)
+	{
+		const TSharedRef<FVlcMediaAudioSample, ESPMode::ThreadSafe>& Chunk = Chunks[Head & (NumChunks - 1)];
+
+		if (!Writing)
+		{
+			// the chunk must neither be queued nor referenced by the consumer
+			const uint32 CurrentTail = Tail;
+			FPlatformMisc::MemoryBarrier();
+
+			if ((Head - CurrentTail >= NumChunks) || !Chunk.IsUnique())
+			{
+				DroppedFrames.Add(NumFrames - Offset);
+
+				return;
+			}
+
+			Chunk->ReserveBuffer(ChunkFrames * FrameSize);
+
+			Writing = true;
+			WrittenFrames = 0;
+		}
+
+		if (WrittenFrames == 0)
+		{
+			ChunkTime = Time + FTimespan(((int64)Offset * ETimespan::TicksPerSecond) / SampleRate);
+		}
+
+		const uint32 CopyFrames = FMath::Min(NumFrames - Offset, ChunkFrames - WrittenFrames);
+
+		FMemory::Memcpy((uint8*)Chunk->GetMutableBuffer() + WrittenFrames * FrameSize, Source + Offset * FrameSize, CopyFrames * FrameSize);
+
+		Offset += CopyFrames;
+		WrittenFrames += CopyFrames;
+
+		if (WrittenFrames == ChunkFrames)
+		{
+			Publish(ChunkFrames);
+		}
+	}
+}
+
+
+void FVlcMediaAudioRingBuffer::SetFormat(uint32 InChannels, EMediaAudioSampleFormat InSampleFormat, uint32 InSampleRate, uint32 InSampleSize)
+{
+	Channels = InChannels;
+	ChunkFrames = FMath::Max(1u, (InSampleRate * ChunkMilliseconds) / 1000);
+	FrameSize = InChannels * InSampleSize;
+	SampleFormat = InSampleFormat;
+	SampleRate = InSampleRate;
+
+	// the chunk being written may have been reserved for a different frame size
+	Writing = false;
+	WrittenFrames = 0;
+}
+
+
+/* FVlcMediaAudioRingBuffer consumer interface
+ *****************************************************************************/
+
+bool FVlcMediaAudioRingBuffer::Fetch(TRange<FTimespan> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample)
+{
+	uint32 CurrentTail = Tail;
+	const uint32 CurrentHead = Head;
+
+	FPlatformMisc::MemoryBarrier();
+
+	// skip chunks that the producer discarded
+	const int32 MinGeneration = DiscardGeneration.GetValue();
+
+	if ((CurrentTail != CurrentHead) && (ChunkGenerations[CurrentTail & (NumChunks - 1)] < MinGeneration))
+	{
+		do
+		{
+			++CurrentTail;
+		}
+		while ((CurrentTail != CurrentHead) && (ChunkGenerations[CurrentTail & (NumChunks - 1)] < MinGeneration));
+
+		Tail = CurrentTail;
+	}
+
+	if (CurrentTail == CurrentHead)
+	{
+		return false;
+	}
+
+	const TSharedRef<FVlcMediaAudioSample, ESPMode::ThreadSafe>& Chunk = Chunks[CurrentTail & (NumChunks - 1)];
+	const FTimespan Time = Chunk->GetTime();
+
+	if (!TimeRange.Overlaps(TRange<FTimespan>(Time, Time + Chunk->GetDuration())))
+	{
+		return false;
+	}
+
+	OutSample = Chunk;
+
+	// the reference must be taken before the producer can see the chunk as fetched
+	FPlatformMisc::MemoryBarrier();
+	Tail = CurrentTail + 1;
+
+	return true;
+}
+
+
+void FVlcMediaAudioRingBuffer::Flush()
+{
+	FlushCount.Increment();
+
+	FPlatformMisc::MemoryBarrier();
+	Tail = Head;
+}
+
+
+int32 FVlcMediaAudioRingBuffer::Num() const
+{
+	return (int32)(Head - Tail);
+}
+
+
+/* FVlcMediaAudioRingBuffer implementation
+ *****************************************************************************/
+
+void FVlcMediaAudioRingBuffer::Publish(uint32 NumFrames)
+{
+	const uint32 ChunkIndex = Head & (NumChunks - 1);
+	const TSharedRef<FVlcMediaAudioSample, ESPMode::ThreadSafe>& Chunk = Chunks[ChunkIndex];
+
+	ChunkGenerations[ChunkIndex] = Generation;
+
+	Chunk->Initialize(
+		NumFrames,
+		Channels,
+		SampleFormat,
+		SampleRate,
+		ChunkTime,
+		FTimespan(((int64)NumFrames * ETimespan::TicksPerSecond) / SampleRate)
+	);
+
+	// the chunk must be complete before the consumer can see it
+	FPlatformMisc::MemoryBarrier();
+	Head = Head + 1;
+
+	Writing = false;
+	WrittenFrames = 0;
+}
@@ -3,8 +3,10 @@
 #pragma once
 
 #include "CoreTypes.h"
+#include "Containers/Array.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "IMediaAudioSample.h"
-#include "MediaObjectPool.h"
+#include "Math/Range.h"
 #include "Misc/Timespan.h"
 #include "Templates/SharedPointer.h"
 
@@ -14,7 +16,6 @@
  */
 class FVlcMediaAudioSample
 	: public IMediaAudioSample
-	, public IMediaPoolable
 {
 public:
 
@@ -39,21 +40,28 @@ public:
 public:
 
 	/**
-	 * Initialize the sample.
+	 * Get a writable pointer to the sample buffer.
+	 *
+	 * @return The buffer.
+	 * @see ReserveBuffer
+	 */
+	void* GetMutableBuffer()
+	{
+		return Buffer;
+	}
+
+	/**
+	 * Initialize the sample with data that was written into its buffer.
 	 *
-	 * @param InBuffer The raw audio sample buffer.
-	 * @param InBufferSize The size of the buffer (in bytes).
 	 * @param InFrames Number of frames in the buffer.
 	 * @param InChannels Number of audio channels.
 	 * @param InSampleFormat The sample format.
 	 * @param InSampleRate The sample rate.
 	 * @param InTime The sample time (in the player's local clock).
 	 * @param InDuration The duration for which the sample is valid.
-	 * @return true on success, false otherwise.
+	 * @see GetMutableBuffer, ReserveBuffer
 	 */
-	bool Initialize(
-		void* InBuffer,
-		uint32 InBufferSize,
+	void Initialize(
 		uint32 InFrames,
 		uint32 InChannels,
 		EMediaAudioSampleFormat InSampleFormat,
@@ -61,27 +69,29 @@ public:
 		FTimespan InTime,
 		FTimespan InDuration)
 	{
-		if ((InBuffer == nullptr) || (InBufferSize == 0) || (InSampleFormat == EMediaAudioSampleFormat::Undefined))
-		{
-			return false;
-		}
-
-		if (InBufferSize > BufferSize)
-		{
-			Buffer = FMemory::Realloc(Buffer, InBufferSize);
-			BufferSize = InBufferSize;
-		}
-
-		FMemory::Memcpy(Buffer, InBuffer, InBufferSize);
-
 		Channels = InChannels;
 		Duration = InDuration;
 		Frames = InFrames;
 		SampleFormat = InSampleFormat;
 		SampleRate = InSampleRate;
 		Time = InTime;
+	}
+
+	/**
+	 * Make sure that the sample buffer can hold the specified number of bytes.
+	 *
+	 * @param InBufferSize The required buffer size (in bytes).
+	 * @see GetMutableBuffer
+	 */
+	void ReserveBuffer(SIZE_T InBufferSize)
+	{
+		if (InBufferSize > BufferSize)
+		{
+			FreeBuffer();
 
-		return true;
+			Buffer = FMemory::Malloc(InBufferSize);
+			BufferSize = InBufferSize;
+		}
 	}
 
 public:
@@ -165,5 +175,174 @@ private:
 };
 
 
-/** Implements a pool for VLC audio sample objects. */
-class FVlcMediaAudioSamplePool : public TMediaObjectPool<FVlcMediaAudioSample> { };
+/**
+ * Lock-free ring of fixed-size audio chunks.
+ *
+ * The VLC audio thread writes PCM data into the chunk at the write position,
+ * and the chunk is published to the consumer once it is full. The consumer
+ * fetches the published chunks as shared references to persistent samples,
+ * so that no memory is allocated while playing. A chunk is reused only after
+ * it was fetched (or flushed) and all references to it were released.
+ *
+ * Writing is safe on one producer thread, and fetching and flushing on one
+ * consumer thread, without any locks.
+ */
+class FVlcMediaAudioRingBuffer
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaAudioRingBuffer();
+
+public:
+
+	/**
+	 * Discard all frames that were written so far (producer only).
+	 *
+	 * This includes published chunks that were not fetched yet; the consumer
+	 * skips them on its next fetch.
+	 *
+	 * @see Drain, Write
+	 */
+	void Discard();
+
+	/**
+	 * Publish the partially written chunk, because no more frames will follow (producer only).
+	 *
+	 * @see Discard, Write
+	 */
+	void Drain();
+
+	/**
+	 * Write audio frames into the ring (producer only).
+	 *
+	 * Frames that don't fit into the ring, because the consumer is holding
+	 * on to all chunks, are dropped.
+	 *
+	 * @param Buffer The audio frames to write.
+	 * @param NumFrames Number of frames in the buffer.
+	 * @param Time The time of the first frame (in the player's local clock).
+	 * @see Fetch, GetDroppedFrames, SetFormat
+	 */
+	void Write(const void* Buffer, uint32 NumFrames, FTimespan Time);
+
+	/**
+	 * Set the format of frames to be written (producer only).
+	 *
+	 * A partially written chunk of the previous format is discarded.
+	 *
+	 * @param InChannels Number of audio channels.
+	 * @param InSampleFormat The sample format.
+	 * @param InSampleRate The sample rate.
+	 * @param InSampleSize Size of a single sample (in bytes).
+	 * @see Write
+	 */
+	void SetFormat(uint32 InChannels, EMediaAudioSampleFormat InSampleFormat, uint32 InSampleRate, uint32 InSampleSize);
+
+public:
+
+	/**
+	 * Remove and return the oldest published chunk if it overlaps the specified time range (consumer only).
+	 *
+	 * @param TimeRange The range of time to fetch a chunk for.
+	 * @param OutSample Will contain the chunk's sample.
+	 * @return true if a chunk was returned, false otherwise.
+	 * @see Flush, Write
+	 */
+	bool Fetch(TRange<FTimespan> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample);
+
+	/**
+	 * Discard all published chunks, as well as the chunk being written (consumer only).
+	 *
+	 * @see Fetch
+	 */
+	void Flush();
+
+	/**
+	 * Get the number of frames that were dropped because no chunk was available.
+	 *
+	 * @return Number of dropped frames.
+	 * @see Write
+	 */
+	int32 GetDroppedFrames() const
+	{
+		return DroppedFrames.GetValue();
+	}
+
+	/**
+	 * Get the number of chunks that were published, but not fetched yet.
+	 *
+	 * @return Number of chunks.
+	 */
+	int32 Num() const;
+
+public:
+
+	/** Duration of a chunk (in milliseconds). */
+	static const uint32 ChunkMilliseconds = 20;
+
+	/** Number of chunks in the ring (must be a power of two). */
+	static const uint32 NumChunks = 64;
+
+private:
+
+	/**
+	 * Publish the chunk at the write position (producer only).
+	 *
+	 * @param NumFrames Number of frames in the chunk.
+	 */
+	void Publish(uint32 NumFrames);
+
+private:
+
+	/** Number of audio channels (producer only). */
+	uint32 Channels;
+
+	/** Number of frames per chunk (producer only). */
+	uint32 ChunkFrames;
+
+	/** Generation of the frames in each chunk (written by producer before publishing). */
+	int32 ChunkGenerations[NumChunks];
+
+	/** The chunks' samples. */
+	TArray<TSharedRef<FVlcMediaAudioSample, ESPMode::ThreadSafe>> Chunks;
+
+	/** Time of the first frame in the chunk being written (producer only). */
+	FTimespan ChunkTime;
+
+	/** Oldest generation of chunks that have not been discarded (written by producer). */
+	FThreadSafeCounter DiscardGeneration;
+
+	/** Number of frames dropped because no chunk was available. */
+	FThreadSafeCounter DroppedFrames;
+
+	/** Number of times the consumer flushed the ring. */
+	FThreadSafeCounter FlushCount;
+
+	/** Size of a frame (in bytes; producer only). */
+	uint32 FrameSize;
+
+	/** Generation of frames being written, incremented when discarding (producer only). */
+	int32 Generation;
+
+	/** Index of the next chunk to be published (written by producer). */
+	volatile uint32 Head;
+
+	/** Value of FlushCount when the producer last discarded its chunk (producer only). */
+	int32 ProducerFlushCount;
+
+	/** The sample format (producer only). */
+	EMediaAudioSampleFormat SampleFormat;
+
+	/** The sample rate (producer only). */
+	uint32 SampleRate;
+
+	/** Index of the next chunk to be fetched (written by consumer). */
+	volatile uint32 Tail;
+
+	/** Number of frames written into the chunk at Head (producer only). */
+	uint32 WrittenFrames;
+
+	/** Whether the chunk at Head is owned by the producer (producer only). */
+	bool Writing;
+};
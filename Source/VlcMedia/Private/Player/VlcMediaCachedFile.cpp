@@ -0,0 +1,87 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaCachedFile.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Serialization/Archive.h"
+
+
+/* FVlcMediaCachedFile structors
+ *****************************************************************************/
+
+FVlcMediaCachedFile::FVlcMediaCachedFile(FArchive* InFileReader, const FString& InFilePath)
+	: Buffer(nullptr)
+	, Failed(false)
+	, FilePath(InFilePath)
+	, FileReader(InFileReader)
+	, Size(0)
+	, Stopping(false)
+	, Thread(nullptr)
+{
+	Size = FMath::Max<int64>(0, FileReader->TotalSize());
+
+	if (Size > 0)
+	{
+		Buffer = (uint8*)FMemory::Malloc((SIZE_T)Size);
+		Thread = FRunnableThread::Create(this, TEXT("VlcMediaCachedFile"), 0, TPri_BelowNormal);
+	}
+}
+
+
+FVlcMediaCachedFile::~FVlcMediaCachedFile()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	FMemory::Free(Buffer);
+	Buffer = nullptr;
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+uint32 FVlcMediaCachedFile::Run()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	while (!Stopping && (LoadedBytes.GetValue() < Size))
+	{
+		const int64 Loaded = LoadedBytes.GetValue();
+		const int64 BytesToRead = FMath::Min(ChunkSize, Size - Loaded);
+
+		FileReader->Serialize(Buffer + Loaded, BytesToRead);
+
+		if (FileReader->IsError())
+		{
+			UE_LOG(LogVlcMedia, Warning, TEXT("Failed to precache media file %s at offset %lld"), *FilePath, Loaded);
+			Failed = true;
+
+			break;
+		}
+
+		// publishes the chunk to the reading threads
+		LoadedBytes.Add(BytesToRead);
+	}
+
+	if (IsComplete())
+	{
+		UE_LOG(LogVlcMedia, Verbose, TEXT("Precached media file %s (%lld bytes) in %.1f ms"), *FilePath, Size, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	}
+
+	FileReader.Reset();
+
+	return 0;
+}
+
+
+void FVlcMediaCachedFile::Stop()
+{
+	Stopping = true;
+}
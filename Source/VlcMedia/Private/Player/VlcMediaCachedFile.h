@@ -0,0 +1,145 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Templates/UniquePtr.h"
+
+class FArchive;
+class FRunnableThread;
+
+
+/**
+ * A local file that is loaded into memory on a background thread.
+ *
+ * The file is loaded front to back into a buffer that is allocated up front.
+ * Data below the number of loaded bytes is immutable and may be read from any
+ * thread. Instances are shared by all archives that read the same file.
+ *
+ * @see FVlcMediaFileCache, FVlcMediaPrecacheArchive
+ */
+class FVlcMediaCachedFile
+	: public FRunnable
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * The loader thread starts immediately.
+	 *
+	 * @param InFileReader Archive of the file to load (will be owned by this object).
+	 * @param InFilePath The path of the file to load.
+	 */
+	FVlcMediaCachedFile(FArchive* InFileReader, const FString& InFilePath);
+
+	/** Virtual destructor. */
+	virtual ~FVlcMediaCachedFile();
+
+public:
+
+	/**
+	 * Get the loaded file data.
+	 *
+	 * Only the first GetNumLoadedBytes() bytes are valid.
+	 *
+	 * @return File data.
+	 */
+	const uint8* GetData() const
+	{
+		return Buffer;
+	}
+
+	/**
+	 * Get the path of the file.
+	 *
+	 * @return File path.
+	 */
+	const FString& GetFilePath() const
+	{
+		return FilePath;
+	}
+
+	/**
+	 * Get the number of bytes that are resident in memory.
+	 *
+	 * @return Number of bytes.
+	 * @see IsComplete
+	 */
+	int64 GetNumLoadedBytes() const
+	{
+		return LoadedBytes.GetValue();
+	}
+
+	/**
+	 * Get the size of the file.
+	 *
+	 * @return Size (in bytes).
+	 */
+	int64 GetSize() const
+	{
+		return Size;
+	}
+
+	/**
+	 * Check whether loading the file failed.
+	 *
+	 * @return true if loading failed, false otherwise.
+	 */
+	bool HasFailed() const
+	{
+		return Failed;
+	}
+
+	/**
+	 * Check whether the entire file is resident in memory.
+	 *
+	 * @return true if loaded, false otherwise.
+	 * @see GetNumLoadedBytes
+	 */
+	bool IsComplete() const
+	{
+		return (LoadedBytes.GetValue() >= Size);
+	}
+
+public:
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+public:
+
+	/** Number of bytes that the loader reads at a time. */
+	static const int64 ChunkSize = 4 * 1024 * 1024;
+
+private:
+
+	/** The loaded file data. */
+	uint8* Buffer;
+
+	/** Whether loading the file failed. */
+	FThreadSafeBool Failed;
+
+	/** The path of the file being loaded. */
+	FString FilePath;
+
+	/** Archive that the loader thread reads from. */
+	TUniquePtr<FArchive> FileReader;
+
+	/** Number of bytes loaded into the buffer so far. */
+	FThreadSafeCounter64 LoadedBytes;
+
+	/** The file size (in bytes). */
+	int64 Size;
+
+	/** Whether the loader thread should stop. */
+	FThreadSafeBool Stopping;
+
+	/** The loader thread. */
+	FRunnableThread* Thread;
+};
@@ -6,59 +6,235 @@
 #include "IMediaAudioSample.h"
 #include "IMediaOptions.h"
 #include "IMediaTextureSample.h"
-#include "MediaSamples.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
 
 #include "Vlc.h"
 #include "VlcMediaAudioSample.h"
+#include "VlcMediaHash.h"
+#include "VlcMediaSamples.h"
 #include "VlcMediaTextureSample.h"
 
 
+static_assert(FVlcMediaPlaneLayout::MaxPlanes == FVlc::MaxPlanes, "Plane layout must support all VLC picture planes");
+
+
+namespace VlcMediaCallbacks
+{
+	/** Get the number of bytes per pixel in the first plane of a sample format. */
+	uint32 GetBytesPerPixel(EMediaTextureSampleFormat SampleFormat)
+	{
+		switch (SampleFormat)
+		{
+		case EMediaTextureSampleFormat::CharNV12:
+		case EMediaTextureSampleFormat::CharNV21:
+			return 1;
+
+		case EMediaTextureSampleFormat::CharUYVY:
+		case EMediaTextureSampleFormat::CharYUY2:
+		case EMediaTextureSampleFormat::CharYVYU:
+			return 2;
+
+		case EMediaTextureSampleFormat::FloatRGBA:
+			return 8;
+
+		default:
+			return 4;
+		}
+	}
+
+	/** Check whether a chroma description describes a 4:2:0 format. */
+	bool IsChroma420(const FLibvlcChromaDescription& ChromaDescr)
+	{
+		if ((ChromaDescr.PlaneCount != 2) && (ChromaDescr.PlaneCount != 3))
+		{
+			return false;
+		}
+
+		// semi-planar formats interleave both chroma components in the second plane,
+		// so its width is twice the number of chroma samples per row
+		const uint32 ComponentsPerPlane = (ChromaDescr.PlaneCount == 2) ? 2 : 1;
+		const auto& Width = ChromaDescr.P[1].W;
+		const auto& Height = ChromaDescr.P[1].H;
+
+		return (Width.Den * ComponentsPerPlane == 2 * Width.Num) && (Height.Den == 2 * Height.Num);
+	}
+}
+
+
 /* FVlcMediaOutput structors
  *****************************************************************************/
 
 FVlcMediaCallbacks::FVlcMediaCallbacks()
 	: AudioChannels(0)
-	, AudioSampleFormat(EMediaAudioSampleFormat::Int16)
-	, AudioSamplePool(new FVlcMediaAudioSamplePool)
+	, AudioOnly(false)
+	, AudioOutputSampleRate(0)
+	, AudioSampleFormat(EMediaAudioSampleFormat::Float)
 	, AudioSampleRate(0)
 	, AudioSampleSize(0)
+	, CurrentClock(0)
+	, CurrentRate(0.0f)
 	, CurrentTime(FTimespan::Zero())
+	, LoopDuration(FTimespan::Zero())
 	, Player(nullptr)
-	, Samples(new FMediaSamples)
+	, Samples(new FVlcMediaSamples)
 	, VideoBufferDim(FIntPoint::ZeroValue)
 	, VideoBufferStride(0)
+	, VideoConversion(VlcMedia::EChromaConversion::I420ToBgra)
+	, VideoConversionEnabled(false)
+	, VideoConvertToRgb(false)
 	, VideoFrameDuration(FTimespan::Zero())
+	, VideoMaxOutputDim(0)
 	, VideoOutputDim(FIntPoint::ZeroValue)
-	, VideoPreviousTime(FTimespan::MinValue())
+	, VideoPreviousDiscards(0)
+	, VideoPreviousHash(0)
+	, VideoPreviousHashValid(false)
 	, VideoSampleFormat(EMediaTextureSampleFormat::CharAYUV)
 	, VideoSamplePool(new FVlcMediaTextureSamplePool)
-{ }
+	, VideoScratchBufferSize(0)
+	, VideoScratchDiscardBuffer(nullptr)
+	, VideoSkipIdenticalFrames(false)
+{
+	FMemory::Memzero(VideoScratchBuffers, sizeof(VideoScratchBuffers));
+	FMemory::Memzero(VideoVisibleLines, sizeof(VideoVisibleLines));
+	FMemory::Memzero(VideoVisibleRowBytes, sizeof(VideoVisibleRowBytes));
+}
 
 
 FVlcMediaCallbacks::~FVlcMediaCallbacks()
 {
 	Shutdown();
 
-	delete AudioSamplePool;
-	AudioSamplePool = nullptr;
 
 	delete Samples;
 	Samples = nullptr;
 
 	delete VideoSamplePool;
 	VideoSamplePool = nullptr;
+
+	FreeVideoScratchBuffers();
 }
 
 
 /* FVlcMediaOutput interface
  *****************************************************************************/
 
+void FVlcMediaCallbacks::ApplyOptions(const IMediaOptions* Options)
+{
+	AudioOnly = (Options != nullptr) && Options->GetMediaOption("AudioOnly", false);
+	VideoConvertToRgb = (Options != nullptr) && Options->GetMediaOption("ConvertToRgb", false);
+	VideoSkipIdenticalFrames = (Options != nullptr) && Options->GetMediaOption("SkipIdenticalFrames", false);
+	VideoMaxOutputDim = (Options != nullptr) ? (int32)FMath::Clamp<int64>(Options->GetMediaOption("MaxOutputDim", (int64)0), 0, MAX_int32) : 0;
+
+	const auto Settings = GetDefault<UVlcMediaSettings>();
+
+	AudioOutputSampleRate = (uint32)FMath::Max(0, Settings->AudioOutputSampleRate);
+
+	Samples->SetVideoLimits(
+		Settings->MaxVideoQueueFrames,
+		(SIZE_T)FMath::Max(0, Settings->MaxVideoQueueMegabytes) * 1024 * 1024,
+		Settings->VideoQueueDropPolicy
+	);
+
+	const bool CacheLoop = (Options != nullptr) && Options->GetMediaOption("CacheLoop", false);
+	Samples->GetLoopCache().SetBudget(CacheLoop ? (SIZE_T)FMath::Max(0, Settings->LoopCacheMegabytes) * 1024 * 1024 : 0);
+}
+
+
+void FVlcMediaCallbacks::BeginCrossfade(FVlcMediaCallbacks& FadeOut, FTimespan Duration)
+{
+	Samples->SetCrossfade(FadeOut.Samples, Duration);
+}
+
+
+void FVlcMediaCallbacks::EndCrossfade()
+{
+	Samples->SetCrossfade(nullptr, FTimespan::Zero());
+}
+
+
+FVlcMediaLoopCache& FVlcMediaCallbacks::GetLoopCache()
+{
+	return Samples->GetLoopCache();
+}
+
+
 IMediaSamples& FVlcMediaCallbacks::GetSamples()
 {
 	return *Samples;
 }
 
 
+FString FVlcMediaCallbacks::GetStats() const
+{
+	FString StatsString;
+	{
+		StatsString += TEXT("Audio Output\n");
+		StatsString += FString::Printf(TEXT("    Queued Chunks: %i of %i\n"), Samples->NumAudio(), (int32)FVlcMediaAudioRingBuffer::NumChunks);
+		StatsString += FString::Printf(TEXT("    Dropped Frames (Queue Full): %i\n"), Samples->GetDroppedAudioFrames());
+
+		const int32 SeekCount = AudioSeekCount.GetValue();
+
+		if (SeekCount > 0)
+		{
+			StatsString += FString::Printf(TEXT("    Seek Latency: %.1f ms (average %.1f ms over %i seeks)\n"),
+				AudioSeekLatency.GetValue() / 1000.0,
+				AudioSeekLatencyTotal.GetValue() / (1000.0 * SeekCount),
+				SeekCount
+			);
+		}
+
+		StatsString += FString::Printf(TEXT("    End Of Stream: %s\n"), (AudioDrained.GetValue() != 0) ? TEXT("Yes") : TEXT("No"));
+		StatsString += TEXT("\n");
+	}
+
+	if (AudioOnly)
+	{
+		StatsString += TEXT("Video Output\n");
+		StatsString += TEXT("    Disabled (audio only)\n");
+		StatsString += TEXT("\n");
+	}
+	else
+	{
+		StatsString += TEXT("Video Output\n");
+		StatsString += FString::Printf(TEXT("    Scratch Frames (Pool Exhausted): %i\n"), VideoScratchPoolFrames.GetValue());
+		StatsString += FString::Printf(TEXT("    Scratch Frames (Init Failed): %i\n"), VideoScratchFailedFrames.GetValue());
+		StatsString += FString::Printf(TEXT("    Scratch Frames (Queue Full): %i\n"), VideoScratchQueueFrames.GetValue());
+		StatsString += FString::Printf(TEXT("    Scratch Frames (Buffers Locked): %i\n"), VideoScratchSharedFrames.GetValue());
+		StatsString += FString::Printf(TEXT("    Dropped Frames (Queue Full): %i\n"), Samples->GetDroppedVideoFrames());
+		StatsString += FString::Printf(TEXT("    Stale Frames (Seeking): %i\n"), VideoStaleFrames.GetValue());
+		if (VideoSkipIdenticalFrames)
+		{
+			StatsString += FString::Printf(TEXT("    Identical Frames Skipped: %i (%i unique)\n"), VideoIdenticalFrames.GetValue(), VideoUniqueFrames.GetValue());
+		}
+
+		StatsString += FString::Printf(TEXT("    Sample Pool: %i samples, %.1f MB (peak %.1f MB)\n"),
+			VideoSamplePool->GetNumSamples(),
+			VideoSamplePool->GetAllocatedBytes() / (1024.0 * 1024.0),
+			VideoSamplePool->GetHighWaterBytes() / (1024.0 * 1024.0)
+		);
+
+		if (VideoConversionEnabled)
+		{
+			const int32 ConvertedFrames = VideoConvertedFrames.GetValue();
+			const double AverageTime = (ConvertedFrames > 0) ? (double)VideoConversionTime.GetValue() / (1000.0 * ConvertedFrames) : 0.0;
+
+			StatsString += FString::Printf(TEXT("    Conversion: %s (%s)\n"), VlcMedia::ChromaConversionToString(VideoConversion), VlcMedia::SimdLevelToString(VlcMedia::GetSimdLevel()));
+			StatsString += FString::Printf(TEXT("    Converted Frames: %i\n"), ConvertedFrames);
+			StatsString += FString::Printf(TEXT("    Average Conversion Time: %.2f ms\n"), AverageTime);
+		}
+		else
+		{
+			StatsString += TEXT("    Conversion: None\n");
+		}
+
+		StatsString += TEXT("\n");
+	}
+
+	return StatsString;
+}
+
+
 void FVlcMediaCallbacks::Initialize(FLibvlcMediaPlayer& InPlayer)
 {
 	Shutdown();
@@ -82,6 +258,12 @@ void FVlcMediaCallbacks::Initialize(FLibvlcMediaPlayer& InPlayer)
 		this
 	);
 
+	// setting video callbacks selects the vmem output, so skip them in audio-only mode
+	if (AudioOnly)
+	{
+		return;
+	}
+
 	FVlc::VideoSetFormatCallbacks(
 		Player,
 		&FVlcMediaCallbacks::StaticVideoSetupCallback,
@@ -98,6 +280,35 @@ void FVlcMediaCallbacks::Initialize(FLibvlcMediaPlayer& InPlayer)
 }
 
 
+void FVlcMediaCallbacks::NotifySeek()
+{
+	AudioSeekOutputCycles.Reset();
+	AudioSeekStartCycles.Set((int64)FPlatformTime::Cycles64());
+	VideoSeekOutputCycles.Reset();
+	VideoSeekStartCycles.Set((int64)FPlatformTime::Cycles64());
+}
+
+
+void FVlcMediaCallbacks::SetCurrentTime(FTimespan Time, float Rate)
+{
+	const int64 Clock = FVlc::Clock();
+
+	FScopeLock Lock(&CurrentTimeCriticalSection);
+	{
+		CurrentClock = Clock;
+		CurrentRate = Rate;
+		CurrentTime = Time;
+	}
+}
+
+
+void FVlcMediaCallbacks::SetLoopDuration(FTimespan Duration)
+{
+	FScopeLock Lock(&CurrentTimeCriticalSection);
+	LoopDuration = Duration;
+}
+
+
 void FVlcMediaCallbacks::Shutdown()
 {
 	if (Player == nullptr)
@@ -109,14 +320,210 @@ void FVlcMediaCallbacks::Shutdown()
 	FVlc::AudioSetCallbacks(Player, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
 	FVlc::AudioSetFormatCallbacks(Player, nullptr, nullptr);
 
-	FVlc::VideoSetCallbacks(Player, nullptr, nullptr, nullptr, nullptr);
-	FVlc::VideoSetFormatCallbacks(Player, nullptr, nullptr);
+	if (!AudioOnly)
+	{
+		FVlc::VideoSetCallbacks(Player, nullptr, nullptr, nullptr, nullptr);
+		FVlc::VideoSetFormatCallbacks(Player, nullptr, nullptr);
+	}
 
-	AudioSamplePool->Reset();
 	VideoSamplePool->Reset();
 
-	CurrentTime = FTimespan::Zero();
+	SetCurrentTime(FTimespan::Zero(), 0.0f);
+	SetLoopDuration(FTimespan::Zero());
+	AudioDrained.Reset();
+	AudioSeekStartCycles.Reset();
 	Player = nullptr;
+	VideoSeekStartCycles.Reset();
+	VideoPreviousHashValid = false;
+	VideoPreviousSample.Reset();
+}
+
+
+/* FVlcMediaOutput implementation
+*****************************************************************************/
+
+FTimespan FVlcMediaCallbacks::ClockToTime(int64 Timestamp) const
+{
+	FScopeLock Lock(&CurrentTimeCriticalSection);
+
+	const FTimespan Time = CurrentTime + FTimespan::FromMicroseconds((Timestamp - CurrentClock) * CurrentRate);
+
+	// samples past the end belong to the next loop iteration
+	if ((LoopDuration > FTimespan::Zero()) && (Time >= LoopDuration))
+	{
+		return Time % LoopDuration;
+	}
+
+	return Time;
+}
+
+
+void* FVlcMediaCallbacks::AcquireVideoScratchBuffer(FThreadSafeCounter& ReasonCounter)
+{
+	ReasonCounter.Increment();
+
+	FScopeLock Lock(&VideoScratchCriticalSection);
+
+	if (VideoScratchFreeBuffers.Num() > 0)
+	{
+		return VideoScratchFreeBuffers.Pop(false);
+	}
+
+	// the decoder may write several frames into the discard buffer at once, which is fine, because they are never read
+	if (VideoScratchDiscardBuffer == nullptr)
+	{
+		UE_LOG(LogVlcMedia, Warning, TEXT("Callbacks %llx: No video scratch buffer available"), this);
+		return nullptr;
+	}
+
+	VideoScratchSharedFrames.Increment();
+
+	return VideoScratchDiscardBuffer;
+}
+
+
+void FVlcMediaCallbacks::AllocateVideoScratchBuffers(SIZE_T BufferSize)
+{
+	if (BufferSize == VideoScratchBufferSize)
+	{
+		return;
+	}
+
+	FreeVideoScratchBuffers();
+
+	if (BufferSize == 0)
+	{
+		return;
+	}
+
+	FScopeLock Lock(&VideoScratchCriticalSection);
+
+	for (int32 Index = 0; Index < NumVideoScratchBuffers; ++Index)
+	{
+		VideoScratchBuffers[Index] = FMemory::Malloc(BufferSize, 32);
+		VideoScratchFreeBuffers.Add(VideoScratchBuffers[Index]);
+	}
+
+	VideoScratchBufferSize = BufferSize;
+	VideoScratchDiscardBuffer = FMemory::Malloc(BufferSize, 32);
+}
+
+
+void FVlcMediaCallbacks::FreeVideoScratchBuffers()
+{
+	FScopeLock Lock(&VideoScratchCriticalSection);
+
+	for (int32 Index = 0; Index < NumVideoScratchBuffers; ++Index)
+	{
+		if (VideoScratchBuffers[Index] != nullptr)
+		{
+			FMemory::Free(VideoScratchBuffers[Index]);
+			VideoScratchBuffers[Index] = nullptr;
+		}
+	}
+
+	if (VideoScratchDiscardBuffer != nullptr)
+	{
+		FMemory::Free(VideoScratchDiscardBuffer);
+		VideoScratchDiscardBuffer = nullptr;
+	}
+
+	VideoScratchBufferSize = 0;
+	VideoScratchFreeBuffers.Reset();
+}
+
+
+uint64 FVlcMediaCallbacks::HashVideoSample(const FVlcMediaTextureSample& Sample) const
+{
+	void* Planes[FVlcMediaPlaneLayout::MaxPlanes];
+	Sample.GetMutablePlanes(Planes);
+
+	VlcMedia::FHashRegion Regions[FVlcMediaPlaneLayout::MaxPlanes];
+
+	for (uint32 PlaneIndex = 0; PlaneIndex < VideoSampleLayout.NumPlanes; ++PlaneIndex)
+	{
+		Regions[PlaneIndex].Data = (const uint8*)Planes[PlaneIndex];
+		Regions[PlaneIndex].Pitch = VideoSampleLayout.Pitches[PlaneIndex];
+		Regions[PlaneIndex].RowBytes = VideoVisibleRowBytes[PlaneIndex];
+		Regions[PlaneIndex].NumRows = VideoVisibleLines[PlaneIndex];
+	}
+
+	return VlcMedia::HashImage(Regions, VideoSampleLayout.NumPlanes);
+}
+
+
+void FVlcMediaCallbacks::ReleaseVideoReservation(FVlcMediaTextureSample& Sample)
+{
+	const SIZE_T ReservedSize = Sample.TakeReservation();
+
+	if (ReservedSize > 0)
+	{
+		Samples->ReleaseVideoReservation(ReservedSize);
+	}
+}
+
+
+void FVlcMediaCallbacks::ReleaseVideoScratchBuffer(void* Buffer)
+{
+	if (Buffer == nullptr)
+	{
+		return;
+	}
+
+	FScopeLock Lock(&VideoScratchCriticalSection);
+
+	for (int32 Index = 0; Index < NumVideoScratchBuffers; ++Index)
+	{
+		if ((VideoScratchBuffers[Index] == Buffer) && !VideoScratchFreeBuffers.Contains(Buffer))
+		{
+			VideoScratchFreeBuffers.Add(Buffer);
+			break;
+		}
+	}
+}
+
+
+bool FVlcMediaCallbacks::SetupVideoConversion(ANSICHAR* Chroma)
+{
+	if (FMemory::Memcmp(Chroma, "NV12", 4) == 0)
+	{
+		VideoConversion = VlcMedia::EChromaConversion::Nv12ToBgra;
+	}
+	else if (FMemory::Memcmp(Chroma, "I420", 4) == 0)
+	{
+		VideoConversion = VlcMedia::EChromaConversion::I420ToBgra;
+	}
+	else if (FMemory::Memcmp(Chroma, "P010", 4) == 0)
+	{
+		VideoConversion = VlcMedia::EChromaConversion::P010ToRgbaHalf;
+	}
+	else
+	{
+		FLibvlcChromaDescription* ChromaDescr = FVlc::FourccGetChromaDescription(*(FLibvlcFourcc*)Chroma);
+
+		if ((ChromaDescr == nullptr) || !VlcMediaCallbacks::IsChroma420(*ChromaDescr))
+		{
+			return false;
+		}
+
+		// other 4:2:0 formats are repacked by VLC, which is cheap compared to RGB conversion
+		if (ChromaDescr->PixelBits > 8)
+		{
+			FMemory::Memcpy(Chroma, "P010", 4);
+			VideoConversion = VlcMedia::EChromaConversion::P010ToRgbaHalf;
+		}
+		else
+		{
+			FMemory::Memcpy(Chroma, "I420", 4);
+			VideoConversion = VlcMedia::EChromaConversion::I420ToBgra;
+		}
+	}
+
+	VideoSampleFormat = (VideoConversion == VlcMedia::EChromaConversion::P010ToRgbaHalf)
+		? EMediaTextureSampleFormat::FloatRGBA
+		: EMediaTextureSampleFormat::CharBGRA;
+
+	return true;
 }
 
 
@@ -126,18 +533,47 @@ void FVlcMediaCallbacks::Shutdown()
 void FVlcMediaCallbacks::StaticAudioCleanupCallback(void* Opaque)
 {
 	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticAudioCleanupCallback"), Opaque);
+
+	auto Callbacks = (FVlcMediaCallbacks*)Opaque;
+
+	if (Callbacks != nullptr)
+	{
+		Callbacks->AudioOutputOpen.Set(0);
+	}
 }
 
 
 void FVlcMediaCallbacks::StaticAudioDrainCallback(void* Opaque)
 {
+	auto Callbacks = (FVlcMediaCallbacks*)Opaque;
+
+	if (Callbacks == nullptr)
+	{
+		return;
+	}
+
 	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticAudioDrainCallback"), Opaque);
+
+	// output the remaining frames; no more frames will follow for this track
+	Callbacks->Samples->DrainAudio();
+	Callbacks->AudioDrained.Set(1);
 }
 
 
 void FVlcMediaCallbacks::StaticAudioFlushCallback(void* Opaque, int64 Timestamp)
 {
-	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticAudioFlushCallback"), Opaque);
+	auto Callbacks = (FVlcMediaCallbacks*)Opaque;
+
+	if (Callbacks == nullptr)
+	{
+		return;
+	}
+
+	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticAudioFlushCallback (Timestamp = %i)"), Opaque, Timestamp);
+
+	// discard frames that were queued before the flush, i.e. prior to a seek
+	Callbacks->Samples->DiscardAudio();
+	Callbacks->AudioFlushCycles.Set((int64)FPlatformTime::Cycles64());
 }
 
 
@@ -165,25 +601,29 @@ void FVlcMediaCallbacks::StaticAudioPlayCallback(void* Opaque, void* Samples, ui
 		Callbacks->Samples->NumAudio()
 	);
 
-	// create & add sample to queue
-	auto AudioSample = Callbacks->AudioSamplePool->AcquireShared();
+	// measure seek latency on first frames after the seek's flush
+	const int64 SeekStartCycles = Callbacks->AudioSeekStartCycles.GetValue();
+
+	if ((SeekStartCycles != 0) && (Callbacks->AudioFlushCycles.GetValue() >= SeekStartCycles))
+	{
+		const int64 Latency = (int64)(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - SeekStartCycles) * 1000.0);
 
-	const FTimespan Delay = FTimespan::FromMicroseconds(FVlc::Delay(Timestamp));
-	const FTimespan Duration = FTimespan::FromMicroseconds((Count * 1000000) / Callbacks->AudioSampleRate);
-	const SIZE_T SamplesSize = Count * Callbacks->AudioSampleSize * Callbacks->AudioChannels;
+		Callbacks->AudioSeekCount.Increment();
+		Callbacks->AudioSeekLatency.Set(Latency);
+		Callbacks->AudioSeekLatencyTotal.Add(Latency);
+		Callbacks->AudioSeekOutputCycles.Set((int64)FPlatformTime::Cycles64());
+		Callbacks->AudioSeekStartCycles.Set(0);
+	}
 
-	if (AudioSample->Initialize(
-		Samples,
-		SamplesSize,
-		Count,
-		Callbacks->AudioChannels,
-		Callbacks->AudioSampleFormat,
-		Callbacks->AudioSampleRate,
-		Callbacks->CurrentTime + Delay,
-		Duration))
+	Callbacks->AudioDrained.Set(0);
+
+	if (Callbacks->FirstSampleCycles.GetValue() == 0)
 	{
-		Callbacks->Samples->AddAudio(AudioSample);
+		Callbacks->FirstSampleCycles.Set((int64)FPlatformTime::Cycles64());
 	}
+
+	// copy frames into queue
+	Callbacks->Samples->AddAudio(Samples, Count, Callbacks->ClockToTime(Timestamp));
 }
 
 
@@ -211,62 +651,43 @@ int FVlcMediaCallbacks::StaticAudioSetupCallback(void** Opaque, ANSICHAR* Format
 		*Channels
 	);
 
-	// setup audio format
-	if (*Channels > 8)
-	{
-		*Channels = 8;
-	}
+	// request 32-bit float at the source's sample rate and channel layout,
+	// so that VLC only converts the sample format (and resamples if configured)
+	FMemory::Memcpy(Format, "FL32", 4);
 
-	if (FMemory::Memcmp(Format, "S8  ", 4) == 0)
+	if (*Channels > MaxAudioChannels)
 	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int8;
-		Callbacks->AudioSampleSize = 1;
+		*Channels = MaxAudioChannels;
 	}
-	else if (FMemory::Memcmp(Format, "S16N", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int16;
-		Callbacks->AudioSampleSize = 2;
-	}
-	else if (FMemory::Memcmp(Format, "S32N", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int32;
-		Callbacks->AudioSampleSize = 4;
-	}
-	else if (FMemory::Memcmp(Format, "FL32", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Float;
-		Callbacks->AudioSampleSize = 4;
-	}
-	else if (FMemory::Memcmp(Format, "FL64", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Double;
-		Callbacks->AudioSampleSize = 8;
-	}
-	else if (FMemory::Memcmp(Format, "U8  ", 4) == 0)
-	{
-		// unsigned integer fall back
-		FMemory::Memcpy(Format, "S8  ", 4);
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int8;
-		Callbacks->AudioSampleSize = 1;
-	}
-	else
+
+	if (Callbacks->AudioOutputSampleRate > 0)
 	{
-		// unsupported format fall back
-		FMemory::Memcpy(Format, "S16N", 4);
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int16;
-		Callbacks->AudioSampleSize = 2;
+		*Rate = Callbacks->AudioOutputSampleRate;
 	}
 
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Callbacks %llx: Audio output format FL32, %i Hz, %i channel(s)"), Opaque, *Rate, *Channels);
+
+	Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Float;
+	Callbacks->AudioSampleSize = sizeof(float);
+
 	Callbacks->AudioChannels = *Channels;
 	Callbacks->AudioSampleRate = *Rate;
 
+	Callbacks->Samples->SetAudioFormat(Callbacks->AudioChannels, Callbacks->AudioSampleFormat, Callbacks->AudioSampleRate, (uint32)Callbacks->AudioSampleSize);
+	Callbacks->AudioOutputOpen.Set(1);
+
 	return 0;
 }
 
 
 void FVlcMediaCallbacks::StaticVideoCleanupCallback(void *Opaque)
 {
-	// do nothing
+	auto Callbacks = (FVlcMediaCallbacks*)Opaque;
+
+	if (Callbacks != nullptr)
+	{
+		Callbacks->FreeVideoScratchBuffers();
+	}
 }
 
 
@@ -280,15 +701,84 @@ void FVlcMediaCallbacks::StaticVideoDisplayCallback(void* Opaque, void* Picture)
 		return;
 	}
 
-	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticVideoDisplayCallback (CurrentTime = %s, Queue = %i)"),
-		Opaque, *Callbacks->CurrentTime.ToString(),
-		Callbacks->Samples->NumVideoSamples()
+	// VLC calls this when the picture's presentation time is reached
+	const FTimespan Time = Callbacks->ClockToTime(FVlc::Clock());
+
+	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticVideoDisplayCallback (Time = %s, Queue = %i)"),
+		Opaque,
+		*Time.ToString(),
+		Callbacks->Samples->NumVideo()
 	);
 
-	VideoSample->SetTime(Callbacks->CurrentTime);
+	VideoSample->SetTime(Time);
+
+	// VLC keeps displaying frames of the previous position until it processes the seek, which also
+	// flushes the audio output; without audio, frames are accepted right away after the timeout
+	const int64 SeekStartCycles = Callbacks->VideoSeekStartCycles.GetValue();
+
+	if (SeekStartCycles != 0)
+	{
+		const uint64 DisplayCycles = FPlatformTime::Cycles64();
+		const bool Flushed = (Callbacks->AudioOutputOpen.GetValue() == 0) || (Callbacks->AudioFlushCycles.GetValue() >= SeekStartCycles);
+
+		if (!Flushed && (FPlatformTime::ToMilliseconds64(DisplayCycles - SeekStartCycles) < SeekFlushTimeoutMilliseconds))
+		{
+			Callbacks->ReleaseVideoReservation(*VideoSample);
+			Callbacks->VideoSamplePool->Release(VideoSample);
+			Callbacks->VideoStaleFrames.Increment();
+
+			return;
+		}
+
+		Callbacks->VideoSeekOutputCycles.Set((int64)DisplayCycles);
+		Callbacks->VideoSeekStartCycles.Reset();
+	}
+
+	// extend previous sample instead of outputting an identical frame
+	if (Callbacks->VideoSkipIdenticalFrames)
+	{
+		// the previous frame must not have been discarded before it was output
+		const int32 Discards = Callbacks->Samples->GetDiscardedVideoFrames();
+
+		if (Callbacks->VideoPreviousHashValid &&
+			(Callbacks->VideoPreviousHash == VideoSample->GetHash()) &&
+			(Callbacks->VideoPreviousDiscards == Discards))
+		{
+			TSharedPtr<FVlcMediaTextureSample, ESPMode::ThreadSafe> PreviousSample = Callbacks->VideoPreviousSample.Pin();
+
+			if (PreviousSample.IsValid())
+			{
+				PreviousSample->ExtendDuration(Time + VideoSample->GetDuration());
+			}
+
+			Callbacks->ReleaseVideoReservation(*VideoSample);
+			Callbacks->VideoSamplePool->Release(VideoSample);
+			Callbacks->VideoIdenticalFrames.Increment();
+
+			return;
+		}
+
+		Callbacks->VideoPreviousDiscards = Discards;
+		Callbacks->VideoPreviousHash = VideoSample->GetHash();
+		Callbacks->VideoPreviousHashValid = true;
+		Callbacks->VideoUniqueFrames.Increment();
+	}
+
+	if (Callbacks->FirstSampleCycles.GetValue() == 0)
+	{
+		Callbacks->FirstSampleCycles.Set((int64)FPlatformTime::Cycles64());
+	}
 
 	// add sample to queue
-	Callbacks->Samples->AddVideo(Callbacks->VideoSamplePool->ToShared(VideoSample));
+	const TSharedRef<FVlcMediaTextureSample, ESPMode::ThreadSafe> SharedSample = Callbacks->VideoSamplePool->ToShared(VideoSample);
+
+	if (Callbacks->VideoSkipIdenticalFrames)
+	{
+		Callbacks->VideoPreviousSample = SharedSample;
+	}
+
+	Callbacks->ReleaseVideoReservation(*VideoSample);
+	Callbacks->Samples->AddVideo(SharedSample);
 }
 
 
@@ -299,26 +789,27 @@ void* FVlcMediaCallbacks::StaticVideoLockCallback(void* Opaque, void** Planes)
 
 	FMemory::Memzero(Planes, FVlc::MaxPlanes * sizeof(void*));
 
-	// skip if already processed
-	if (Callbacks->VideoPreviousTime == Callbacks->CurrentTime)
+	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticVideoLockCallback"), Opaque);
+
+	// make room in output queue before a pooled buffer is filled
+	const SIZE_T ReservedSize = (SIZE_T)Callbacks->VideoBufferStride * Callbacks->VideoBufferDim.Y;
+
+	if (!Callbacks->Samples->ReserveVideo(ReservedSize))
 	{
 		// VLC currently requires a valid buffer or it will crash
-		Planes[0] = FMemory::Malloc(Callbacks->VideoBufferStride * Callbacks->VideoBufferDim.Y, 32);
+		Callbacks->VideoPlaneLayout.GetPlanes(Callbacks->AcquireVideoScratchBuffer(Callbacks->VideoScratchQueueFrames), Planes);
 		return nullptr;
 	}
 
-	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticVideoLockCallback (CurrentTime = %s)"),
-		Opaque,
-		*Callbacks->CurrentTime.ToString()
-	);
-
 	// create & initialize video sample
-	auto VideoSample = Callbacks->VideoSamplePool->Acquire();
+	auto VideoSample = Callbacks->VideoSamplePool->Acquire(Callbacks->VideoSampleLayout.GetBufferSize());
 
 	if (VideoSample == nullptr)
 	{
+		Callbacks->Samples->ReleaseVideoReservation(ReservedSize);
+
 		// VLC currently requires a valid buffer or it will crash
-		Planes[0] = FMemory::Malloc(Callbacks->VideoBufferStride * Callbacks->VideoBufferDim.Y, 32);
+		Callbacks->VideoPlaneLayout.GetPlanes(Callbacks->AcquireVideoScratchBuffer(Callbacks->VideoScratchPoolFrames), Planes);
 		return nullptr;
 	}
 
@@ -327,15 +818,31 @@ void* FVlcMediaCallbacks::StaticVideoLockCallback(void* Opaque, void** Planes)
 		Callbacks->VideoOutputDim,
 		Callbacks->VideoSampleFormat,
 		Callbacks->VideoBufferStride,
+		Callbacks->VideoSampleLayout,
 		Callbacks->VideoFrameDuration))
 	{
+		Callbacks->VideoSamplePool->Release(VideoSample);
+		Callbacks->Samples->ReleaseVideoReservation(ReservedSize);
+
 		// VLC currently requires a valid buffer or it will crash
-		Planes[0] = FMemory::Malloc(Callbacks->VideoBufferStride * Callbacks->VideoBufferDim.Y, 32);
+		Callbacks->VideoPlaneLayout.GetPlanes(Callbacks->AcquireVideoScratchBuffer(Callbacks->VideoScratchFailedFrames), Planes);
 		return nullptr;
 	}
 
-	Callbacks->VideoPreviousTime = Callbacks->CurrentTime;
-	Planes[0] = VideoSample->GetMutableBuffer();
+	// released when the frame is unlocked or displayed, so that frames that VLC drops without displaying them don't keep it
+	VideoSample->SetReservation(ReservedSize);
+
+	if (Callbacks->VideoConversionEnabled)
+	{
+		// decode into the sample's staging buffer; the frame is converted when unlocked
+		VideoSample->ResizeStagingBuffer(Callbacks->VideoPlaneLayout.GetBufferSize());
+		Callbacks->VideoPlaneLayout.GetPlanes(VideoSample->GetMutableStagingBuffer(), Planes);
+	}
+	else
+	{
+		VideoSample->ResizeStagingBuffer(0);
+		VideoSample->GetMutablePlanes(Planes);
+	}
 
 	return VideoSample; // passed as Picture into unlock & display callbacks
 
@@ -358,6 +865,13 @@ unsigned FVlcMediaCallbacks::StaticVideoSetupCallback(void** Opaque, char* Chrom
 		*Height
 	);
 
+	// buffers of the previous format must not be used if this setup fails
+	Callbacks->FreeVideoScratchBuffers();
+	Callbacks->VideoPlaneLayout.Reset();
+
+	// frames of the previous format that are still being decoded won't be queued
+	Callbacks->Samples->ResetVideoReservations();
+
 	// get video output size
 	if (FVlc::VideoGetSize(Callbacks->Player, 0, (uint32*)&Callbacks->VideoOutputDim.X, (uint32*)&Callbacks->VideoOutputDim.Y) != 0)
 	{
@@ -373,10 +887,39 @@ unsigned FVlcMediaCallbacks::StaticVideoSetupCallback(void** Opaque, char* Chrom
 		return 0;
 	}
 
+	// let VLC's scaler shrink frames that exceed the requested maximum size
+	if ((Callbacks->VideoMaxOutputDim > 0) && (Callbacks->VideoOutputDim.GetMax() > Callbacks->VideoMaxOutputDim))
+	{
+		const float Scale = (float)Callbacks->VideoMaxOutputDim / Callbacks->VideoOutputDim.GetMax();
+
+		// even dimensions keep chroma subsampled formats intact
+		auto ScaleAxis = [Scale](int32 Size)
+		{
+			return FMath::Max(2, FMath::RoundToInt(Size * Scale) & ~1);
+		};
+
+		UE_LOG(LogVlcMedia, Verbose, TEXT("Callbacks %llx: Scaling video from %ix%i to at most %i pixels"),
+			Opaque,
+			Callbacks->VideoOutputDim.X,
+			Callbacks->VideoOutputDim.Y,
+			Callbacks->VideoMaxOutputDim
+		);
+
+		Callbacks->VideoOutputDim = FIntPoint(ScaleAxis(Callbacks->VideoOutputDim.X), ScaleAxis(Callbacks->VideoOutputDim.Y));
+
+		*Width = Callbacks->VideoOutputDim.X;
+		*Height = Callbacks->VideoOutputDim.Y;
+	}
+
 	// determine decoder & sample formats
 	Callbacks->VideoBufferDim = FIntPoint(*Width, *Height);
+	Callbacks->VideoConversionEnabled = Callbacks->VideoConvertToRgb && Callbacks->SetupVideoConversion(Chroma);
 
-	if (FCStringAnsi::Stricmp(Chroma, "AYUV") == 0)
+	if (Callbacks->VideoConversionEnabled)
+	{
+		// 4:2:0 frames are converted to RGB by the plug-in
+	}
+	else if (FCStringAnsi::Stricmp(Chroma, "AYUV") == 0)
 	{
 		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharAYUV;
 		Callbacks->VideoBufferStride = *Width * 4;
@@ -406,17 +949,33 @@ unsigned FVlcMediaCallbacks::StaticVideoSetupCallback(void** Opaque, char* Chrom
 		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharYVYU;
 		Callbacks->VideoBufferStride = *Width * 2;
 	}
+	else if (FCStringAnsi::Stricmp(Chroma, "NV12") == 0)
+	{
+		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharNV12;
+	}
+	else if (FCStringAnsi::Stricmp(Chroma, "NV21") == 0)
+	{
+		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharNV21;
+	}
 	else
 	{
 		// reconfigure output for natively supported format
 		FLibvlcChromaDescription* ChromaDescr = FVlc::FourccGetChromaDescription(*(FLibvlcFourcc*)Chroma);
 
-		if (ChromaDescr->PlaneCount == 0)
+		if ((ChromaDescr == nullptr) || (ChromaDescr->PlaneCount == 0))
 		{
 			return 0;
 		}
 
-		if (ChromaDescr->PlaneCount > 1)
+		if (VlcMediaCallbacks::IsChroma420(*ChromaDescr))
+		{
+			// 4:2:0 formats (I420, YV12, P010, etc.) only need their chroma planes interleaved;
+			// the engine has no 10-bit sample format, so high bit depths are reduced to 8 bits
+			FMemory::Memcpy(Chroma, "NV12", 4);
+
+			Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharNV12;
+		}
+		else if (ChromaDescr->PlaneCount > 1)
 		{
 			FMemory::Memcpy(Chroma, "YUY2", 4);
 
@@ -435,12 +994,103 @@ unsigned FVlcMediaCallbacks::StaticVideoSetupCallback(void** Opaque, char* Chrom
 		}
 	}
 
+	// determine plane layouts
+	FVlcMediaPlaneLayout& Layout = Callbacks->VideoPlaneLayout;
+
+	if (Callbacks->VideoConversionEnabled)
+	{
+		// decoder planes (chroma planes of I420 need 16 byte aligned rows, too)
+		const uint32 AlignedWidth = Align(*Width, 32);
+		const uint32 AlignedHeight = Align(*Height, 16);
+
+		if (Callbacks->VideoConversion == VlcMedia::EChromaConversion::I420ToBgra)
+		{
+			Layout.AddPlane(AlignedWidth, AlignedHeight);
+			Layout.AddPlane(AlignedWidth / 2, AlignedHeight / 2);
+			Layout.AddPlane(AlignedWidth / 2, AlignedHeight / 2);
+		}
+		else
+		{
+			const uint32 BytesPerSample = (Callbacks->VideoConversion == VlcMedia::EChromaConversion::P010ToRgbaHalf) ? 2 : 1;
+
+			Layout.AddPlane(AlignedWidth * BytesPerSample, AlignedHeight);
+			Layout.AddPlane(AlignedWidth * BytesPerSample, AlignedHeight / 2);
+		}
+
+		// converted sample
+		Callbacks->VideoBufferDim = FIntPoint(*Width, *Height);
+		Callbacks->VideoBufferStride = *Width * VlcMedia::GetChromaDestBytesPerPixel(Callbacks->VideoConversion);
+	}
+	else if ((Callbacks->VideoSampleFormat == EMediaTextureSampleFormat::CharNV12) ||
+		(Callbacks->VideoSampleFormat == EMediaTextureSampleFormat::CharNV21))
+	{
+		// luma plane followed by interleaved chroma plane at half height
+		const uint32 AlignedWidth = Align(*Width, 16);
+		const uint32 AlignedHeight = Align(*Height, 16);
+
+		Layout.AddPlane(AlignedWidth, AlignedHeight);
+		Layout.AddPlane(AlignedWidth, AlignedHeight / 2);
+
+		Callbacks->VideoBufferDim = FIntPoint(AlignedWidth, AlignedHeight * 3 / 2);
+		Callbacks->VideoBufferStride = AlignedWidth;
+	}
+	else
+	{
+		Layout.AddPlane(Callbacks->VideoBufferStride, Callbacks->VideoBufferDim.Y);
+	}
+
+	if (Callbacks->VideoConversionEnabled)
+	{
+		Callbacks->VideoSampleLayout.Reset();
+		Callbacks->VideoSampleLayout.AddPlane(Callbacks->VideoBufferStride, Callbacks->VideoBufferDim.Y);
+	}
+	else
+	{
+		Callbacks->VideoSampleLayout = Layout;
+	}
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Callbacks %llx: Video output format %s, %i plane(s), %llu bytes per frame, conversion %s"),
+		Opaque,
+		ANSI_TO_TCHAR(Chroma),
+		Layout.NumPlanes,
+		(uint64)Layout.GetBufferSize(),
+		Callbacks->VideoConversionEnabled ? VlcMedia::ChromaConversionToString(Callbacks->VideoConversion) : TEXT("none")
+	);
+
 	// get other video properties
 	Callbacks->VideoFrameDuration = FTimespan::FromSeconds(1.0 / FVlc::MediaPlayerGetFps(Callbacks->Player));
 
 	// initialize decoder
-	Lines[0] = Callbacks->VideoBufferDim.Y;
-	Pitches[0] = Callbacks->VideoBufferStride;
+	for (uint32 PlaneIndex = 0; PlaneIndex < Layout.NumPlanes; ++PlaneIndex)
+	{
+		Lines[PlaneIndex] = Layout.Lines[PlaneIndex];
+		Pitches[PlaneIndex] = Layout.Pitches[PlaneIndex];
+	}
+
+	// allocate buffers for frames that won't be output
+	Callbacks->AllocateVideoScratchBuffers(Layout.GetBufferSize());
+
+	// determine the part of each sample plane that the decoder writes
+	const FVlcMediaPlaneLayout& SampleLayout = Callbacks->VideoSampleLayout;
+
+	const uint32 VisibleRowBytes = Callbacks->VideoConversionEnabled
+		? SampleLayout.Pitches[0]
+		: FMath::Min(SampleLayout.Pitches[0], (uint32)Callbacks->VideoOutputDim.X * VlcMediaCallbacks::GetBytesPerPixel(Callbacks->VideoSampleFormat));
+
+	const uint32 VisibleLines = Callbacks->VideoConversionEnabled
+		? SampleLayout.Lines[0]
+		: FMath::Min(SampleLayout.Lines[0], (uint32)Callbacks->VideoOutputDim.Y);
+
+	for (uint32 PlaneIndex = 0; PlaneIndex < SampleLayout.NumPlanes; ++PlaneIndex)
+	{
+		Callbacks->VideoVisibleRowBytes[PlaneIndex] = FMath::Min(SampleLayout.Pitches[PlaneIndex], FMath::DivideAndRoundUp(VisibleRowBytes * SampleLayout.Pitches[PlaneIndex], SampleLayout.Pitches[0]));
+		Callbacks->VideoVisibleLines[PlaneIndex] = FMath::Min(SampleLayout.Lines[PlaneIndex], FMath::DivideAndRoundUp(VisibleLines * SampleLayout.Lines[PlaneIndex], SampleLayout.Lines[0]));
+	}
+
+	Callbacks->VideoPreviousHashValid = false;
+
+	// preallocate samples for the new format (releases buffers of previous formats)
+	Callbacks->VideoSamplePool->Prewarm(NumPrewarmedVideoSamples, Callbacks->VideoSampleLayout.GetBufferSize());
 
 	return 1;
 }
@@ -448,14 +1098,54 @@ unsigned FVlcMediaCallbacks::StaticVideoSetupCallback(void** Opaque, char* Chrom
 
 void FVlcMediaCallbacks::StaticVideoUnlockCallback(void* Opaque, void* Picture, void* const* Planes)
 {
-	if ((Opaque != nullptr) && (Picture != nullptr))
+	auto Callbacks = (FVlcMediaCallbacks*)Opaque;
+	auto VideoSample = (FVlcMediaTextureSample*)Picture;
+
+	if (Callbacks == nullptr)
 	{
-		UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticVideoUnlockCallback"), Opaque);
+		return;
 	}
 
-	// discard temporary buffer for VLC crash workaround
-	if ((Picture == nullptr) && (Planes != nullptr) && (Planes[0] != nullptr))
+	// frames that are not output were written into a scratch buffer, which can be reused now
+	if (VideoSample == nullptr)
 	{
-		FMemory::Free(Planes[0]);
+		Callbacks->ReleaseVideoScratchBuffer((Planes != nullptr) ? Planes[0] : nullptr);
+		return;
 	}
+
+	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Callbacks %llx: StaticVideoUnlockCallback"), Opaque);
+
+	if (Callbacks->VideoConversionEnabled)
+	{
+		// convert the sample's staging buffer into its frame buffer
+		const double StartTime = FPlatformTime::Seconds();
+
+		VlcMedia::FChromaPlanes Source;
+
+		for (int32 PlaneIndex = 0; PlaneIndex < 3; ++PlaneIndex)
+		{
+			Source.Planes[PlaneIndex] = (const uint8*)Planes[PlaneIndex];
+			Source.Pitches[PlaneIndex] = Callbacks->VideoPlaneLayout.Pitches[PlaneIndex];
+		}
+
+		VlcMedia::ConvertChroma(
+			Callbacks->VideoConversion,
+			Source,
+			Callbacks->VideoBufferDim,
+			(uint8*)VideoSample->GetMutableBuffer(),
+			Callbacks->VideoBufferStride
+		);
+
+		Callbacks->VideoConversionTime.Add((int64)((FPlatformTime::Seconds() - StartTime) * 1000000.0));
+		Callbacks->VideoConvertedFrames.Increment();
+	}
+
+	// hash the final frame, so that the display callback can detect duplicates
+	if (Callbacks->VideoSkipIdenticalFrames)
+	{
+		VideoSample->SetHash(Callbacks->HashVideoSample(*VideoSample));
+	}
+
+	// the frame was decoded; VLC drops late frames without displaying them
+	Callbacks->ReleaseVideoReservation(*VideoSample);
 }
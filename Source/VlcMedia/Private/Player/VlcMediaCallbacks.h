@@ -3,11 +3,18 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
 #include "IMediaAudioSample.h"
 #include "IMediaTextureSample.h"
+#include "IMediaTracks.h"
 
-class FMediaSamples;
-class FVlcMediaAudioSamplePool;
+#include "VlcMediaChroma.h"
+#include "VlcMediaTextureSample.h"
+
+class FVlcMediaLoopCache;
+class FVlcMediaSamples;
 class FVlcMediaTextureSamplePool;
 class IMediaOptions;
 class IMediaAudioSink;
@@ -33,6 +40,42 @@ public:
 
 public:
 
+	/** Maximum number of audio channels to request from VLC. */
+	static const uint32 MaxAudioChannels = 8;
+
+public:
+
+	/**
+	 * Apply the media options of the media source being opened.
+	 *
+	 * @param Options The media options (may be nullptr).
+	 */
+	void ApplyOptions(const IMediaOptions* Options);
+
+	/**
+	 * Fade out the audio of another player's callbacks while fading in this one's.
+	 *
+	 * @param FadeOut The callbacks of the player that is fading out (must stay alive until EndCrossfade).
+	 * @param Duration Duration of the crossfade.
+	 * @see EndCrossfade
+	 */
+	void BeginCrossfade(FVlcMediaCallbacks& FadeOut, FTimespan Duration);
+
+	/**
+	 * Stop mixing the audio of the player that faded out.
+	 *
+	 * @see BeginCrossfade
+	 */
+	void EndCrossfade();
+
+	/**
+	 * Get the cache of decoded samples for short looping media.
+	 *
+	 * @return The loop cache.
+	 * @see ApplyOptions
+	 */
+	FVlcMediaLoopCache& GetLoopCache();
+
 	/**
 	 * Get the output media samples.
 	 *
@@ -40,6 +83,46 @@ public:
 	 */
 	IMediaSamples& GetSamples();
 
+	/**
+	 * Get the cycle counter at which the first audio or video sample was output.
+	 *
+	 * @return Cycle counter, or 0 if no sample was output since the callbacks were created.
+	 */
+	uint64 GetFirstSampleCycles() const
+	{
+		return (uint64)FirstSampleCycles.GetValue();
+	}
+
+	/**
+	 * Get a string with statistics for the video and audio output.
+	 *
+	 * @return Statistics string.
+	 */
+	FString GetStats() const;
+
+	/**
+	 * Get the cycle counter at which the first sample after the most recent seek was output.
+	 *
+	 * @param TrackType The type of samples (Audio or Video).
+	 * @return Cycle counter, or 0 if no sample was output since the seek.
+	 * @see NotifySeek
+	 */
+	uint64 GetSeekOutputCycles(EMediaTrackType TrackType) const
+	{
+		return (uint64)((TrackType == EMediaTrackType::Video) ? VideoSeekOutputCycles : AudioSeekOutputCycles).GetValue();
+	}
+
+	/**
+	 * Check whether video output is disabled.
+	 *
+	 * @return true if only audio is decoded, false otherwise.
+	 * @see ApplyOptions
+	 */
+	bool IsAudioOnly() const
+	{
+		return AudioOnly;
+	}
+
 	/**
 	 * Initialize the handler for the specified media player.
 	 *
@@ -47,15 +130,39 @@ public:
 	 */
 	void Initialize(FLibvlcMediaPlayer& InPlayer);
 
+	/**
+	 * Notify the handler that the player is seeking.
+	 *
+	 * This starts measuring the time until audio and video of the new position are output.
+	 * Video frames that VLC displays before it processes the seek are discarded.
+	 *
+	 * @see GetSeekOutputCycles
+	 */
+	void NotifySeek();
+
 	/**
 	 * Set the player's current time.
 	 *
+	 * The time is anchored to the VLC clock, so that presentation timestamps
+	 * of audio and video can be mapped to play times between calls.
+	 *
 	 * @param Time The player's play time.
+	 * @param Rate The player's play rate.
+	 * @see ClockToTime
 	 */
-	void SetCurrentTime(FTimespan Time)
-	{
-		CurrentTime = Time;
-	}
+	void SetCurrentTime(FTimespan Time, float Rate);
+
+	/**
+	 * Set the duration after which the play time wraps around.
+	 *
+	 * While VLC repeats the input, samples of the next iteration are output
+	 * before the player's clock reaches the end of the current one. Their
+	 * times are wrapped around, so they are queued at the loop start.
+	 *
+	 * @param Duration The duration of the media (0 = not looping).
+	 * @see ClockToTime
+	 */
+	void SetLoopDuration(FTimespan Duration);
 
 	/** Shut down the callback handler. */
 	void Shutdown();
@@ -98,31 +205,158 @@ private:
 	/** Handles buffer unlock callbacks from VLC. */
 	static void StaticVideoUnlockCallback(void* Opaque, void* Picture, void* const* Planes);
 
+private:
+
+	/**
+	 * Take a free video scratch buffer.
+	 *
+	 * Scratch buffers are handed to VLC for frames that are decoded, but not
+	 * output, because VLC requires a valid buffer for every picture it locks.
+	 * They return to the free list when VLC unlocks the picture. If all of
+	 * them are locked, the discard buffer is shared by the remaining pictures.
+	 *
+	 * @param ReasonCounter The statistics counter to increment.
+	 * @return The scratch buffer, or nullptr if the setup callback did not allocate any.
+	 * @see AllocateVideoScratchBuffers, ReleaseVideoScratchBuffer
+	 */
+	void* AcquireVideoScratchBuffer(FThreadSafeCounter& ReasonCounter);
+
+	/**
+	 * Allocate the video scratch buffers (VLC setup callback only).
+	 *
+	 * @param BufferSize The size of each buffer (in bytes).
+	 * @see AcquireVideoScratchBuffer, FreeVideoScratchBuffers
+	 */
+	void AllocateVideoScratchBuffers(SIZE_T BufferSize);
+
+	/**
+	 * Map a VLC clock timestamp to the player's play time.
+	 *
+	 * @param Timestamp The VLC clock timestamp (in microseconds).
+	 * @return The corresponding play time.
+	 * @see SetCurrentTime
+	 */
+	FTimespan ClockToTime(int64 Timestamp) const;
+
+	/**
+	 * Free the video scratch buffers.
+	 *
+	 * @see AcquireVideoScratchBuffer, AllocateVideoScratchBuffers
+	 */
+	void FreeVideoScratchBuffers();
+
+	/**
+	 * Calculate a hash of the visible part of a video sample's planes.
+	 *
+	 * @param Sample The sample to hash.
+	 * @return The hash value.
+	 */
+	uint64 HashVideoSample(const FVlcMediaTextureSample& Sample) const;
+
+	/**
+	 * Release the output queue reservation of a video sample's frame, if it was not released yet.
+	 *
+	 * @param Sample The sample whose reservation to release.
+	 */
+	void ReleaseVideoReservation(FVlcMediaTextureSample& Sample);
+
+	/**
+	 * Return a video scratch buffer to the free list once VLC unlocked its picture.
+	 *
+	 * Buffers that are not on the list, such as the discard buffer or buffers
+	 * of a previous frame format, are ignored.
+	 *
+	 * @param Buffer The buffer to return.
+	 * @see AcquireVideoScratchBuffer
+	 */
+	void ReleaseVideoScratchBuffer(void* Buffer);
+
+	/**
+	 * Configure the plug-in's chroma conversion for the specified decoder format.
+	 *
+	 * @param Chroma The decoder's chroma (may be replaced with the format to be converted).
+	 * @return true if the frames will be converted, false if the format is not supported.
+	 */
+	bool SetupVideoConversion(ANSICHAR* Chroma);
+
+private:
+
+	/** Number of video samples to preallocate when the video format changes. */
+	static const int32 NumPrewarmedVideoSamples = 4;
+
+	/** Number of video scratch buffers. */
+	static const int32 NumVideoScratchBuffers = 4;
+
+	/** Maximum time to discard video frames while waiting for VLC to process a seek (in milliseconds). */
+	static const uint32 SeekFlushTimeoutMilliseconds = 1000;
+
 private:
 
 	/** Current number of channels in audio samples( accessed by VLC thread only). */
 	uint32 AudioChannels;
 
+	/** Whether the audio track was drained (1) or is playing (0). */
+	FThreadSafeCounter AudioDrained;
+
+	/** Cycle counter when audio was last flushed. */
+	FThreadSafeCounter64 AudioFlushCycles;
+
+	/** Whether video output is disabled (set from media options). */
+	bool AudioOnly;
+
+	/** Whether the audio output is set up (1) or not (0). */
+	FThreadSafeCounter AudioOutputOpen;
+
+	/** Sample rate to request from VLC (in Hz; 0 = source sample rate). */
+	uint32 AudioOutputSampleRate;
+
 	/** Current audio sample format (accessed by VLC thread only). */
 	EMediaAudioSampleFormat AudioSampleFormat;
 
-	/** Audio sample object pool. */
-	FVlcMediaAudioSamplePool* AudioSamplePool;
-
 	/** Current audio sample rate (accessed by VLC thread only). */
 	uint32 AudioSampleRate;
 
 	/** Size of a single audio sample (in bytes). */
 	SIZE_T AudioSampleSize;
 
+	/** Number of seeks for which the audio latency was measured. */
+	FThreadSafeCounter AudioSeekCount;
+
+	/** Time from the most recent seek request to the first audio of the new position (in microseconds). */
+	FThreadSafeCounter64 AudioSeekLatency;
+
+	/** Total measured seek latency (in microseconds). */
+	FThreadSafeCounter64 AudioSeekLatencyTotal;
+
+	/** Cycle counter at which the first audio after the most recent seek was output (0 = none yet). */
+	FThreadSafeCounter64 AudioSeekOutputCycles;
+
+	/** Cycle counter when the pending seek was requested (0 = no seek pending). */
+	FThreadSafeCounter64 AudioSeekStartCycles;
+
+	/** VLC clock timestamp at which CurrentTime was set (in microseconds). */
+	int64 CurrentClock;
+
+	/** The player's play rate at the time CurrentTime was set. */
+	float CurrentRate;
+
 	/** The player's current time. */
 	FTimespan CurrentTime;
 
+	/** Cycle counter at which the first sample was output (0 = none yet). */
+	FThreadSafeCounter64 FirstSampleCycles;
+
+	/** Critical section for synchronizing access to CurrentClock, CurrentRate, CurrentTime & LoopDuration. */
+	mutable FCriticalSection CurrentTimeCriticalSection;
+
+	/** Duration after which sample times wrap around (0 = not looping). */
+	FTimespan LoopDuration;
+
 	/** The VLC media player object. */
 	FLibvlcMediaPlayer* Player;
 
 	/** The output media samples. */
-	FMediaSamples* Samples;
+	FVlcMediaSamples* Samples;
 
 	/** Current video buffer dimensions (accessed by VLC thread only; may be larger than VideoOutputDim). */
 	FIntPoint VideoBufferDim;
@@ -130,18 +364,102 @@ private:
 	/** Number of bytes per row of video pixels. */
 	uint32 VideoBufferStride;
 
+	/** Current chroma conversion (accessed by VLC thread only; valid if VideoConversionEnabled is set). */
+	VlcMedia::EChromaConversion VideoConversion;
+
+	/** Whether frames are currently converted by the plug-in. */
+	bool VideoConversionEnabled;
+
+	/** Total time spent converting frames (in microseconds). */
+	FThreadSafeCounter64 VideoConversionTime;
+
+	/** Number of frames converted by the plug-in. */
+	FThreadSafeCounter VideoConvertedFrames;
+
+	/** Whether video frames should be converted to RGB by the plug-in (set from media options). */
+	bool VideoConvertToRgb;
+
 	/** Current duration of video frames. */
 	FTimespan VideoFrameDuration;
 
+	/** Number of frames that were not output because they were identical to the previous frame. */
+	FThreadSafeCounter VideoIdenticalFrames;
+
+	/** Maximum width and height of video frames (0 = unlimited; set from media options). */
+	int32 VideoMaxOutputDim;
+
 	/** Current video output dimensions (accessed by VLC thread only). */
 	FIntPoint VideoOutputDim;
 
-	/** Play time of the previous frame. */
-	FTimespan VideoPreviousTime;
+	/** Current layout of the planes in decoded video frames (accessed by VLC thread only). */
+	FVlcMediaPlaneLayout VideoPlaneLayout;
+
+	/** Number of discarded queued frames when the previous frame was output (accessed by VLC thread only). */
+	int32 VideoPreviousDiscards;
+
+	/** Hash of the previously output video frame (accessed by VLC thread only). */
+	uint64 VideoPreviousHash;
+
+	/** Whether VideoPreviousHash is valid (accessed by VLC thread only). */
+	bool VideoPreviousHashValid;
+
+	/** The previously output video sample, if it is still queued or in use. */
+	TWeakPtr<FVlcMediaTextureSample, ESPMode::ThreadSafe> VideoPreviousSample;
 
 	/** Current video sample format (accessed by VLC thread only). */
 	EMediaTextureSampleFormat VideoSampleFormat;
 
+	/** Current layout of the planes in video samples (accessed by VLC thread only; differs from VideoPlaneLayout if frames are converted). */
+	FVlcMediaPlaneLayout VideoSampleLayout;
+
 	/** Video sample object pool. */
 	FVlcMediaTextureSamplePool* VideoSamplePool;
+
+	/** Scratch buffers for frames that are not output (allocated in the VLC setup callback). */
+	void* VideoScratchBuffers[NumVideoScratchBuffers];
+
+	/** Size of each video scratch buffer (in bytes). */
+	SIZE_T VideoScratchBufferSize;
+
+	/** Critical section for synchronizing access to the scratch buffers. */
+	FCriticalSection VideoScratchCriticalSection;
+
+	/** Scratch buffer shared by all frames that are not output while every other scratch buffer is locked. */
+	void* VideoScratchDiscardBuffer;
+
+	/** Number of frames written to scratch buffers because the sample failed to initialize. */
+	FThreadSafeCounter VideoScratchFailedFrames;
+
+	/** Scratch buffers that are not locked by VLC. */
+	TArray<void*, TFixedAllocator<NumVideoScratchBuffers>> VideoScratchFreeBuffers;
+
+	/** Number of frames written to scratch buffers because the sample pool was exhausted. */
+	FThreadSafeCounter VideoScratchPoolFrames;
+
+	/** Number of frames written to scratch buffers because the output queue was full. */
+	FThreadSafeCounter VideoScratchQueueFrames;
+
+	/** Number of frames written to the discard buffer because every other scratch buffer was locked. */
+	FThreadSafeCounter VideoScratchSharedFrames;
+
+	/** Cycle counter at which the first video frame after the most recent seek was output (0 = none yet). */
+	FThreadSafeCounter64 VideoSeekOutputCycles;
+
+	/** Cycle counter when the pending seek was requested (0 = no seek pending). */
+	FThreadSafeCounter64 VideoSeekStartCycles;
+
+	/** Whether frames that are identical to the previous frame should be skipped (set from media options). */
+	bool VideoSkipIdenticalFrames;
+
+	/** Number of frames of the previous position that were discarded after a seek. */
+	FThreadSafeCounter VideoStaleFrames;
+
+	/** Number of frames that were output because they differed from the previous frame. */
+	FThreadSafeCounter VideoUniqueFrames;
+
+	/** Number of visible rows in each video sample plane (accessed by VLC thread only). */
+	uint32 VideoVisibleLines[FVlcMediaPlaneLayout::MaxPlanes];
+
+	/** Number of visible bytes per row in each video sample plane (accessed by VLC thread only). */
+	uint32 VideoVisibleRowBytes[FVlcMediaPlaneLayout::MaxPlanes];
 };
\ No newline at end of file
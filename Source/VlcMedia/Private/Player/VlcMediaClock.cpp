@@ -0,0 +1,141 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaClock.h"
+#include "VlcMediaPrivate.h"
+
+#include "Vlc.h"
+
+
+/* FVlcMediaClock static initialization
+ *****************************************************************************/
+
+const float FVlcMediaClock::MaxCorrectionRate = 0.05f;
+const FTimespan FVlcMediaClock::ResyncThreshold = FTimespan::FromMilliseconds(500.0);
+const FTimespan FVlcMediaClock::ResyncDelay = FTimespan::FromSeconds(1.0);
+const float FVlcMediaClock::SmoothingFactor = 0.1f;
+
+
+/* FVlcMediaClock structors
+ *****************************************************************************/
+
+FVlcMediaClock::FVlcMediaClock()
+	: BaseClock(0)
+	, BaseTime(FTimespan::Zero())
+	, LastSyncClock(0)
+	, MaxOffset(FTimespan::Zero())
+	, NumResyncs(0)
+	, Rate(0.0f)
+	, ResyncElapsed(0)
+	, SettleClock(0)
+	, SmoothedOffset(FTimespan::Zero())
+{ }
+
+
+/* FVlcMediaClock interface
+ *****************************************************************************/
+
+FTimespan FVlcMediaClock::GetTime() const
+{
+	return GetTimeAt(FVlc::Clock());
+}
+
+
+void FVlcMediaClock::Reset(FTimespan Time)
+{
+	BaseClock = FVlc::Clock();
+	BaseTime = Time;
+	LastSyncClock = 0;
+	ResyncElapsed = 0;
+	SettleClock = BaseClock + (int64)ResyncDelay.GetTotalMicroseconds();
+	SmoothedOffset = FTimespan::Zero();
+}
+
+
+void FVlcMediaClock::SetRate(float InRate)
+{
+	if (InRate == Rate)
+	{
+		return;
+	}
+
+	const int64 Clock = FVlc::Clock();
+
+	BaseTime = GetTimeAt(Clock);
+	BaseClock = Clock;
+	LastSyncClock = 0;
+	Rate = InRate;
+	SettleClock = Clock + (int64)ResyncDelay.GetTotalMicroseconds();
+}
+
+
+void FVlcMediaClock::Synchronize(FTimespan MasterTime)
+{
+	const int64 Clock = FVlc::Clock();
+	const FTimespan Time = GetTimeAt(Clock);
+	const FTimespan Offset = MasterTime - Time;
+
+	if (LastSyncClock == 0)
+	{
+		// first measurement since reset
+		LastSyncClock = Clock;
+		SmoothedOffset = Offset;
+
+		return;
+	}
+
+	const int64 Elapsed = Clock - LastSyncClock;
+
+	LastSyncClock = Clock;
+	SmoothedOffset += FTimespan((int64)((Offset - SmoothedOffset).GetTicks() * SmoothingFactor));
+
+	// resynchronize if the clock is far off for too long, i.e. after a stall
+	if (Offset.GetDuration() > ResyncThreshold)
+	{
+		ResyncElapsed += Elapsed;
+
+		if (ResyncElapsed >= (int64)ResyncDelay.GetTotalMicroseconds())
+		{
+			UE_LOG(LogVlcMedia, Verbose, TEXT("Clock %p: Resynchronizing (offset %.1f ms)"), this, Offset.GetTotalMilliseconds());
+
+			BaseClock = Clock;
+			BaseTime = MasterTime;
+			ResyncElapsed = 0;
+			SettleClock = Clock + (int64)ResyncDelay.GetTotalMicroseconds();
+			SmoothedOffset = FTimespan::Zero();
+
+			++NumResyncs;
+		}
+
+		return;
+	}
+
+	ResyncElapsed = 0;
+
+	if ((Clock >= SettleClock) && (SmoothedOffset.GetDuration() > MaxOffset))
+	{
+		MaxOffset = SmoothedOffset.GetDuration();
+	}
+
+	// pull the clock towards the master, but no faster than the correction rate
+	const int64 MaxCorrection = (int64)(Elapsed * ETimespan::TicksPerMicrosecond * MaxCorrectionRate);
+	const FTimespan Correction = FTimespan(FMath::Clamp(SmoothedOffset.GetTicks(), -MaxCorrection, MaxCorrection));
+
+	BaseClock = Clock;
+	BaseTime = Time + Correction;
+	SmoothedOffset -= Correction;
+}
+
+
+void FVlcMediaClock::Wrap(FTimespan Duration)
+{
+	BaseTime -= Duration;
+}
+
+
+/* FVlcMediaClock implementation
+ *****************************************************************************/
+
+FTimespan FVlcMediaClock::GetTimeAt(int64 Clock) const
+{
+	return BaseTime + FTimespan::FromMicroseconds((Clock - BaseClock) * Rate);
+}
@@ -0,0 +1,176 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Misc/Timespan.h"
+
+
+/**
+ * Play time clock of VLC based media players.
+ *
+ * The clock advances with the VLC clock (which follows the system clock), so
+ * that frame hitches do not shift the play time. While a master time source
+ * is available, such as the decoder's position of an audio track, the clock
+ * is gradually pulled towards it with a bounded correction rate. Offsets that
+ * persist beyond a threshold cause the clock to resynchronize immediately.
+ *
+ * This class is not thread-safe.
+ */
+class FVlcMediaClock
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaClock();
+
+public:
+
+	/**
+	 * Get the largest smoothed offset between master time and clock while in sync.
+	 *
+	 * @return Maximum absolute offset.
+	 * @see GetOffset
+	 */
+	FTimespan GetMaxOffset() const
+	{
+		return MaxOffset;
+	}
+
+	/**
+	 * Get the number of times the clock was resynchronized to the master time.
+	 *
+	 * @return Number of resynchronizations.
+	 */
+	int32 GetNumResyncs() const
+	{
+		return NumResyncs;
+	}
+
+	/**
+	 * Get the smoothed offset between master time and clock.
+	 *
+	 * A positive offset means that the clock is behind the master.
+	 *
+	 * @return Offset.
+	 * @see GetMaxOffset, Synchronize
+	 */
+	FTimespan GetOffset() const
+	{
+		return SmoothedOffset;
+	}
+
+	/**
+	 * Get the current play rate.
+	 *
+	 * @return Play rate.
+	 * @see SetRate
+	 */
+	float GetRate() const
+	{
+		return Rate;
+	}
+
+	/**
+	 * Get the current play time.
+	 *
+	 * @return Play time.
+	 * @see Reset
+	 */
+	FTimespan GetTime() const;
+
+	/**
+	 * Check whether the clock was synchronized to a master time source since it was reset.
+	 *
+	 * @return true if synchronized, false if free running.
+	 */
+	bool IsSynchronized() const
+	{
+		return (LastSyncClock != 0);
+	}
+
+	/**
+	 * Set the play time, i.e. after opening, seeking or looping.
+	 *
+	 * @param Time The new play time.
+	 * @see GetTime
+	 */
+	void Reset(FTimespan Time);
+
+	/**
+	 * Set the play rate.
+	 *
+	 * @param InRate The new play rate (0.0 = paused).
+	 * @see GetRate
+	 */
+	void SetRate(float InRate);
+
+	/**
+	 * Correct the clock towards the current time of the master source.
+	 *
+	 * Call this regularly while a master source is available.
+	 *
+	 * @param MasterTime The master's current play time.
+	 * @see GetOffset
+	 */
+	void Synchronize(FTimespan MasterTime);
+
+	/**
+	 * Move the play time back by the duration of one loop iteration.
+	 *
+	 * Unlike Reset, this keeps the synchronization state, because the
+	 * master source continues seamlessly into the next iteration.
+	 *
+	 * @param Duration The duration of the looping media.
+	 * @see Reset
+	 */
+	void Wrap(FTimespan Duration);
+
+public:
+
+	/** Maximum rate at which the clock is corrected (fraction of elapsed time). */
+	static const float MaxCorrectionRate;
+
+	/** Offset beyond which the clock resynchronizes. */
+	static const FTimespan ResyncThreshold;
+
+	/** Time for which the offset must exceed the threshold before resynchronizing. */
+	static const FTimespan ResyncDelay;
+
+	/** Weight of new offset measurements in the smoothed offset. */
+	static const float SmoothingFactor;
+
+private:
+
+	/** Get the play time at the specified VLC clock time. */
+	FTimespan GetTimeAt(int64 Clock) const;
+
+private:
+
+	/** VLC clock time at which BaseTime was set (in microseconds). */
+	int64 BaseClock;
+
+	/** Play time at BaseClock. */
+	FTimespan BaseTime;
+
+	/** VLC clock time of the last synchronization (in microseconds; 0 = not synchronized). */
+	int64 LastSyncClock;
+
+	/** Largest absolute smoothed offset while in sync. */
+	FTimespan MaxOffset;
+
+	/** Number of resynchronizations. */
+	int32 NumResyncs;
+
+	/** The current play rate. */
+	float Rate;
+
+	/** Time for which the offset has exceeded the resync threshold (in microseconds). */
+	int64 ResyncElapsed;
+
+	/** VLC clock time after which offsets are included in MaxOffset (in microseconds). */
+	int64 SettleClock;
+
+	/** Smoothed offset between master time and clock. */
+	FTimespan SmoothedOffset;
+};
@@ -0,0 +1,172 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaFileCache.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+#include "VlcMediaCachedFile.h"
+
+
+/* FVlcMediaFileCache static functions
+ *****************************************************************************/
+
+FVlcMediaFileCache& FVlcMediaFileCache::Get()
+{
+	static FVlcMediaFileCache Cache;
+	return Cache;
+}
+
+
+/* FVlcMediaFileCache interface
+ *****************************************************************************/
+
+bool FVlcMediaFileCache::Contains(const FVlcMediaCachedFile& File) const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	for (const auto& Pair : Entries)
+	{
+		if (&Pair.Value.File.Get() == &File)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void FVlcMediaFileCache::Empty()
+{
+	// files are released outside of the lock, because that waits for their loader threads
+	TArray<TSharedRef<FVlcMediaCachedFile, ESPMode::ThreadSafe>> EvictedFiles;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		for (auto It = Entries.CreateIterator(); It; ++It)
+		{
+			if (It.Value().File.IsUnique())
+			{
+				EvictedFiles.Add(It.Value().File);
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+
+int64 FVlcMediaFileCache::GetNumBytes() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	int64 NumBytes = 0;
+
+	for (const auto& Pair : Entries)
+	{
+		NumBytes += Pair.Value.File->GetSize();
+	}
+
+	return NumBytes;
+}
+
+
+TSharedPtr<FVlcMediaCachedFile, ESPMode::ThreadSafe> FVlcMediaFileCache::Load(const FString& FilePath)
+{
+	FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+	FPaths::NormalizeFilename(FullPath);
+
+	const FDateTime TimeStamp = IFileManager::Get().GetTimeStamp(*FullPath);
+
+	// outdated copies are released outside of the lock (players that use them keep them alive)
+	TSharedPtr<FVlcMediaCachedFile, ESPMode::ThreadSafe> OutdatedFile;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		FEntry* Entry = Entries.Find(FullPath);
+
+		if (Entry != nullptr)
+		{
+			// reuse the file unless it changed on disk or failed to load
+			if ((Entry->TimeStamp == TimeStamp) && !Entry->File->HasFailed())
+			{
+				Entry->LastUsedTime = FPlatformTime::Seconds();
+				return Entry->File;
+			}
+
+			OutdatedFile = Entry->File;
+			Entries.Remove(FullPath);
+		}
+	}
+
+	FArchive* FileReader = IFileManager::Get().CreateFileReader(*FullPath);
+
+	if (FileReader == nullptr)
+	{
+		return nullptr;
+	}
+
+	TSharedRef<FVlcMediaCachedFile, ESPMode::ThreadSafe> File = MakeShareable(new FVlcMediaCachedFile(FileReader, FullPath));
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		FEntry& Entry = Entries.Add(FullPath, FEntry(File, TimeStamp));
+		Entry.LastUsedTime = FPlatformTime::Seconds();
+	}
+
+	Trim();
+
+	return File;
+}
+
+
+void FVlcMediaFileCache::Trim()
+{
+	const int64 Budget = (int64)FMath::Max(0, GetDefault<UVlcMediaSettings>()->PrecacheBudgetMegabytes) * 1024 * 1024;
+
+	// files are released outside of the lock, because that waits for their loader threads
+	TArray<TSharedRef<FVlcMediaCachedFile, ESPMode::ThreadSafe>> EvictedFiles;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		int64 NumBytes = 0;
+
+		for (const auto& Pair : Entries)
+		{
+			NumBytes += Pair.Value.File->GetSize();
+		}
+
+		while (NumBytes > Budget)
+		{
+			const FString* OldestPath = nullptr;
+			double OldestTime = 0.0;
+
+			for (const auto& Pair : Entries)
+			{
+				if (Pair.Value.File.IsUnique() && ((OldestPath == nullptr) || (Pair.Value.LastUsedTime < OldestTime)))
+				{
+					OldestPath = &Pair.Key;
+					OldestTime = Pair.Value.LastUsedTime;
+				}
+			}
+
+			if (OldestPath == nullptr)
+			{
+				break; // remaining files are in use
+			}
+
+			const FString EvictedPath = *OldestPath;
+			const FEntry& Evicted = Entries.FindChecked(EvictedPath);
+
+			UE_LOG(LogVlcMedia, Verbose, TEXT("Evicting precached media file %s (%lld bytes)"), *EvictedPath, Evicted.File->GetSize());
+
+			NumBytes -= Evicted.File->GetSize();
+			EvictedFiles.Add(Evicted.File);
+			Entries.Remove(EvictedPath);
+		}
+	}
+}
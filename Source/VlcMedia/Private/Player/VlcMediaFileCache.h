@@ -0,0 +1,111 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/DateTime.h"
+#include "Templates/SharedPointer.h"
+
+class FVlcMediaCachedFile;
+
+
+/**
+ * Process-wide cache of precached media files.
+ *
+ * Files are keyed by their full path and modification time, so that players
+ * opening the same file share a single copy in memory. Files that are still
+ * in use are never evicted. Unused files are kept for reuse until the cache
+ * exceeds its memory budget, at which point the least recently used ones are
+ * released.
+ *
+ * This class is thread-safe.
+ */
+class FVlcMediaFileCache
+{
+public:
+
+	/**
+	 * Get the singleton instance.
+	 *
+	 * @return The file cache.
+	 */
+	static FVlcMediaFileCache& Get();
+
+public:
+
+	/**
+	 * Check whether the cache holds the specified file.
+	 *
+	 * Files are no longer held once they were evicted, or replaced by a copy
+	 * of a newer version of the file.
+	 *
+	 * @param File The file to check.
+	 * @return true if the file is cached, false otherwise.
+	 */
+	bool Contains(const FVlcMediaCachedFile& File) const;
+
+	/**
+	 * Release all cached files that are not in use.
+	 *
+	 * @see Trim
+	 */
+	void Empty();
+
+	/**
+	 * Get the number of bytes held by the cache.
+	 *
+	 * @return Number of bytes, including files that are still loading.
+	 */
+	int64 GetNumBytes() const;
+
+	/**
+	 * Get a cached file, or start loading it if it is not cached yet.
+	 *
+	 * @param FilePath The path of the file to load.
+	 * @return The cached file, or nullptr if the file could not be opened.
+	 */
+	TSharedPtr<FVlcMediaCachedFile, ESPMode::ThreadSafe> Load(const FString& FilePath);
+
+	/**
+	 * Evict the least recently used unused files until the cache is within its budget.
+	 *
+	 * Call this after releasing a cached file.
+	 *
+	 * @see Empty
+	 */
+	void Trim();
+
+private:
+
+	/** Hidden constructor (use Get instead). */
+	FVlcMediaFileCache() { }
+
+private:
+
+	/** A cached file. */
+	struct FEntry
+	{
+		/** The file. */
+		TSharedRef<FVlcMediaCachedFile, ESPMode::ThreadSafe> File;
+
+		/** Time at which the file was last requested (in seconds). */
+		double LastUsedTime;
+
+		/** The file's modification time when it was loaded. */
+		FDateTime TimeStamp;
+
+		/** Create and initialize a new instance. */
+		FEntry(const TSharedRef<FVlcMediaCachedFile, ESPMode::ThreadSafe>& InFile, const FDateTime& InTimeStamp)
+			: File(InFile)
+			, LastUsedTime(0.0)
+			, TimeStamp(InTimeStamp)
+		{ }
+	};
+
+	/** Critical section for synchronizing access to the entries. */
+	mutable FCriticalSection CriticalSection;
+
+	/** The cached files, keyed by full path. */
+	TMap<FString, FEntry> Entries;
+};
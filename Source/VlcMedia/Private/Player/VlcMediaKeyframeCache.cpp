@@ -0,0 +1,96 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaKeyframeCache.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/UniquePtr.h"
+
+#include "VlcMediaKeyframeIndex.h"
+
+
+/* FVlcMediaKeyframeCache static initialization
+ *****************************************************************************/
+
+const int32 FVlcMediaKeyframeCache::MaxEntries = 256;
+
+
+/* FVlcMediaKeyframeCache static functions
+ *****************************************************************************/
+
+FVlcMediaKeyframeCache& FVlcMediaKeyframeCache::Get()
+{
+	static FVlcMediaKeyframeCache Cache;
+	return Cache;
+}
+
+
+/* FVlcMediaKeyframeCache interface
+ *****************************************************************************/
+
+TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe> FVlcMediaKeyframeCache::Find(const FString& FilePath)
+{
+	FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+	FPaths::NormalizeFilename(FullPath);
+
+	const FDateTime TimeStamp = IFileManager::Get().GetTimeStamp(*FullPath);
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		FEntry* Entry = Entries.Find(FullPath);
+
+		if ((Entry != nullptr) && (Entry->TimeStamp == TimeStamp))
+		{
+			Entry->LastUsedTime = FPlatformTime::Seconds();
+			return Entry->Index;
+		}
+	}
+
+	// parse outside of the lock, because reading the sample tables may take a while
+	TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*FullPath));
+
+	if (!FileReader.IsValid())
+	{
+		return nullptr;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe> Index = FVlcMediaKeyframeIndex::ParseMp4(*FileReader);
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Indexed %i keyframes of %s in %.1f ms"),
+		Index.IsValid() ? Index->Num() : 0,
+		*FullPath,
+		(FPlatformTime::Seconds() - StartTime) * 1000.0
+	);
+
+	FScopeLock Lock(&CriticalSection);
+
+	FEntry& Entry = Entries.FindOrAdd(FullPath);
+	Entry.Index = Index;
+	Entry.LastUsedTime = FPlatformTime::Seconds();
+	Entry.TimeStamp = TimeStamp;
+
+	// release the least recently used indices
+	while (Entries.Num() > MaxEntries)
+	{
+		const FString* OldestPath = nullptr;
+		double OldestTime = 0.0;
+
+		for (const auto& Pair : Entries)
+		{
+			if ((OldestPath == nullptr) || (Pair.Value.LastUsedTime < OldestTime))
+			{
+				OldestPath = &Pair.Key;
+				OldestTime = Pair.Value.LastUsedTime;
+			}
+		}
+
+		Entries.Remove(FString(*OldestPath));
+	}
+
+	return Index;
+}
@@ -0,0 +1,77 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/DateTime.h"
+#include "Templates/SharedPointer.h"
+
+class FVlcMediaKeyframeIndex;
+
+
+/**
+ * Process-wide cache of keyframe indices of local media files.
+ *
+ * Indices are keyed by the file's full path and modification time, so that
+ * files are parsed only once per session. Files without an index are
+ * remembered as well. The least recently used entries are released once the
+ * cache holds more than MaxEntries files.
+ *
+ * This class is thread-safe.
+ */
+class FVlcMediaKeyframeCache
+{
+public:
+
+	/**
+	 * Get the singleton instance.
+	 *
+	 * @return The keyframe cache.
+	 */
+	static FVlcMediaKeyframeCache& Get();
+
+public:
+
+	/**
+	 * Get the keyframe index of a file, or build it if it is not cached yet.
+	 *
+	 * Building the index reads the file's sample tables, so this should not be
+	 * called on the game thread.
+	 *
+	 * @param FilePath The path of the file.
+	 * @return The keyframe index, or nullptr if the file does not have one.
+	 */
+	TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe> Find(const FString& FilePath);
+
+public:
+
+	/** Maximum number of files to keep indices for. */
+	static const int32 MaxEntries;
+
+private:
+
+	/** Hidden constructor (use Get instead). */
+	FVlcMediaKeyframeCache() { }
+
+private:
+
+	/** A cached keyframe index. */
+	struct FEntry
+	{
+		/** The index (nullptr = the file does not have one). */
+		TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe> Index;
+
+		/** Time at which the index was last requested (in seconds). */
+		double LastUsedTime;
+
+		/** The file's modification time when it was indexed. */
+		FDateTime TimeStamp;
+	};
+
+	/** Critical section for synchronizing access to the entries. */
+	FCriticalSection CriticalSection;
+
+	/** The cached indices, keyed by full path. */
+	TMap<FString, FEntry> Entries;
+};
@@ -0,0 +1,450 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaKeyframeIndex.h"
+#include "VlcMediaPrivate.h"
+
+#include "Serialization/Archive.h"
+
+
+namespace VlcMediaKeyframeIndex
+{
+	/** Maximum size of a movie box that is loaded for indexing (larger ones are ignored). */
+	const int64 MaxMovieBoxSize = 64 * 1024 * 1024;
+
+	/** Create a box type code from its four characters. */
+	constexpr uint32 BoxType(char A, char B, char C, char D)
+	{
+		return ((uint32)(uint8)A << 24) | ((uint32)(uint8)B << 16) | ((uint32)(uint8)C << 8) | (uint32)(uint8)D;
+	}
+
+	/** Read a big-endian 32-bit value. */
+	uint32 ReadU32(const uint8* Data)
+	{
+		return ((uint32)Data[0] << 24) | ((uint32)Data[1] << 16) | ((uint32)Data[2] << 8) | (uint32)Data[3];
+	}
+
+	/** Read a big-endian 64-bit value. */
+	uint64 ReadU64(const uint8* Data)
+	{
+		return ((uint64)ReadU32(Data) << 32) | (uint64)ReadU32(Data + 4);
+	}
+
+	/** The payload of a box in a loaded buffer. */
+	struct FBox
+	{
+		/** The box data (after the header). */
+		const uint8* Data;
+
+		/** Size of the box data (in bytes). */
+		int64 Size;
+	};
+
+	/** Find the first child box of the specified type. */
+	bool FindChild(const FBox& Parent, uint32 Type, FBox& OutChild, int64 StartOffset = 0)
+	{
+		int64 Offset = StartOffset;
+
+		while (Offset + 8 <= Parent.Size)
+		{
+			const uint8* Header = Parent.Data + Offset;
+
+			int64 BoxSize = ReadU32(Header);
+			int64 HeaderSize = 8;
+
+			if (BoxSize == 1)
+			{
+				if (Offset + 16 > Parent.Size)
+				{
+					return false;
+				}
+
+				BoxSize = (int64)ReadU64(Header + 8);
+				HeaderSize = 16;
+			}
+			else if (BoxSize == 0)
+			{
+				BoxSize = Parent.Size - Offset; // extends to the end of the parent
+			}
+
+			if ((BoxSize < HeaderSize) || (BoxSize > Parent.Size - Offset))
+			{
+				return false; // corrupt box
+			}
+
+			if (ReadU32(Header + 4) == Type)
+			{
+				OutChild.Data = Header + HeaderSize;
+				OutChild.Size = BoxSize - HeaderSize;
+
+				return true;
+			}
+
+			Offset += BoxSize;
+		}
+
+		return false;
+	}
+
+	/** Find a box by its path of nested box types. */
+	bool FindPath(const FBox& Parent, std::initializer_list<uint32> Types, FBox& OutBox)
+	{
+		FBox Box = Parent;
+
+		for (uint32 Type : Types)
+		{
+			if (!FindChild(Box, Type, Box))
+			{
+				return false;
+			}
+		}
+
+		OutBox = Box;
+
+		return true;
+	}
+
+	/** Walks the run-length encoded entries of a time-to-sample or composition offset table. */
+	struct FRunCursor
+	{
+		/** The table entries (pairs of sample count and value). */
+		const uint8* Entries;
+
+		/** Index of the current entry. */
+		uint32 Entry;
+
+		/** Number of entries in the table. */
+		uint32 NumEntries;
+
+		/** Number of samples remaining in the current entry. */
+		uint32 Remaining;
+
+		/** Create and initialize a new instance. */
+		FRunCursor(const uint8* InEntries, uint32 InNumEntries)
+			: Entries(InEntries)
+			, Entry(0)
+			, NumEntries(InNumEntries)
+			, Remaining((InNumEntries > 0) ? ReadU32(InEntries) : 0)
+		{
+			SkipEmpty();
+		}
+
+		/** Get the value of the current entry (0 if past the end). */
+		uint32 GetValue() const
+		{
+			return (Entry < NumEntries) ? ReadU32(Entries + Entry * 8 + 4) : 0;
+		}
+
+		/** Advance by the specified number of samples, and return the sum of the values that were passed. */
+		uint64 Advance(uint64 NumSamples)
+		{
+			uint64 Sum = 0;
+
+			while ((NumSamples > 0) && (Entry < NumEntries))
+			{
+				const uint32 Step = (uint32)FMath::Min<uint64>(NumSamples, Remaining);
+
+				Sum += (uint64)Step * GetValue();
+				Remaining -= Step;
+				NumSamples -= Step;
+
+				SkipEmpty();
+			}
+
+			return Sum;
+		}
+
+		/** Move past exhausted or empty entries, so that the current entry applies to the next sample. */
+		void SkipEmpty()
+		{
+			while ((Remaining == 0) && (Entry < NumEntries))
+			{
+				if (++Entry < NumEntries)
+				{
+					Remaining = ReadU32(Entries + Entry * 8);
+				}
+			}
+		}
+	};
+
+	/** Check that a full box holds a table with the specified entry size, and return its number of entries. */
+	bool GetTable(const FBox& Box, int64 EntrySize, uint32& OutNumEntries)
+	{
+		if (Box.Size < 8)
+		{
+			return false;
+		}
+
+		OutNumEntries = ReadU32(Box.Data + 4);
+
+		return (Box.Size >= 8 + OutNumEntries * EntrySize);
+	}
+
+	/** Convert a time in a media time scale to time span. */
+	FTimespan ToTimespan(int64 Time, uint32 TimeScale)
+	{
+		if (Time <= 0)
+		{
+			return FTimespan::Zero();
+		}
+
+		return FTimespan((Time / TimeScale) * ETimespan::TicksPerSecond + (Time % TimeScale) * ETimespan::TicksPerSecond / TimeScale);
+	}
+
+	/** Load the movie box of an MP4 file. */
+	bool LoadMovieBox(FArchive& Archive, TArray<uint8>& OutData)
+	{
+		const int64 FileSize = Archive.TotalSize();
+		int64 Offset = Archive.Tell();
+
+		while (Offset + 8 <= FileSize)
+		{
+			uint8 Header[16];
+
+			Archive.Seek(Offset);
+			Archive.Serialize(Header, 8);
+
+			if (Archive.IsError())
+			{
+				return false;
+			}
+
+			int64 BoxSize = ReadU32(Header);
+			int64 HeaderSize = 8;
+
+			if (BoxSize == 1)
+			{
+				Archive.Serialize(Header + 8, 8);
+				BoxSize = (int64)ReadU64(Header + 8);
+				HeaderSize = 16;
+			}
+			else if (BoxSize == 0)
+			{
+				BoxSize = FileSize - Offset;
+			}
+
+			if (Archive.IsError() || (BoxSize < HeaderSize) || (BoxSize > FileSize - Offset))
+			{
+				return false;
+			}
+
+			if (ReadU32(Header + 4) == BoxType('m', 'o', 'o', 'v'))
+			{
+				if (BoxSize - HeaderSize > MaxMovieBoxSize)
+				{
+					return false;
+				}
+
+				OutData.SetNumUninitialized(BoxSize - HeaderSize);
+				Archive.Serialize(OutData.GetData(), OutData.Num());
+
+				return !Archive.IsError();
+			}
+
+			// skip media data and other top-level boxes without reading them
+			Offset += BoxSize;
+		}
+
+		return false;
+	}
+}
+
+
+/* FVlcMediaKeyframeIndex static functions
+ *****************************************************************************/
+
+TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe> FVlcMediaKeyframeIndex::ParseMp4(FArchive& Archive)
+{
+	using namespace VlcMediaKeyframeIndex;
+
+	TArray<uint8> MovieData;
+
+	if (!LoadMovieBox(Archive, MovieData))
+	{
+		return nullptr;
+	}
+
+	const FBox Movie = { MovieData.GetData(), MovieData.Num() };
+	const uint32 TrackType = BoxType('t', 'r', 'a', 'k');
+
+	// find the first video track
+	for (int64 Offset = 0; Offset < Movie.Size; )
+	{
+		FBox Track;
+
+		if (!FindChild(Movie, TrackType, Track, Offset))
+		{
+			break;
+		}
+
+		Offset = (Track.Data - Movie.Data) + Track.Size;
+
+		FBox Handler;
+
+		if (!FindPath(Track, { BoxType('m', 'd', 'i', 'a'), BoxType('h', 'd', 'l', 'r') }, Handler) ||
+			(Handler.Size < 12) ||
+			(ReadU32(Handler.Data + 8) != BoxType('v', 'i', 'd', 'e')))
+		{
+			continue;
+		}
+
+		// media time scale
+		FBox MediaHeader;
+
+		if (!FindPath(Track, { BoxType('m', 'd', 'i', 'a'), BoxType('m', 'd', 'h', 'd') }, MediaHeader))
+		{
+			return nullptr;
+		}
+
+		const int64 TimeScaleOffset = (MediaHeader.Size > 0) && (MediaHeader.Data[0] == 1) ? 20 : 12;
+
+		if (MediaHeader.Size < TimeScaleOffset + 4)
+		{
+			return nullptr;
+		}
+
+		const uint32 TimeScale = ReadU32(MediaHeader.Data + TimeScaleOffset);
+
+		// sample tables
+		FBox SampleTable;
+
+		if ((TimeScale == 0) || !FindPath(Track, { BoxType('m', 'd', 'i', 'a'), BoxType('m', 'i', 'n', 'f'), BoxType('s', 't', 'b', 'l') }, SampleTable))
+		{
+			return nullptr;
+		}
+
+		FBox SyncSamples;
+		FBox TimeToSample;
+		uint32 NumSyncSamples = 0;
+		uint32 NumTimeToSample = 0;
+
+		// without a sync sample table every frame is a keyframe
+		if (!FindChild(SampleTable, BoxType('s', 't', 's', 's'), SyncSamples) || !GetTable(SyncSamples, 4, NumSyncSamples) ||
+			!FindChild(SampleTable, BoxType('s', 't', 't', 's'), TimeToSample) || !GetTable(TimeToSample, 8, NumTimeToSample) ||
+			(NumSyncSamples == 0))
+		{
+			return nullptr;
+		}
+
+		FBox CompositionOffsets = { nullptr, 0 };
+		uint32 NumCompositionOffsets = 0;
+
+		if (!FindChild(SampleTable, BoxType('c', 't', 't', 's'), CompositionOffsets) || !GetTable(CompositionOffsets, 8, NumCompositionOffsets))
+		{
+			NumCompositionOffsets = 0;
+		}
+
+		const bool SignedOffsets = (NumCompositionOffsets > 0) && (CompositionOffsets.Data[0] == 1);
+
+		// the edit list shifts the media time of the first presented frame to zero
+		int64 MediaTime = 0;
+		FBox EditList;
+
+		if (FindPath(Track, { BoxType('e', 'd', 't', 's'), BoxType('e', 'l', 's', 't') }, EditList) && (EditList.Size > 0))
+		{
+			const bool EditVersion1 = (EditList.Data[0] == 1);
+			const int64 EditSize = EditVersion1 ? 20 : 12;
+			uint32 NumEdits = 0;
+
+			if (GetTable(EditList, EditSize, NumEdits))
+			{
+				for (uint32 EditIndex = 0; EditIndex < NumEdits; ++EditIndex)
+				{
+					const uint8* Edit = EditList.Data + 8 + EditIndex * EditSize;
+					const int64 EditMediaTime = EditVersion1 ? (int64)ReadU64(Edit + 8) : (int64)(int32)ReadU32(Edit + 4);
+
+					// empty edits have a media time of -1
+					if (EditMediaTime >= 0)
+					{
+						MediaTime = EditMediaTime;
+						break;
+					}
+				}
+			}
+		}
+
+		TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe> Index = MakeShareable(new FVlcMediaKeyframeIndex);
+		Index->Times.Reserve(NumSyncSamples);
+
+		FRunCursor DecodeCursor(TimeToSample.Data + 8, NumTimeToSample);
+		FRunCursor CompositionCursor(CompositionOffsets.Data + 8, NumCompositionOffsets);
+
+		int64 DecodeTime = 0;
+		uint32 SampleNumber = 1;
+
+		for (uint32 SyncIndex = 0; SyncIndex < NumSyncSamples; ++SyncIndex)
+		{
+			const uint32 SyncSample = ReadU32(SyncSamples.Data + 8 + SyncIndex * 4);
+
+			if (SyncSample < SampleNumber)
+			{
+				continue; // sync samples must be in ascending order
+			}
+
+			DecodeTime += (int64)DecodeCursor.Advance(SyncSample - SampleNumber);
+			CompositionCursor.Advance(SyncSample - SampleNumber);
+			SampleNumber = SyncSample;
+
+			const int64 CompositionOffset = SignedOffsets ? (int64)(int32)CompositionCursor.GetValue() : (int64)CompositionCursor.GetValue();
+
+			Index->Times.Add(ToTimespan(DecodeTime + CompositionOffset - MediaTime, TimeScale));
+		}
+
+		Index->Times.Sort();
+
+		return Index;
+	}
+
+	return nullptr;
+}
+
+
+/* FVlcMediaKeyframeIndex interface
+ *****************************************************************************/
+
+FTimespan FVlcMediaKeyframeIndex::FindNearest(FTimespan Time) const
+{
+	const int32 Previous = FindPreviousIndex(Time);
+	const int32 Next = Previous + 1;
+
+	if ((Next < Times.Num()) && ((Times[Next] - Time) < (Time - Times[Previous])))
+	{
+		return Times[Next];
+	}
+
+	return Times[Previous];
+}
+
+
+FTimespan FVlcMediaKeyframeIndex::FindPrevious(FTimespan Time) const
+{
+	return Times[FindPreviousIndex(Time)];
+}
+
+
+/* FVlcMediaKeyframeIndex implementation
+ *****************************************************************************/
+
+int32 FVlcMediaKeyframeIndex::FindPreviousIndex(FTimespan Time) const
+{
+	check(Times.Num() > 0);
+
+	// binary search for the first keyframe after the time
+	int32 Low = 0;
+	int32 High = Times.Num();
+
+	while (Low < High)
+	{
+		const int32 Middle = Low + (High - Low) / 2;
+
+		if (Times[Middle] <= Time)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	return FMath::Max(0, Low - 1);
+}
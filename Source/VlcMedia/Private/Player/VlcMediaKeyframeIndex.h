@@ -0,0 +1,77 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+
+class FArchive;
+
+
+/**
+ * Presentation times of the keyframes of a media file's video track.
+ *
+ * The index is built from the sample tables of MP4 and QuickTime files
+ * (stss, stts, ctts and elst boxes of the first video track). Other
+ * containers, fragmented files, and files without a sync sample table
+ * (in which every frame is a keyframe) do not have an index.
+ *
+ * Instances are immutable and may be shared between threads.
+ *
+ * @see FVlcMediaKeyframeCache
+ */
+class FVlcMediaKeyframeIndex
+{
+public:
+
+	/**
+	 * Build the keyframe index of an MP4 or QuickTime file.
+	 *
+	 * @param Archive The archive to read the file from (must be at the start of the file).
+	 * @return The index, or nullptr if the file has no keyframe table.
+	 */
+	static TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe> ParseMp4(FArchive& Archive);
+
+public:
+
+	/**
+	 * Find the keyframe that is closest to the specified time.
+	 *
+	 * @param Time The time to find the keyframe for.
+	 * @return Time of the nearest keyframe.
+	 * @see FindPrevious
+	 */
+	FTimespan FindNearest(FTimespan Time) const;
+
+	/**
+	 * Find the last keyframe at or before the specified time.
+	 *
+	 * @param Time The time to find the keyframe for.
+	 * @return Time of the keyframe, or the first keyframe if none precedes the time.
+	 * @see FindNearest
+	 */
+	FTimespan FindPrevious(FTimespan Time) const;
+
+	/**
+	 * Get the number of keyframes.
+	 *
+	 * @return Number of keyframes.
+	 */
+	int32 Num() const
+	{
+		return Times.Num();
+	}
+
+private:
+
+	/** Hidden constructor (use ParseMp4 instead). */
+	FVlcMediaKeyframeIndex() { }
+
+	/** Get the index of the last keyframe at or before the specified time (or 0). */
+	int32 FindPreviousIndex(FTimespan Time) const;
+
+private:
+
+	/** Presentation times of the keyframes (in ascending order). */
+	TArray<FTimespan> Times;
+};
@@ -0,0 +1,414 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaLoopCache.h"
+#include "VlcMediaPrivate.h"
+
+#include "IMediaTextureSample.h"
+#include "Misc/ScopeLock.h"
+
+#include "VlcMediaAudioSample.h"
+
+
+namespace VlcMediaLoopCache
+{
+	/** Return the sample at the cursor if it overlaps the time range, and advance the cursor (no wrap-around). */
+	template<typename SampleType, typename OutSampleType>
+	bool FetchNext(const TArray<TSharedRef<SampleType, ESPMode::ThreadSafe>>& Samples, int32& Cursor, TRange<FTimespan> TimeRange, TSharedPtr<OutSampleType, ESPMode::ThreadSafe>& OutSample)
+	{
+		// the cursor stays at the end until the replay is seeked back to the start, because
+		// wrapping here would keep matching the fetch range and never stop fetching
+		if (Cursor >= Samples.Num())
+		{
+			return false;
+		}
+
+		const TSharedRef<SampleType, ESPMode::ThreadSafe>& Sample = Samples[Cursor];
+		const FTimespan SampleTime = Sample->GetTime();
+
+		if (!TimeRange.Overlaps(TRange<FTimespan>(SampleTime, SampleTime + Sample->GetDuration())))
+		{
+			return false;
+		}
+
+		OutSample = Sample;
+		++Cursor;
+
+		return true;
+	}
+
+	/** Find the index of the first sample that ends after the specified time (number of samples if none). */
+	template<typename SampleType>
+	int32 FindSample(const TArray<TSharedRef<SampleType, ESPMode::ThreadSafe>>& Samples, FTimespan Time)
+	{
+		for (int32 Index = 0; Index < Samples.Num(); ++Index)
+		{
+			if (Samples[Index]->GetTime() + Samples[Index]->GetDuration() > Time)
+			{
+				return Index;
+			}
+		}
+
+		return Samples.Num();
+	}
+
+	/** Check whether the recorded samples of a stream cover the entire media. */
+	template<typename SampleType>
+	bool IsCovered(const TArray<TSharedRef<SampleType, ESPMode::ThreadSafe>>& Samples, FTimespan Duration, FTimespan Tolerance)
+	{
+		if (Samples.Num() == 0)
+		{
+			return true;
+		}
+
+		const TSharedRef<SampleType, ESPMode::ThreadSafe>& LastSample = Samples.Last();
+
+		return (Samples[0]->GetTime() <= Tolerance) &&
+			(LastSample->GetTime() + LastSample->GetDuration() >= Duration - Tolerance);
+	}
+}
+
+
+namespace VlcMedia
+{
+	const TCHAR* LoopCacheStateToString(EVlcMediaLoopCacheState State)
+	{
+		switch (State)
+		{
+		case EVlcMediaLoopCacheState::Idle: return TEXT("Idle");
+		case EVlcMediaLoopCacheState::Recording: return TEXT("Recording");
+		case EVlcMediaLoopCacheState::Complete: return TEXT("Complete");
+		case EVlcMediaLoopCacheState::Overflowed: return TEXT("Over Budget");
+		default:
+			return TEXT("Unknown");
+		}
+	}
+}
+
+
+/* FVlcMediaLoopCache static initialization
+ *****************************************************************************/
+
+const FTimespan FVlcMediaLoopCache::CoverageTolerance = FTimespan::FromMilliseconds(250.0);
+
+
+/* FVlcMediaLoopCache structors
+ *****************************************************************************/
+
+FVlcMediaLoopCache::FVlcMediaLoopCache()
+	: AudioChannels(0)
+	, AudioCursor(0)
+	, AudioLastTime(FTimespan::MinValue())
+	, AudioSampleFormat(EMediaAudioSampleFormat::Undefined)
+	, AudioSampleRate(0)
+	, AudioSampleSize(0)
+	, AudioState(EStreamState::Waiting)
+	, MaxBytes(0)
+	, NumBytes(0)
+	, Replaying(false)
+	, State(EVlcMediaLoopCacheState::Idle)
+	, VideoCursor(0)
+	, VideoLastTime(FTimespan::MinValue())
+	, VideoState(EStreamState::Waiting)
+{ }
+
+
+/* FVlcMediaLoopCache interface
+ *****************************************************************************/
+
+void FVlcMediaLoopCache::BeginRecording()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if ((MaxBytes == 0) || (State == EVlcMediaLoopCacheState::Complete) || (State == EVlcMediaLoopCacheState::Overflowed))
+	{
+		return;
+	}
+
+	EmptySamples();
+
+	AudioLastTime = FTimespan::MinValue();
+	AudioState = EStreamState::Recording;
+	State = EVlcMediaLoopCacheState::Recording;
+	VideoLastTime = FTimespan::MinValue();
+	VideoState = EStreamState::Recording;
+}
+
+
+void FVlcMediaLoopCache::CancelRecording()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (State != EVlcMediaLoopCacheState::Recording)
+	{
+		return;
+	}
+
+	EmptySamples();
+
+	// the last sample times are kept, so that the wrap-around can be detected
+	AudioState = EStreamState::Waiting;
+	VideoState = EStreamState::Waiting;
+}
+
+
+bool FVlcMediaLoopCache::FetchAudio(TRange<FTimespan> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample)
+{
+	FScopeLock Lock(&CriticalSection);
+	return Replaying && VlcMediaLoopCache::FetchNext(AudioSamples, AudioCursor, TimeRange, OutSample);
+}
+
+
+bool FVlcMediaLoopCache::FetchVideo(TRange<FTimespan> TimeRange, TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe>& OutSample)
+{
+	FScopeLock Lock(&CriticalSection);
+	return Replaying && VlcMediaLoopCache::FetchNext(VideoSamples, VideoCursor, TimeRange, OutSample);
+}
+
+
+bool FVlcMediaLoopCache::FinishRecording(FTimespan Duration)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (State == EVlcMediaLoopCacheState::Complete)
+	{
+		return true;
+	}
+
+	if ((State != EVlcMediaLoopCacheState::Recording) || (NumBytes == 0))
+	{
+		return false;
+	}
+
+	// streams that restarted recording after a seek must wait for the next pass
+	if ((AudioState == EStreamState::Waiting) && (AudioLastTime != FTimespan::MinValue()))
+	{
+		return false;
+	}
+
+	if ((VideoState == EStreamState::Waiting) && (VideoLastTime != FTimespan::MinValue()))
+	{
+		return false;
+	}
+
+	if (!VlcMediaLoopCache::IsCovered(AudioSamples, Duration, CoverageTolerance) ||
+		!VlcMediaLoopCache::IsCovered(VideoSamples, Duration, CoverageTolerance))
+	{
+		// samples are missing, so try again with the following pass
+		const bool AudioRecording = (AudioState == EStreamState::Recording) && (AudioSamples.Num() > 0);
+		const bool VideoRecording = (VideoState == EStreamState::Recording) && (VideoSamples.Num() > 0);
+
+		if (!AudioRecording && !VideoRecording)
+		{
+			EmptySamples();
+
+			AudioState = EStreamState::Waiting;
+			VideoState = EStreamState::Waiting;
+		}
+
+		return false;
+	}
+
+	State = EVlcMediaLoopCacheState::Complete;
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Loop cache %p: Cached %i video and %i audio samples (%.1f MB)"), this, VideoSamples.Num(), AudioSamples.Num(), NumBytes / (1024.0 * 1024.0));
+
+	return true;
+}
+
+
+SIZE_T FVlcMediaLoopCache::GetNumBytes() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return NumBytes;
+}
+
+
+EVlcMediaLoopCacheState FVlcMediaLoopCache::GetState() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return State;
+}
+
+
+bool FVlcMediaLoopCache::IsEnabled() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return (MaxBytes > 0);
+}
+
+
+bool FVlcMediaLoopCache::IsReplaying() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Replaying;
+}
+
+
+void FVlcMediaLoopCache::RecordAudio(const void* Buffer, uint32 NumFrames, FTimespan Time)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if ((State != EVlcMediaLoopCacheState::Recording) || (AudioSampleRate == 0) || (NumFrames == 0))
+	{
+		return;
+	}
+
+	// sample times go backwards when the next pass starts
+	const bool Wrapped = (AudioLastTime != FTimespan::MinValue()) && (Time < AudioLastTime);
+
+	AudioLastTime = Time;
+
+	if (AudioState == EStreamState::Waiting)
+	{
+		if (!Wrapped || (Time > CoverageTolerance))
+		{
+			return;
+		}
+
+		AudioState = EStreamState::Recording;
+	}
+	else if ((AudioState == EStreamState::Complete) || Wrapped)
+	{
+		AudioState = EStreamState::Complete;
+		return;
+	}
+
+	const SIZE_T BufferSize = (SIZE_T)NumFrames * AudioChannels * AudioSampleSize;
+
+	if (!AddBytes(BufferSize))
+	{
+		return;
+	}
+
+	TSharedRef<FVlcMediaAudioSample, ESPMode::ThreadSafe> Sample = MakeShareable(new FVlcMediaAudioSample);
+	{
+		Sample->ReserveBuffer(BufferSize);
+		FMemory::Memcpy(Sample->GetMutableBuffer(), Buffer, BufferSize);
+		Sample->Initialize(NumFrames, AudioChannels, AudioSampleFormat, AudioSampleRate, Time, FTimespan((ETimespan::TicksPerSecond * NumFrames) / AudioSampleRate));
+	}
+
+	AudioSamples.Add(Sample);
+}
+
+
+void FVlcMediaLoopCache::RecordVideo(const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>& Sample)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (State != EVlcMediaLoopCacheState::Recording)
+	{
+		return;
+	}
+
+	const FTimespan Time = Sample->GetTime();
+	const bool Wrapped = (VideoLastTime != FTimespan::MinValue()) && (Time < VideoLastTime);
+
+	VideoLastTime = Time;
+
+	if (VideoState == EStreamState::Waiting)
+	{
+		if (!Wrapped || (Time > CoverageTolerance))
+		{
+			return;
+		}
+
+		VideoState = EStreamState::Recording;
+	}
+	else if ((VideoState == EStreamState::Complete) || Wrapped)
+	{
+		VideoState = EStreamState::Complete;
+		return;
+	}
+
+	if (AddBytes((SIZE_T)Sample->GetStride() * Sample->GetDim().Y))
+	{
+		VideoSamples.Add(Sample);
+	}
+}
+
+
+void FVlcMediaLoopCache::SetAudioFormat(uint32 Channels, EMediaAudioSampleFormat SampleFormat, uint32 SampleRate, uint32 SampleSize)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	AudioChannels = Channels;
+	AudioSampleFormat = SampleFormat;
+	AudioSampleRate = SampleRate;
+	AudioSampleSize = SampleSize;
+}
+
+
+void FVlcMediaLoopCache::SetBudget(SIZE_T InMaxBytes)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	EmptySamples();
+
+	MaxBytes = InMaxBytes;
+	Replaying = false;
+	State = EVlcMediaLoopCacheState::Idle;
+}
+
+
+void FVlcMediaLoopCache::SeekReplay(FTimespan Time)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	AudioCursor = VlcMediaLoopCache::FindSample(AudioSamples, Time);
+	VideoCursor = VlcMediaLoopCache::FindSample(VideoSamples, Time);
+}
+
+
+bool FVlcMediaLoopCache::StartReplay()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (State != EVlcMediaLoopCacheState::Complete)
+	{
+		return false;
+	}
+
+	AudioCursor = 0;
+	Replaying = true;
+	VideoCursor = 0;
+
+	return true;
+}
+
+
+void FVlcMediaLoopCache::StopReplay()
+{
+	FScopeLock Lock(&CriticalSection);
+	Replaying = false;
+}
+
+
+/* FVlcMediaLoopCache implementation
+ *****************************************************************************/
+
+bool FVlcMediaLoopCache::AddBytes(SIZE_T SampleBytes)
+{
+	if (NumBytes + SampleBytes <= MaxBytes)
+	{
+		NumBytes += SampleBytes;
+		return true;
+	}
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Loop cache %p: Media exceeds the budget of %.1f MB, decoding every loop"), this, MaxBytes / (1024.0 * 1024.0));
+
+	EmptySamples();
+	State = EVlcMediaLoopCacheState::Overflowed;
+
+	return false;
+}
+
+
+void FVlcMediaLoopCache::EmptySamples()
+{
+	AudioSamples.Empty();
+	VideoSamples.Empty();
+
+	AudioCursor = 0;
+	NumBytes = 0;
+	VideoCursor = 0;
+}
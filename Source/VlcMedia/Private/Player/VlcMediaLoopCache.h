@@ -0,0 +1,295 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "IMediaAudioSample.h"
+#include "Templates/SharedPointer.h"
+
+class FVlcMediaAudioSample;
+class IMediaTextureSample;
+
+
+/**
+ * Available states of the decoded-frame loop cache.
+ */
+enum class EVlcMediaLoopCacheState
+{
+	/** Disabled, or playback has not started yet. */
+	Idle,
+
+	/** Recording the samples of the current pass. */
+	Recording,
+
+	/** A full pass was recorded and can be replayed. */
+	Complete,
+
+	/** The media does not fit into the memory budget. */
+	Overflowed,
+};
+
+
+namespace VlcMedia
+{
+	/**
+	 * Convert a loop cache state to string.
+	 *
+	 * @param State The state to convert.
+	 * @return The corresponding string.
+	 */
+	const TCHAR* LoopCacheStateToString(EVlcMediaLoopCacheState State);
+}
+
+
+/**
+ * Keeps the decoded samples of one pass through a short looping media.
+ *
+ * During the first pass, every video sample and a copy of every audio chunk
+ * that VLC outputs is kept until the memory budget is exceeded. If the pass
+ * completes within the budget, later loops are served from the cache without
+ * decoding, and the cache hands out its samples in order until the end. The
+ * player seeks the replay back to the start when its clock wraps around.
+ * Media that exceed the budget are released and decoded as usual.
+ *
+ * This class is thread-safe.
+ */
+class FVlcMediaLoopCache
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaLoopCache();
+
+public:
+
+	/**
+	 * Start recording a new pass.
+	 *
+	 * Call this when playback starts at the beginning of the media. Does
+	 * nothing if the cache is disabled, complete, or overflowed.
+	 *
+	 * @see CancelRecording, FinishRecording
+	 */
+	void BeginRecording();
+
+	/**
+	 * Discard a pass that is being recorded, i.e. after seeking.
+	 *
+	 * Recording restarts when the streams wrap around to the start of the media.
+	 *
+	 * @see BeginRecording
+	 */
+	void CancelRecording();
+
+	/**
+	 * Remove and return the next cached audio sample if it overlaps the specified time range.
+	 *
+	 * @param TimeRange The range of time to fetch a sample for.
+	 * @param OutSample Will contain the sample.
+	 * @return true if a sample was returned, false otherwise.
+	 * @see FetchVideo, StartReplay
+	 */
+	bool FetchAudio(TRange<FTimespan> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample);
+
+	/**
+	 * Remove and return the next cached video sample if it overlaps the specified time range.
+	 *
+	 * @param TimeRange The range of time to fetch a sample for.
+	 * @param OutSample Will contain the sample.
+	 * @return true if a sample was returned, false otherwise.
+	 * @see FetchAudio, StartReplay
+	 */
+	bool FetchVideo(TRange<FTimespan> TimeRange, TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe>& OutSample);
+
+	/**
+	 * Complete the pass that is being recorded.
+	 *
+	 * Call this when playback wraps around at the end of the media. The pass
+	 * is complete if the recorded samples of each stream cover the entire
+	 * media. Otherwise recording continues with the next pass.
+	 *
+	 * @param Duration The duration of the media.
+	 * @return true if a full pass is cached, false otherwise.
+	 * @see BeginRecording, StartReplay
+	 */
+	bool FinishRecording(FTimespan Duration);
+
+	/**
+	 * Get the size of the cached samples.
+	 *
+	 * @return Cached size (in bytes).
+	 */
+	SIZE_T GetNumBytes() const;
+
+	/**
+	 * Get the current state of the cache.
+	 *
+	 * @return Cache state.
+	 */
+	EVlcMediaLoopCacheState GetState() const;
+
+	/**
+	 * Check whether the cache is enabled.
+	 *
+	 * @return true if enabled, false otherwise.
+	 * @see SetBudget
+	 */
+	bool IsEnabled() const;
+
+	/**
+	 * Check whether samples are served from the cache.
+	 *
+	 * @return true if replaying, false otherwise.
+	 * @see StartReplay
+	 */
+	bool IsReplaying() const;
+
+	/**
+	 * Record an audio chunk (called on the VLC audio thread).
+	 *
+	 * @param Buffer The audio frames.
+	 * @param NumFrames Number of frames in the buffer.
+	 * @param Time The time of the first frame (in the player's local clock).
+	 * @see RecordVideo, SetAudioFormat
+	 */
+	void RecordAudio(const void* Buffer, uint32 NumFrames, FTimespan Time);
+
+	/**
+	 * Record a video sample.
+	 *
+	 * @param Sample The sample to record (will be kept alive by the cache).
+	 * @see RecordAudio
+	 */
+	void RecordVideo(const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>& Sample);
+
+	/**
+	 * Set the format of audio chunks to be recorded (called on the VLC audio thread).
+	 *
+	 * @param Channels Number of audio channels.
+	 * @param SampleFormat The sample format.
+	 * @param SampleRate The sample rate.
+	 * @param SampleSize Size of a single sample (in bytes).
+	 * @see RecordAudio
+	 */
+	void SetAudioFormat(uint32 Channels, EMediaAudioSampleFormat SampleFormat, uint32 SampleRate, uint32 SampleSize);
+
+	/**
+	 * Enable or disable the cache.
+	 *
+	 * Any cached samples are released.
+	 *
+	 * @param InMaxBytes The memory budget (in bytes; 0 = disabled).
+	 * @see IsEnabled
+	 */
+	void SetBudget(SIZE_T InMaxBytes);
+
+	/**
+	 * Continue replaying with the samples at the specified time.
+	 *
+	 * @param Time The time to seek to.
+	 * @see StartReplay
+	 */
+	void SeekReplay(FTimespan Time);
+
+	/**
+	 * Start serving samples from the cache, beginning at the start of the media.
+	 *
+	 * @return true if replaying, false if no complete pass is cached.
+	 * @see FinishRecording, StopReplay
+	 */
+	bool StartReplay();
+
+	/**
+	 * Stop serving samples from the cache.
+	 *
+	 * The cached samples are kept for the next replay.
+	 *
+	 * @see StartReplay
+	 */
+	void StopReplay();
+
+public:
+
+	/** Maximum gap between the recorded samples and the start or end of the media. */
+	static const FTimespan CoverageTolerance;
+
+private:
+
+	/** Recording states of the audio and video streams. */
+	enum class EStreamState
+	{
+		/** Waiting for the stream to wrap around to the start of the media. */
+		Waiting,
+
+		/** Recording the stream's samples. */
+		Recording,
+
+		/** The stream started the next pass. */
+		Complete,
+	};
+
+	/**
+	 * Add to the cached size and check the budget (must hold the lock).
+	 *
+	 * @param SampleBytes Size of the sample being recorded (in bytes).
+	 * @return true if the sample fits into the budget, false if the cache overflowed.
+	 */
+	bool AddBytes(SIZE_T SampleBytes);
+
+	/** Release all cached samples (must hold the lock). */
+	void EmptySamples();
+
+private:
+
+	/** Number of audio channels of recorded chunks. */
+	uint32 AudioChannels;
+
+	/** Index of the next audio sample to replay. */
+	int32 AudioCursor;
+
+	/** Time of the most recent audio chunk (MinValue = none). */
+	FTimespan AudioLastTime;
+
+	/** Recorded audio samples (in play order). */
+	TArray<TSharedRef<FVlcMediaAudioSample, ESPMode::ThreadSafe>> AudioSamples;
+
+	/** Sample format of recorded chunks. */
+	EMediaAudioSampleFormat AudioSampleFormat;
+
+	/** Sample rate of recorded chunks. */
+	uint32 AudioSampleRate;
+
+	/** Size of a single audio sample (in bytes). */
+	uint32 AudioSampleSize;
+
+	/** Recording state of the audio stream. */
+	EStreamState AudioState;
+
+	/** Critical section for synchronizing access to all fields. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Memory budget (in bytes; 0 = disabled). */
+	SIZE_T MaxBytes;
+
+	/** Size of the cached samples (in bytes). */
+	SIZE_T NumBytes;
+
+	/** Whether samples are served from the cache. */
+	bool Replaying;
+
+	/** The current state. */
+	EVlcMediaLoopCacheState State;
+
+	/** Index of the next video sample to replay. */
+	int32 VideoCursor;
+
+	/** Time of the most recent video sample (MinValue = none). */
+	FTimespan VideoLastTime;
+
+	/** Recorded video samples (in play order). */
+	TArray<TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>> VideoSamples;
+
+	/** Recording state of the video stream. */
+	EStreamState VideoState;
+};
@@ -0,0 +1,304 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaOpenTask.h"
+#include "VlcMediaPrivate.h"
+
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+#include "Vlc.h"
+#include "VlcMediaCachedFile.h"
+#include "VlcMediaFileCache.h"
+#include "VlcMediaPlayerPool.h"
+#include "VlcMediaPrecacheArchive.h"
+#include "VlcMediaSource.h"
+
+
+/* FVlcMediaOpenTask static initialization
+ *****************************************************************************/
+
+const FTimespan FVlcMediaOpenTask::ParseStopTimeout = FTimespan::FromSeconds(2.0);
+const FTimespan FVlcMediaOpenTask::ParseTimeout = FTimespan::FromSeconds(5.0);
+
+
+/* FVlcMediaOpenTask structors
+ *****************************************************************************/
+
+FVlcMediaOpenTask::FVlcMediaOpenTask(FLibvlcInstance* InVlcInstance, const FString& InUrl, const TSharedPtr<FArchive, ESPMode::ThreadSafe>& InArchive, bool InPrecache, bool InAudioOnly)
+	: Archive(InArchive)
+	, AudioOnly(InAudioOnly)
+	, Canceled(false)
+	, Done(false)
+	, Duration(FTimespan::Zero())
+	, MediaSource(MakeShareable(new FVlcMediaSource(InVlcInstance)))
+	, ParseAttached(false)
+	, Parsed(false)
+	, ParsedEvent(FPlatformProcess::GetSynchEventFromPool(true))
+	, Player(nullptr)
+	, Precache(InPrecache)
+	, Url(InUrl)
+{ }
+
+
+FVlcMediaOpenTask::~FVlcMediaOpenTask()
+{
+	if (ParseAttached)
+	{
+		FVlc::EventDetach(FVlc::MediaEventManager(MediaSource->GetMedia()), ELibvlcEventType::MediaParsedChanged, &FVlcMediaOpenTask::StaticEventCallback, this);
+	}
+
+	if (Player != nullptr)
+	{
+		FVlcMediaPlayerPool::Get().Release(Player);
+		Player = nullptr;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(ParsedEvent);
+}
+
+
+/* FVlcMediaOpenTask interface
+ *****************************************************************************/
+
+FLibvlcMediaPlayer* FVlcMediaOpenTask::DetachPlayer()
+{
+	check(Done);
+
+	FLibvlcMediaPlayer* DetachedPlayer = Player;
+	Player = nullptr;
+
+	return DetachedPlayer;
+}
+
+
+TSharedPtr<FVlcMediaPrecacheArchive, ESPMode::ThreadSafe> FVlcMediaOpenTask::GetPrecacheArchive() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return PrecacheArchive;
+}
+
+
+void FVlcMediaOpenTask::Start()
+{
+	TSharedRef<FVlcMediaOpenTask, ESPMode::ThreadSafe> Task = AsShared();
+
+	// runs on its own thread, because opening network media may block for a long time
+	Async<void>(EAsyncExecution::Thread, [Task]()
+	{
+		Task->Run();
+	});
+}
+
+
+/* FVlcMediaOpenTask implementation
+ *****************************************************************************/
+
+bool FVlcMediaOpenTask::CreatePlayer()
+{
+	// disable video elementary streams, so that no video decoder or output is created
+	if (AudioOnly)
+	{
+		FVlc::MediaAddOption(MediaSource->GetMedia(), ":no-video");
+	}
+
+	// reuse a pooled player if possible
+	Player = FVlcMediaPlayerPool::Get().Acquire();
+
+	if (Player != nullptr)
+	{
+		FVlc::MediaPlayerSetMedia(Player, MediaSource->GetMedia());
+	}
+	else
+	{
+		Player = FVlc::MediaPlayerNewFromMedia(MediaSource->GetMedia());
+	}
+
+	if (Player == nullptr)
+	{
+		UE_LOG(LogVlcMedia, Warning, TEXT("Failed to initialize media player: %s"), ANSI_TO_TCHAR(FVlc::Errmsg()));
+		return false;
+	}
+
+	return true;
+}
+
+
+bool FVlcMediaOpenTask::OpenSource()
+{
+	if (Archive.IsValid())
+	{
+		return (MediaSource->OpenArchive(Archive.ToSharedRef(), Url, true) != nullptr);
+	}
+
+	if (!Url.StartsWith(TEXT("file://")))
+	{
+		return (MediaSource->OpenUrl(Url) != nullptr);
+	}
+
+	// open local files via platform file system
+	const TCHAR* FilePath = &Url[7];
+
+	if (Precache)
+	{
+		// load file in the background, or share the copy of another player
+		TSharedPtr<FVlcMediaCachedFile, ESPMode::ThreadSafe> File = FVlcMediaFileCache::Get().Load(FilePath);
+
+		if (!File.IsValid())
+		{
+			UE_LOG(LogVlcMedia, Warning, TEXT("Failed to open media file: %s"), FilePath);
+			return false;
+		}
+
+		TSharedRef<FVlcMediaPrecacheArchive, ESPMode::ThreadSafe> FileArchive = MakeShareable(new FVlcMediaPrecacheArchive(File.ToSharedRef()));
+		{
+			FScopeLock Lock(&CriticalSection);
+			PrecacheArchive = FileArchive;
+		}
+
+		// wait until enough data is resident
+		const int64 StartBytes = (int64)FMath::Max(0, GetDefault<UVlcMediaSettings>()->PrecacheStartMegabytes) * 1024 * 1024;
+
+		while (!Canceled && !File->HasFailed() && !File->IsComplete() && (File->GetNumLoadedBytes() < StartBytes))
+		{
+			FPlatformProcess::Sleep(0.01f);
+		}
+
+		if (File->HasFailed())
+		{
+			UE_LOG(LogVlcMedia, Warning, TEXT("Failed to precache media file: %s"), FilePath);
+			return false;
+		}
+
+		return !Canceled && (MediaSource->OpenArchive(FileArchive, Url, false) != nullptr);
+	}
+
+	// memory map files if possible, so reads are served from the shared page cache
+	if (MediaSource->OpenMappedFile(FilePath, Url) != nullptr)
+	{
+		return true;
+	}
+
+	FArchive* FileReader = IFileManager::Get().CreateFileReader(FilePath);
+
+	if (FileReader == nullptr)
+	{
+		UE_LOG(LogVlcMedia, Warning, TEXT("Failed to open media file: %s"), FilePath);
+		return false;
+	}
+
+	return (MediaSource->OpenArchive(MakeShareable(FileReader), Url, true) != nullptr);
+}
+
+
+bool FVlcMediaOpenTask::ParseMedia()
+{
+	FLibvlcEventManager* MediaEventManager = FVlc::MediaEventManager(MediaSource->GetMedia());
+
+	if (MediaEventManager == nullptr)
+	{
+		return !Canceled;
+	}
+
+	FVlc::EventAttach(MediaEventManager, ELibvlcEventType::MediaParsedChanged, &FVlcMediaOpenTask::StaticEventCallback, this);
+	ParseAttached = true;
+
+	FVlc::MediaParseAsync(MediaSource->GetMedia());
+
+	// wait in slices, so that canceling does not have to wait for the timeout
+	const double TimeoutTime = FPlatformTime::Seconds() + ParseTimeout.GetTotalSeconds();
+
+	while (!Canceled && !Parsed && (FPlatformTime::Seconds() < TimeoutTime))
+	{
+		ParsedEvent->Wait(10);
+	}
+
+	if (Parsed)
+	{
+		return !Canceled;
+	}
+
+	// the player must not read the media source while the parser still does
+	if (!Canceled)
+	{
+		UE_LOG(LogVlcMedia, Verbose, TEXT("Open task %p: Media not parsed after %.1f seconds, stopping parser"), this, ParseTimeout.GetTotalSeconds());
+	}
+
+	FVlc::MediaParseStop(MediaSource->GetMedia());
+
+	// the parsed event is also sent when the parser was stopped
+	const double StopTimeoutTime = FPlatformTime::Seconds() + ParseStopTimeout.GetTotalSeconds();
+
+	while (!Parsed && (FPlatformTime::Seconds() < StopTimeoutTime))
+	{
+		ParsedEvent->Wait(10);
+	}
+
+	if (!Parsed)
+	{
+		UE_LOG(LogVlcMedia, Warning, TEXT("Open task %p: Media parser did not stop: %s"), this, *Url);
+		return false;
+	}
+
+	return !Canceled;
+}
+
+
+void FVlcMediaOpenTask::Run()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (OpenSource() && !Canceled)
+	{
+		SetKeyframeFile();
+
+		if (ParseMedia() && !Canceled)
+		{
+			CreatePlayer();
+		}
+	}
+
+	Duration = FTimespan::FromSeconds(FPlatformTime::Seconds() - StartTime);
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Open task %p: %s %s in %.1f ms"), this,
+		Canceled ? TEXT("Canceled") : ((Player != nullptr) ? TEXT("Opened") : TEXT("Failed to open")),
+		*Url,
+		Duration.GetTotalMilliseconds()
+	);
+
+	Done = true;
+}
+
+
+void FVlcMediaOpenTask::SetKeyframeFile()
+{
+	// only local files can be read independently of the media's input; the index
+	// is built on demand, because it is needed for fast seeks only
+	if (!Archive.IsValid() && Url.StartsWith(TEXT("file://")))
+	{
+		MediaSource->SetKeyframeFile(&Url[7]);
+	}
+}
+
+
+/* FVlcMediaOpenTask static functions
+ *****************************************************************************/
+
+void FVlcMediaOpenTask::StaticEventCallback(FLibvlcEvent* Event, void* UserData)
+{
+	if ((Event == nullptr) || (UserData == nullptr))
+	{
+		return;
+	}
+
+	if (Event->Type == ELibvlcEventType::MediaParsedChanged)
+	{
+		auto Task = (FVlcMediaOpenTask*)UserData;
+
+		Task->Parsed = true;
+		Task->ParsedEvent->Trigger();
+	}
+}
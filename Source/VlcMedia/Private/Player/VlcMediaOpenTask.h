@@ -0,0 +1,244 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Templates/SharedPointer.h"
+
+class FArchive;
+class FEvent;
+class FVlcMediaPrecacheArchive;
+class FVlcMediaSource;
+
+struct FLibvlcEvent;
+struct FLibvlcInstance;
+struct FLibvlcMediaPlayer;
+
+
+/**
+ * Opens a media source and creates its VLC player on a worker thread.
+ *
+ * The task creates the media source, waits for precached files to become
+ * resident, parses the media and creates the player. Once it is done, the
+ * game thread takes over the media source and player. If the task is canceled
+ * or the results are not taken, the task releases them itself.
+ */
+class FVlcMediaOpenTask
+	: public TSharedFromThis<FVlcMediaOpenTask, ESPMode::ThreadSafe>
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InVlcInstance The LibVLC instance to use.
+	 * @param InUrl The URL of the media to open.
+	 * @param InArchive The archive to read the media from (optional).
+	 * @param InPrecache Whether to precache local files in memory.
+	 * @param InAudioOnly Whether to disable the video elementary streams.
+	 */
+	FVlcMediaOpenTask(FLibvlcInstance* InVlcInstance, const FString& InUrl, const TSharedPtr<FArchive, ESPMode::ThreadSafe>& InArchive, bool InPrecache, bool InAudioOnly);
+
+	/** Destructor. */
+	~FVlcMediaOpenTask();
+
+public:
+
+	/**
+	 * Cancel the task.
+	 *
+	 * The worker stops at the next opportunity and releases everything it created.
+	 *
+	 * @see IsCanceled
+	 */
+	void Cancel()
+	{
+		Canceled = true;
+	}
+
+	/**
+	 * Take ownership of the created player.
+	 *
+	 * Must only be called after the task is done.
+	 *
+	 * @return The player, or nullptr if the task failed.
+	 * @see GetMediaSource, IsDone
+	 */
+	FLibvlcMediaPlayer* DetachPlayer();
+
+	/**
+	 * Get the time that the task took.
+	 *
+	 * @return Open time.
+	 */
+	FTimespan GetDuration() const
+	{
+		return Duration;
+	}
+
+	/**
+	 * Get the opened media source.
+	 *
+	 * Must only be called after the task is done.
+	 *
+	 * @return The media source.
+	 * @see DetachPlayer, IsDone
+	 */
+	const TSharedRef<FVlcMediaSource, ESPMode::ThreadSafe>& GetMediaSource() const
+	{
+		return MediaSource;
+	}
+
+	/**
+	 * Get the archive of the precached file being loaded.
+	 *
+	 * @return The archive, or nullptr if the file is not being precached (yet).
+	 */
+	TSharedPtr<FVlcMediaPrecacheArchive, ESPMode::ThreadSafe> GetPrecacheArchive() const;
+
+	/**
+	 * Get the URL of the media being opened.
+	 *
+	 * @return Media URL.
+	 */
+	const FString& GetUrl() const
+	{
+		return Url;
+	}
+
+	/**
+	 * Check whether the task was canceled.
+	 *
+	 * @return true if canceled, false otherwise.
+	 * @see Cancel
+	 */
+	bool IsCanceled() const
+	{
+		return Canceled;
+	}
+
+	/**
+	 * Check whether the task finished running.
+	 *
+	 * @return true if done, false otherwise.
+	 * @see Succeeded
+	 */
+	bool IsDone() const
+	{
+		return Done;
+	}
+
+	/**
+	 * Check whether the media finished parsing.
+	 *
+	 * The media's parsed event may have been sent before the game thread
+	 * attached to it, so it needs to handle the parsed media right away.
+	 *
+	 * @return true if parsed, false otherwise.
+	 */
+	bool IsParsed() const
+	{
+		return Parsed;
+	}
+
+	/**
+	 * Start running the task on a worker thread.
+	 *
+	 * @see Cancel
+	 */
+	void Start();
+
+	/**
+	 * Check whether the media was opened successfully.
+	 *
+	 * @return true on success, false otherwise.
+	 * @see IsDone
+	 */
+	bool Succeeded() const
+	{
+		return Done && (Player != nullptr);
+	}
+
+public:
+
+	/** Maximum time to wait for the parser to stop after the parse timed out. */
+	static const FTimespan ParseStopTimeout;
+
+	/** Maximum time to wait for the media to be parsed. */
+	static const FTimespan ParseTimeout;
+
+protected:
+
+	/** Create the player. */
+	bool CreatePlayer();
+
+	/** Open the media source. */
+	bool OpenSource();
+
+	/**
+	 * Parse the media and wait for it to finish.
+	 *
+	 * The parser reads through the media source's callbacks, which only
+	 * support one reader, so it is stopped if it does not finish in time.
+	 *
+	 * @return true if the parser finished or was stopped, false if it is still running or the task was canceled.
+	 */
+	bool ParseMedia();
+
+	/** Run the task (on the worker thread). */
+	void Run();
+
+	/** Remember the local file that the keyframe index can be built from. */
+	void SetKeyframeFile();
+
+private:
+
+	/** Handles event callbacks. */
+	static void StaticEventCallback(FLibvlcEvent* Event, void* UserData);
+
+private:
+
+	/** The archive to read the media from (optional). */
+	TSharedPtr<FArchive, ESPMode::ThreadSafe> Archive;
+
+	/** Whether to disable the video elementary streams. */
+	bool AudioOnly;
+
+	/** Whether the task was canceled. */
+	FThreadSafeBool Canceled;
+
+	/** Critical section for synchronizing access to PrecacheArchive. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Whether the task finished running. */
+	FThreadSafeBool Done;
+
+	/** Time that the task took. */
+	FTimespan Duration;
+
+	/** The media source being opened. */
+	TSharedRef<FVlcMediaSource, ESPMode::ThreadSafe> MediaSource;
+
+	/** Whether the task is attached to the media's event manager. */
+	bool ParseAttached;
+
+	/** Whether the media finished parsing. */
+	FThreadSafeBool Parsed;
+
+	/** Event that signals that the media finished parsing. */
+	FEvent* ParsedEvent;
+
+	/** The created player (until detached). */
+	FLibvlcMediaPlayer* Player;
+
+	/** Whether to precache local files in memory. */
+	bool Precache;
+
+	/** The archive of the precached file (if precaching). */
+	TSharedPtr<FVlcMediaPrecacheArchive, ESPMode::ThreadSafe> PrecacheArchive;
+
+	/** The URL of the media being opened. */
+	FString Url;
+};
@@ -5,23 +5,56 @@
 
 #include "IMediaEventSink.h"
 #include "IMediaOptions.h"
-#include "Misc/FileHelper.h"
-#include "Serialization/ArrayReader.h"
 
 #include "Vlc.h"
+#include "VlcMediaFileCache.h"
+#include "VlcMediaKeyframeIndex.h"
+#include "VlcMediaLoopCache.h"
+#include "VlcMediaPlayerPool.h"
+#include "VlcMediaPreroll.h"
+#include "VlcMediaReaper.h"
 #include "VlcMediaUtils.h"
 
 
+/* FVlcMediaPlayer static initialization
+ *****************************************************************************/
+
+const FTimespan FVlcMediaPlayer::ScrubSeekTimeout = FTimespan::FromMilliseconds(250.0);
+
+
 /* FVlcMediaPlayer structors
  *****************************************************************************/
 
 FVlcMediaPlayer::FVlcMediaPlayer(IMediaEventSink& InEventSink, FLibvlcInstance* InVlcInstance)
-	: CurrentRate(0.0f)
-	, CurrentTime(FTimespan::Zero())
+	: Callbacks(MakeShareable(new FVlcMediaCallbacks))
+	, CurrentRate(0.0f)
 	, EventSink(InEventSink)
-	, MediaSource(InVlcInstance)
+	, FadeDuration(FTimespan::Zero())
+	, FadeStartCycles(0)
+	, FadingPlayer(nullptr)
+	, HandoverRate(0.0f)
+	, InputRepeating(false)
+	, NumCachedLoops(0)
+	, NumGaplessLoops(0)
+	, NumHandovers(0)
+	, NumRestartedLoops(0)
+	, NumScrubRequests(0)
+	, NumScrubSeeks(0)
+	, OpenLatency(FTimespan::Zero())
+	, OpenStartCycles(0)
+	, OpenTaskDuration(FTimespan::Zero())
 	, Player(nullptr)
+	, PrecacheReportedPercent(0)
+	, SeekMode(GetDefault<UVlcMediaSettings>()->SeekMode)
+	, SeekStartCycles(0)
+	, SeekStartMode(SeekMode)
+	, SeekStartScrub(false)
+	, ScrubPending(false)
+	, ScrubResumeRate(0.0f)
+	, Scrubbing(false)
+	, ScrubTime(FTimespan::Zero())
 	, ShouldLoop(false)
+	, VlcInstance(InVlcInstance)
 { }
 
 
@@ -41,6 +74,22 @@ bool FVlcMediaPlayer::CanControl(EMediaControl Control) const
 		return false;
 	}
 
+	// the VLC player is idle while replaying from the loop cache
+	if (Callbacks->GetLoopCache().IsReplaying())
+	{
+		if (Control == EMediaControl::Pause)
+		{
+			return (CurrentRate != 0.0f);
+		}
+
+		if (Control == EMediaControl::Resume)
+		{
+			return (CurrentRate == 0.0f);
+		}
+
+		return ((Control == EMediaControl::Scrub) || (Control == EMediaControl::Seek));
+	}
+
 	if (Control == EMediaControl::Pause)
 	{
 		return (FVlc::MediaPlayerCanPause(Player) != 0);
@@ -62,7 +111,7 @@ bool FVlcMediaPlayer::CanControl(EMediaControl Control) const
 
 FTimespan FVlcMediaPlayer::GetDuration() const
 {
-	return MediaSource.GetDuration();
+	return MediaSource.IsValid() ? MediaSource->GetDuration() : FTimespan::Zero();
 }
 
 
@@ -76,7 +125,12 @@ EMediaState FVlcMediaPlayer::GetState() const
 {
 	if (Player == nullptr)
 	{
-		return EMediaState::Closed;
+		return OpenTask.IsValid() ? EMediaState::Preparing : EMediaState::Closed;
+	}
+
+	if (Callbacks->GetLoopCache().IsReplaying())
+	{
+		return (CurrentRate != 0.0f) ? EMediaState::Playing : EMediaState::Paused;
 	}
 
 	ELibvlcState State = FVlc::MediaPlayerGetState(Player);
@@ -131,7 +185,7 @@ TRangeSet<float> FVlcMediaPlayer::GetSupportedRates(EMediaRateThinning Thinning)
 
 FTimespan FVlcMediaPlayer::GetTime() const
 {
-	return CurrentTime;
+	return Clock.GetTime();
 }
 
 
@@ -143,6 +197,21 @@ bool FVlcMediaPlayer::IsLooping() const
 
 bool FVlcMediaPlayer::Seek(const FTimespan& Time)
 {
+	if (Player == nullptr)
+	{
+		return false;
+	}
+
+	FVlcMediaLoopCache& LoopCache = Callbacks->GetLoopCache();
+
+	if (LoopCache.IsReplaying())
+	{
+		LoopCache.SeekReplay(Time);
+		Clock.Reset(Time);
+
+		return true;
+	}
+
 	ELibvlcState State = FVlc::MediaPlayerGetState(Player);
 
 	if ((State == ELibvlcState::Opening) ||
@@ -152,10 +221,19 @@ bool FVlcMediaPlayer::Seek(const FTimespan& Time)
 		return false;
 	}
 
-	if (Time != CurrentTime)
+	if (Scrubbing)
+	{
+		// only the most recent request is started once the previous seek was output
+		ScrubPending = true;
+		ScrubTime = Time;
+		++NumScrubRequests;
+
+		return true;
+	}
+
+	if (Time != Clock.GetTime())
 	{
-		FVlc::MediaPlayerSetTime(Player, Time.GetTotalMilliseconds());
-		CurrentTime = Time;
+		StartSeek(Time, SeekMode, false);
 	}
 
 	return true;
@@ -176,6 +254,23 @@ bool FVlcMediaPlayer::SetRate(float Rate)
 		return false;
 	}
 
+	FVlcMediaLoopCache& LoopCache = Callbacks->GetLoopCache();
+
+	if (LoopCache.IsReplaying())
+	{
+		const bool WasPaused = (CurrentRate == 0.0f);
+
+		CurrentRate = FMath::IsNearlyZero(Rate) ? 0.0f : Rate;
+		Clock.SetRate(CurrentRate);
+
+		if (WasPaused != (CurrentRate == 0.0f))
+		{
+			EventSink.ReceiveMediaEvent(WasPaused ? EMediaEvent::PlaybackResumed : EMediaEvent::PlaybackSuspended);
+		}
+
+		return true;
+	}
+
 	if ((FVlc::MediaPlayerSetRate(Player, Rate) == -1))
 	{
 		return false;
@@ -195,6 +290,29 @@ bool FVlcMediaPlayer::SetRate(float Rate)
 	}
 	else if (FVlc::MediaPlayerGetState(Player) != ELibvlcState::Playing)
 	{
+		// resuming from pause keeps the current input
+		if (FVlc::MediaPlayerGetState(Player) != ELibvlcState::Paused)
+		{
+			// a completely cached media plays again without decoding
+			if (LoopCache.StartReplay())
+			{
+				Clock.Reset(FTimespan::Zero());
+				Clock.SetRate(Rate);
+				CurrentRate = Rate;
+
+				EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackResumed);
+
+				return true;
+			}
+
+			UpdateInputRepeat();
+
+			if (ShouldLoop)
+			{
+				LoopCache.BeginRecording();
+			}
+		}
+
 		if (FVlc::MediaPlayerPlay(Player) == -1)
 		{
 			return false;
@@ -210,26 +328,58 @@ bool FVlcMediaPlayer::SetRate(float Rate)
 
 void FVlcMediaPlayer::Close()
 {
-	if (Player == nullptr)
+	if ((Player == nullptr) && !OpenTask.IsValid())
 	{
 		return;
 	}
 
-	// detach callback handlers
-	Callbacks.Shutdown();
-	Tracks.Shutdown();
-	View.Shutdown();
+	// cancel pending open (the task releases what it created)
+	if (OpenTask.IsValid())
+	{
+		OpenTask->Cancel();
+		OpenTask.Reset();
+	}
 
-	// release player
-	FVlc::MediaPlayerStop(Player);
-	FVlc::MediaPlayerRelease(Player);
-	Player = nullptr;
+	// stop scrubbing without seeking or resuming
+	Scrubbing = false;
+	ScrubPending = false;
+	ScrubResumeRate = 0.0f;
+
+	// release queued media and the player that is fading out
+	NextMedia.Reset();
+	HandoverRate = 0.0f;
+	EndCrossfade();
+
+	if (Player != nullptr)
+	{
+		// detach event handlers
+		DetachEvents();
+		Tracks.Shutdown();
+		View.Shutdown();
+
+		// stop and release player in the background; the callbacks and
+		// media source must stay alive until the player is released
+		FVlcMediaReaper::Get().Reap(Player, Callbacks, MediaSource);
+		Player = nullptr;
+
+		Callbacks = MakeShareable(new FVlcMediaCallbacks);
+	}
+
+	// release media source (stops loading a precached file)
+	PrecacheArchive.Reset();
+	MediaSource.Reset();
+	PrecacheReportedPercent = 0;
 
 	// reset fields
+	Events.Empty();
+	Clock.Reset(FTimespan::Zero());
+	Clock.SetRate(0.0f);
 	CurrentRate = 0.0f;
-	CurrentTime = FTimespan::Zero();
-	MediaSource.Close();
 	Info.Empty();
+	InputRepeating = false;
+
+	// release precached files beyond the memory budget
+	FVlcMediaFileCache::Get().Trim();
 
 	// notify listeners
 	EventSink.ReceiveMediaEvent(EMediaEvent::TracksChanged);
@@ -264,13 +414,18 @@ FName FVlcMediaPlayer::GetPlayerName() const
 
 IMediaSamples& FVlcMediaPlayer::GetSamples()
 {
-	return Callbacks.GetSamples();
+	return Callbacks->GetSamples();
 }
 
 
 FString FVlcMediaPlayer::GetStats() const
 {
-	FLibvlcMedia* Media = MediaSource.GetMedia();
+	if (OpenTask.IsValid())
+	{
+		return TEXT("Opening media.");
+	}
+
+	FLibvlcMedia* Media = MediaSource.IsValid() ? MediaSource->GetMedia() : nullptr;
 
 	if (Media == nullptr)
 	{
@@ -278,13 +433,14 @@ FString FVlcMediaPlayer::GetStats() const
 	}
 
 	FLibvlcMediaStats Stats;
-	
+	FString StatsString;
+
 	if (!FVlc::MediaGetStats(Media, &Stats))
 	{
-		return TEXT("Stats currently not available.");
+		StatsString += TEXT("Stats currently not available.\n");
+		StatsString += TEXT("\n");
 	}
-
-	FString StatsString;
+	else
 	{
 		StatsString += TEXT("General\n");
 		StatsString += FString::Printf(TEXT("    Decoded Video: %i\n"), Stats.DecodedVideo);
@@ -314,6 +470,80 @@ FString FVlcMediaPlayer::GetStats() const
 		StatsString += TEXT("\n");
 	}
 
+	if (PrecacheArchive.IsValid())
+	{
+		const int64 LoadedBytes = PrecacheArchive->GetNumLoadedBytes();
+		const int64 TotalBytes = PrecacheArchive->TotalSize();
+
+		StatsString += TEXT("Precache\n");
+		StatsString += FString::Printf(TEXT("    Loaded: %.1f of %.1f MB (%i%%)\n"), LoadedBytes / (1024.0 * 1024.0), TotalBytes / (1024.0 * 1024.0), (int32)(LoadedBytes * 100 / FMath::Max<int64>(1, TotalBytes)));
+		StatsString += FString::Printf(TEXT("    Direct Reads: %i\n"), PrecacheArchive->GetNumDirectReads());
+		StatsString += FString::Printf(TEXT("    Shared By: %i players\n"), PrecacheArchive->GetNumShares());
+		StatsString += FString::Printf(TEXT("    Cache Size: %.1f MB\n"), FVlcMediaFileCache::Get().GetNumBytes() / (1024.0 * 1024.0));
+		StatsString += TEXT("\n");
+	}
+
+	StatsString += TEXT("Open\n");
+	StatsString += FString::Printf(TEXT("    Open Task: %.1f ms\n"), OpenTaskDuration.GetTotalMilliseconds());
+	StatsString += FString::Printf(TEXT("    Open to First Sample: %s\n"), (OpenStartCycles == 0) ? *FString::Printf(TEXT("%.1f ms"), OpenLatency.GetTotalMilliseconds()) : TEXT("pending"));
+	StatsString += FString::Printf(TEXT("    Pooled Players: %i idle\n"), FVlcMediaPlayerPool::Get().GetNumIdle());
+	StatsString += FString::Printf(TEXT("    Next Media: %s\n"), !NextMedia.IsValid() ? TEXT("none") : NextMedia->IsReady() ? TEXT("ready") : TEXT("opening"));
+	StatsString += FString::Printf(TEXT("    Handovers: %i%s\n"), NumHandovers, (FadingPlayer != nullptr) ? TEXT(" (crossfading)") : TEXT(""));
+	StatsString += TEXT("\n");
+
+	const FVlcMediaLoopCache& LoopCache = Callbacks->GetLoopCache();
+
+	if (LoopCache.IsEnabled())
+	{
+		StatsString += TEXT("Loop Cache\n");
+		StatsString += FString::Printf(TEXT("    State: %s%s\n"), VlcMedia::LoopCacheStateToString(LoopCache.GetState()), LoopCache.IsReplaying() ? TEXT(" (replaying)") : TEXT(""));
+		StatsString += FString::Printf(TEXT("    Size: %.1f MB\n"), LoopCache.GetNumBytes() / (1024.0 * 1024.0));
+		StatsString += FString::Printf(TEXT("    Cached Loops: %i\n"), NumCachedLoops);
+		StatsString += TEXT("\n");
+	}
+
+	const TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe>& KeyframeIndex = MediaSource->GetKeyframeIndex();
+
+	StatsString += TEXT("Seek\n");
+	StatsString += FString::Printf(TEXT("    Mode: %s\n"), *VlcMedia::SeekModeToString(SeekMode));
+	StatsString += FString::Printf(TEXT("    Keyframe Index: %s\n"), KeyframeIndex.IsValid() ? *FString::Printf(TEXT("%i keyframes"), KeyframeIndex->Num()) : TEXT("not available"));
+
+	// scrub seeks are listed last, because they snap to keyframes regardless of the seek mode
+	for (int32 ModeIndex = 0; ModeIndex <= ARRAY_COUNT(SeekStats); ++ModeIndex)
+	{
+		const bool ScrubIndex = (ModeIndex == ARRAY_COUNT(SeekStats));
+		const FSeekStats& ModeStats = ScrubIndex ? ScrubSeekStats : SeekStats[ModeIndex];
+		const FString ModeName = ScrubIndex ? TEXT("Scrub") : VlcMedia::SeekModeToString((EVlcMediaSeekMode)ModeIndex);
+
+		if (ModeStats.Count == 0)
+		{
+			StatsString += FString::Printf(TEXT("    %s Latency: n/a\n"), *ModeName);
+		}
+		else
+		{
+			StatsString += FString::Printf(TEXT("    %s Latency: %.1f ms (average %.1f ms, max %.1f ms over %i seeks)\n"),
+				*ModeName,
+				ModeStats.Last.GetTotalMilliseconds(),
+				ModeStats.Total.GetTotalMilliseconds() / ModeStats.Count,
+				ModeStats.Max.GetTotalMilliseconds(),
+				ModeStats.Count
+			);
+		}
+	}
+
+	StatsString += FString::Printf(TEXT("    Scrubbing: %i requests, %i seeks%s\n"), NumScrubRequests, NumScrubSeeks, Scrubbing ? TEXT(" (scrubbing)") : TEXT(""));
+	StatsString += TEXT("\n");
+
+	StatsString += TEXT("Clock\n");
+	StatsString += FString::Printf(TEXT("    Master: %s\n"), Clock.IsSynchronized() ? TEXT("Audio") : TEXT("Wall Clock"));
+	StatsString += FString::Printf(TEXT("    A/V Offset: %.1f ms (max %.1f ms)\n"), Clock.GetOffset().GetTotalMilliseconds(), Clock.GetMaxOffset().GetTotalMilliseconds());
+	StatsString += FString::Printf(TEXT("    Resyncs: %i\n"), Clock.GetNumResyncs());
+	StatsString += FString::Printf(TEXT("    Loops: %i gapless, %i restarted\n"), NumGaplessLoops, NumRestartedLoops);
+	StatsString += TEXT("\n");
+
+	StatsString += MediaSource->GetStats();
+	StatsString += Callbacks->GetStats();
+
 	return StatsString;
 }
 
@@ -326,7 +556,12 @@ IMediaTracks& FVlcMediaPlayer::GetTracks()
 
 FString FVlcMediaPlayer::GetUrl() const
 {
-	return MediaSource.GetCurrentUrl();
+	if (OpenTask.IsValid())
+	{
+		return OpenTask->GetUrl();
+	}
+
+	return MediaSource.IsValid() ? MediaSource->GetCurrentUrl() : FString();
 }
 
 
@@ -345,65 +580,55 @@ bool FVlcMediaPlayer::Open(const FString& Url, const IMediaOptions* Options)
 		return false;
 	}
 
-	if (Url.StartsWith(TEXT("file://")))
-	{
-		// open local files via platform file system
-		TSharedPtr<FArchive, ESPMode::ThreadSafe> Archive;
-		const TCHAR* FilePath = &Url[7];
-
-		if ((Options != nullptr) && Options->GetMediaOption("PrecacheFile", false))
-		{
-			FArrayReader* Reader = new FArrayReader;
+	return StartOpen(Url, nullptr, Options);
+}
 
-			if (FFileHelper::LoadFileToArray(*Reader, FilePath))
-			{
-				Archive = MakeShareable(Reader);
-			}
-			else
-			{
-				delete Reader;
-			}
-		}
-		else
-		{
-			Archive = MakeShareable(IFileManager::Get().CreateFileReader(FilePath));
-		}
 
-		if (!Archive.IsValid())
-		{
-			UE_LOG(LogVlcMedia, Warning, TEXT("Failed to open media file: %s"), FilePath);
-			return false;
-		}
+bool FVlcMediaPlayer::Open(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, const IMediaOptions* Options)
+{
+	Close();
 
-		if (!MediaSource.OpenArchive(Archive.ToSharedRef(), Url))
-		{
-			return false;
-		}
-	}
-	else if (!MediaSource.OpenUrl(Url))
+	if (OriginalUrl.IsEmpty())
 	{
 		return false;
 	}
 
-	return InitializePlayer();
+	return StartOpen(OriginalUrl, Archive, Options);
 }
 
 
-bool FVlcMediaPlayer::Open(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, const IMediaOptions* /*Options*/)
+void FVlcMediaPlayer::TickInput(FTimespan /*DeltaTime*/, FTimespan /*Timecode*/)
 {
-	Close();
+	if (OpenTask.IsValid())
+	{
+		TSharedPtr<FVlcMediaPrecacheArchive, ESPMode::ThreadSafe> OpeningArchive = OpenTask->GetPrecacheArchive();
 
-	if (OriginalUrl.IsEmpty() || !MediaSource.OpenArchive(Archive, OriginalUrl))
+		if (OpeningArchive.IsValid())
+		{
+			UpdatePrecache(*OpeningArchive);
+		}
+
+		if (OpenTask->IsDone())
+		{
+			FinishOpen();
+		}
+	}
+	else if (PrecacheArchive.IsValid())
 	{
-		return false;
+		UpdatePrecache(*PrecacheArchive);
 	}
-	
-	return InitializePlayer();
-}
 
+	if (NextMedia.IsValid())
+	{
+		NextMedia->Tick();
+
+		if (NextMedia->HasFailed())
+		{
+			UE_LOG(LogVlcMedia, Warning, TEXT("Player %p: Skipping queued media %s"), this, *NextMedia->GetUrl());
+			CancelNext();
+		}
+	}
 
-void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
-{
 	if (Player == nullptr)
 	{
 		return;
@@ -418,24 +643,34 @@ void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
 		{
 		case ELibvlcEventType::MediaParsedChanged:
 			Tracks.Initialize(*Player, Info);
-			Callbacks.Initialize(*Player);
+			Callbacks->Initialize(*Player);
 			View.Initialize(*Player);
 			EventSink.ReceiveMediaEvent(EMediaEvent::TracksChanged);
 			break;
 
 		case ELibvlcEventType::MediaPlayerEndReached:
-			// begin hack: this causes a short delay, but there seems to be no
-			// other way. looping via VLC Media List players is also broken :(
+			// repeating inputs do not end, so this restarts the input only if looping
+			// was enabled during playback, or if the duration is unknown; looping
+			// via VLC Media List players is broken :(
 			FVlc::MediaPlayerStop(Player);
-			// end hack
 
-			Callbacks.GetSamples().FlushSamples();
+			Callbacks->GetSamples().FlushSamples();
 			EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackEndReached);
 
-			if (ShouldLoop && (CurrentRate != 0.0f))
+			if (NextMedia.IsValid())
+			{
+				// continue with the queued media as soon as it is ready
+				HandoverRate = (CurrentRate != 0.0f) ? CurrentRate : 1.0f;
+			}
+			else if (ShouldLoop && (CurrentRate != 0.0f))
 			{
-				CurrentTime = FTimespan::Zero();
-				SetRate(CurrentRate);
+				Clock.Reset(FTimespan::Zero());
+
+				if (!StartLoopReplay())
+				{
+					SetRate(CurrentRate);
+					++NumRestartedLoops;
+				}
 			}
 			else
 			{
@@ -444,7 +679,11 @@ void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
 			break;
 
 		case ELibvlcEventType::MediaPlayerPaused:
-			EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackSuspended);
+			// the VLC player is paused when replaying starts
+			if (!Callbacks->GetLoopCache().IsReplaying())
+			{
+				EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackSuspended);
+			}
 			break;
 
 		case ELibvlcEventType::MediaPlayerPlaying:
@@ -456,46 +695,457 @@ void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
 		}
 	}
 
+	if (Scrubbing)
+	{
+		TickScrub();
+	}
+
+	// switch over to the queued media when the current one ended, or when the crossfade starts
+	if (IsNextReady())
+	{
+		const FTimespan Duration = MediaSource->GetDuration();
+
+		if ((HandoverRate != 0.0f) ||
+			((CurrentRate != 0.0f) && (Duration > FTimespan::Zero()) && (Clock.GetTime() >= Duration - NextMedia->GetCrossfade())))
+		{
+			Handover();
+		}
+	}
+
 	const ELibvlcState State = FVlc::MediaPlayerGetState(Player);
 
 	// update current time & rate
-	if (State == ELibvlcState::Playing)
+	if (Callbacks->GetLoopCache().IsReplaying())
+	{
+		TickReplay();
+	}
+	else if (State == ELibvlcState::Playing)
 	{
 		CurrentRate = FVlc::MediaPlayerGetRate(Player);
-		CurrentTime += DeltaTime * CurrentRate;
+		Clock.SetRate(CurrentRate);
+
+		// the decoder's position is the master while audio is playing
+		if (Tracks.GetSelectedTrack(EMediaTrackType::Audio) != INDEX_NONE)
+		{
+			const int64 MasterTime = FVlc::MediaPlayerGetTime(Player);
+
+			if (MasterTime >= 0)
+			{
+				FTimespan Time = FTimespan::FromMilliseconds(MasterTime);
+
+				// the decoder and the clock wrap around at slightly different times
+				if (InputRepeating)
+				{
+					const FTimespan ClockTime = Clock.GetTime();
+					const FTimespan HalfDuration = MediaSource->GetDuration() / 2;
+
+					if (Time + HalfDuration < ClockTime)
+					{
+						Time += MediaSource->GetDuration();
+					}
+					else if (Time > ClockTime + HalfDuration)
+					{
+						Time -= MediaSource->GetDuration();
+					}
+				}
+
+				Clock.Synchronize(Time);
+			}
+		}
+
+		// VLC continues with the next iteration of a repeating input right away
+		if (InputRepeating && (Clock.GetTime() >= MediaSource->GetDuration()))
+		{
+			if (ShouldLoop && !NextMedia.IsValid())
+			{
+				Clock.Wrap(MediaSource->GetDuration());
+				EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackEndReached);
+
+				++NumGaplessLoops;
+
+				StartLoopReplay();
+			}
+			else
+			{
+				// looping was disabled, or media was queued, after the input started
+				FVlc::MediaPlayerStop(Player);
+				InputRepeating = false;
+
+				if (NextMedia.IsValid())
+				{
+					HandoverRate = CurrentRate;
+				}
+
+				Callbacks->SetLoopDuration(FTimespan::Zero());
+				Callbacks->GetSamples().FlushSamples();
+				Clock.SetRate(0.0f);
+				CurrentRate = 0.0f;
+
+				EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackEndReached);
+
+				if (HandoverRate == 0.0f)
+				{
+					EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackSuspended);
+				}
+			}
+		}
 	}
 	else
 	{
 		CurrentRate = 0.0f;
+		Clock.SetRate(0.0f);
+	}
+
+	Callbacks->SetCurrentTime(Clock.GetTime(), CurrentRate);
+
+	// the fading player keeps running in real time, regardless of the new media's clock
+	if ((FadingPlayer != nullptr) && (FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - FadeStartCycles) >= FadeDuration.GetTotalMilliseconds()))
+	{
+		EndCrossfade();
 	}
 
-	Callbacks.SetCurrentTime(CurrentTime);
+	// measure time from open to first output
+	if (OpenStartCycles != 0)
+	{
+		const uint64 FirstSampleCycles = Callbacks->GetFirstSampleCycles();
+
+		if (FirstSampleCycles != 0)
+		{
+			OpenLatency = FTimespan::FromMilliseconds(FPlatformTime::ToMilliseconds64(FirstSampleCycles - OpenStartCycles));
+			OpenStartCycles = 0;
+
+			UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: First sample %.1f ms after open"), this, OpenLatency.GetTotalMilliseconds());
+		}
+	}
+
+	// measure time from seek to first output of the new position
+	if (SeekStartCycles != 0)
+	{
+		const EMediaTrackType TrackType = (Tracks.GetSelectedTrack(EMediaTrackType::Video) != INDEX_NONE) ? EMediaTrackType::Video : EMediaTrackType::Audio;
+		const uint64 OutputCycles = Callbacks->GetSeekOutputCycles(TrackType);
+
+		if (OutputCycles >= SeekStartCycles)
+		{
+			const FTimespan Latency = FTimespan::FromMilliseconds(FPlatformTime::ToMilliseconds64(OutputCycles - SeekStartCycles));
+			FSeekStats& ModeStats = SeekStartScrub ? ScrubSeekStats : SeekStats[(int32)SeekStartMode];
+
+			++ModeStats.Count;
+			ModeStats.Last = Latency;
+			ModeStats.Max = FMath::Max(ModeStats.Max, Latency);
+			ModeStats.Total += Latency;
+
+			SeekStartCycles = 0;
+
+			UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: %s seek output after %.1f ms"), this, SeekStartScrub ? TEXT("Scrub") : *VlcMedia::SeekModeToString(SeekStartMode), Latency.GetTotalMilliseconds());
+		}
+	}
 }
 
 
-/* FVlcMediaPlayer implementation
+/* IVlcMediaPlayer interface
  *****************************************************************************/
 
-bool FVlcMediaPlayer::InitializePlayer()
+bool FVlcMediaPlayer::BeginScrub()
 {
-	// create player for media source
-	Player = FVlc::MediaPlayerNewFromMedia(MediaSource.GetMedia());
+	if (Scrubbing)
+	{
+		return true;
+	}
 
-	if (Player == nullptr)
+	if ((Player == nullptr) || !CanControl(EMediaControl::Scrub))
+	{
+		return false;
+	}
+
+	// frames are output one at a time while scrubbing
+	ScrubResumeRate = CurrentRate;
+
+	if ((CurrentRate != 0.0f) && !SetRate(0.0f))
+	{
+		ScrubResumeRate = 0.0f;
+		return false;
+	}
+
+	Scrubbing = true;
+	ScrubPending = false;
+	ScrubTime = Clock.GetTime();
+
+	// scrubbing seeks in fast mode
+	MediaSource->RequestKeyframeIndex();
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: Scrubbing started"), this);
+
+	return true;
+}
+
+
+void FVlcMediaPlayer::CancelNext()
+{
+	NextMedia.Reset();
+
+	// the current media already ended while waiting for the queued one
+	if (HandoverRate != 0.0f)
+	{
+		HandoverRate = 0.0f;
+		EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackSuspended);
+	}
+}
+
+
+void FVlcMediaPlayer::EndScrub()
+{
+	if (!Scrubbing)
+	{
+		return;
+	}
+
+	Scrubbing = false;
+
+	const float ResumeRate = ScrubResumeRate;
+	ScrubResumeRate = 0.0f;
+
+	// decode the final position in the player's seek mode, i.e. to output the exact frame
+	if ((Player != nullptr) &&
+		!Callbacks->GetLoopCache().IsReplaying() &&
+		(ScrubPending || ((SeekMode == EVlcMediaSeekMode::Accurate) && (ScrubTime != Clock.GetTime()))))
+	{
+		StartSeek(ScrubTime, SeekMode, false);
+
+		if (ResumeRate == 0.0f)
+		{
+			FVlc::MediaPlayerNextFrame(Player);
+		}
+	}
+
+	ScrubPending = false;
+
+	if (ResumeRate != 0.0f)
+	{
+		SetRate(ResumeRate);
+	}
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: Scrubbing ended after %i requests and %i seeks"), this, NumScrubRequests, NumScrubSeeks);
+}
+
+
+EVlcMediaSeekMode FVlcMediaPlayer::GetSeekMode() const
+{
+	return SeekMode;
+}
+
+
+bool FVlcMediaPlayer::IsNextReady() const
+{
+	return NextMedia.IsValid() && NextMedia->IsReady();
+}
+
+
+bool FVlcMediaPlayer::IsScrubbing() const
+{
+	return Scrubbing;
+}
+
+
+bool FVlcMediaPlayer::QueueNext(const FString& Url, const IMediaOptions* Options, FTimespan Crossfade)
+{
+	// replacing the queued media keeps waiting for the new one
+	NextMedia.Reset();
+
+	if (Url.IsEmpty() || ((Player == nullptr) && !OpenTask.IsValid()))
 	{
-		UE_LOG(LogVlcMedia, Warning, TEXT("Failed to initialize media player: %s"), ANSI_TO_TCHAR(FVlc::Errmsg()));
+		CancelNext();
 		return false;
 	}
 
+	NextMedia = MakeShareable(new FVlcMediaPreroll(VlcInstance, Url, Options, Crossfade));
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: Queued %s (crossfade %.1f ms)"), this, *Url, Crossfade.GetTotalMilliseconds());
+
+	return true;
+}
+
+
+void FVlcMediaPlayer::SetSeekMode(EVlcMediaSeekMode Mode)
+{
+	SeekMode = Mode;
+
+	// build the keyframe index before the first fast seek
+	if ((SeekMode == EVlcMediaSeekMode::Fast) && MediaSource.IsValid())
+	{
+		MediaSource->RequestKeyframeIndex();
+	}
+}
+
+
+/* FVlcMediaPlayer implementation
+ *****************************************************************************/
+
+void FVlcMediaPlayer::DetachEvents()
+{
+	FLibvlcEventManager* MediaEventManager = FVlc::MediaEventManager(MediaSource->GetMedia());
+	FLibvlcEventManager* PlayerEventManager = FVlc::MediaPlayerEventManager(Player);
+
+	if (MediaEventManager != nullptr)
+	{
+		FVlc::EventDetach(MediaEventManager, ELibvlcEventType::MediaParsedChanged, &FVlcMediaPlayer::StaticEventCallback, this);
+	}
+
+	if (PlayerEventManager != nullptr)
+	{
+		FVlc::EventDetach(PlayerEventManager, ELibvlcEventType::MediaPlayerEndReached, &FVlcMediaPlayer::StaticEventCallback, this);
+		FVlc::EventDetach(PlayerEventManager, ELibvlcEventType::MediaPlayerPlaying, &FVlcMediaPlayer::StaticEventCallback, this);
+		FVlc::EventDetach(PlayerEventManager, ELibvlcEventType::MediaPlayerPositionChanged, &FVlcMediaPlayer::StaticEventCallback, this);
+		FVlc::EventDetach(PlayerEventManager, ELibvlcEventType::MediaPlayerStopped, &FVlcMediaPlayer::StaticEventCallback, this);
+	}
+}
+
+
+void FVlcMediaPlayer::EndCrossfade()
+{
+	if (FadingPlayer == nullptr)
+	{
+		return;
+	}
+
+	// stop mixing before the faded out samples can be released
+	Callbacks->EndCrossfade();
+
+	FVlcMediaReaper::Get().Reap(FadingPlayer, FadingCallbacks.ToSharedRef(), FadingMediaSource);
+	FadingCallbacks.Reset();
+	FadingMediaSource.Reset();
+	FadingPlayer = nullptr;
+}
+
+
+void FVlcMediaPlayer::FinishOpen()
+{
+	TSharedRef<FVlcMediaOpenTask, ESPMode::ThreadSafe> Task = OpenTask.ToSharedRef();
+	OpenTask.Reset();
+
+	if (!Task->Succeeded())
+	{
+		EventSink.ReceiveMediaEvent(EMediaEvent::MediaOpenFailed);
+		return;
+	}
+
+	MediaSource = Task->GetMediaSource();
+	PrecacheArchive = Task->GetPrecacheArchive();
+	Player = Task->DetachPlayer();
+	OpenTaskDuration = Task->GetDuration();
+
+	if (!InitializePlayer())
+	{
+		Close();
+		EventSink.ReceiveMediaEvent(EMediaEvent::MediaOpenFailed);
+
+		return;
+	}
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: Opened %s in %.1f ms"), this, *MediaSource->GetCurrentUrl(), Task->GetDuration().GetTotalMilliseconds());
+
+	// the media may have been parsed before the event handler was attached
+	if (Task->IsParsed())
+	{
+		Events.Enqueue(ELibvlcEventType::MediaParsedChanged);
+	}
+}
+
+
+void FVlcMediaPlayer::Handover()
+{
+	TSharedRef<FVlcMediaPreroll> Next = NextMedia.ToSharedRef();
+	NextMedia.Reset();
+
+	const float Rate = (HandoverRate != 0.0f) ? HandoverRate : CurrentRate;
+	const FTimespan Crossfade = Next->GetCrossfade();
+
+	// the end of the current media was reported already if it ended before the handover
+	if (HandoverRate == 0.0f)
+	{
+		EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackEndReached);
+	}
+
+	HandoverRate = 0.0f;
+
+	// a crossfade that is still in progress is cut short
+	EndCrossfade();
+
+	DetachEvents();
+	Tracks.Shutdown();
+	View.Shutdown();
+
+	const bool Fade = (Crossfade > FTimespan::Zero()) &&
+		!Callbacks->GetLoopCache().IsReplaying() &&
+		(FVlc::MediaPlayerGetState(Player) == ELibvlcState::Playing);
+
+	if (Fade)
+	{
+		// keep the current player running until the end of the crossfade
+		FadeDuration = Crossfade;
+		FadeStartCycles = FPlatformTime::Cycles64();
+		FadingCallbacks = Callbacks;
+		FadingMediaSource = MediaSource;
+		FadingPlayer = Player;
+	}
+	else
+	{
+		FVlcMediaReaper::Get().Reap(Player, Callbacks, MediaSource);
+	}
+
+	// take over the primed player, whose sample queues already hold the first samples
+	Callbacks = Next->GetCallbacks();
+	MediaSource = Next->GetMediaSource();
+	PrecacheArchive = Next->GetPrecacheArchive();
+	PrecacheReportedPercent = 0;
+	Player = Next->DetachPlayer();
+
+	Events.Empty();
+	Info.Empty();
+
+	if (!InitializePlayer())
+	{
+		Close();
+		EventSink.ReceiveMediaEvent(EMediaEvent::MediaOpenFailed);
+
+		return;
+	}
+
+	// the pre-rolled media has been parsed already
+	Tracks.Initialize(*Player, Info);
+	View.Initialize(*Player);
+	EventSink.ReceiveMediaEvent(EMediaEvent::TracksChanged);
+
+	if (Fade)
+	{
+		Callbacks->BeginCrossfade(*FadingCallbacks, Crossfade);
+	}
+
+	// the input is already running, so looping restarts it at the end
+	FVlc::MediaPlayerSetRate(Player, Rate);
+	FVlc::MediaPlayerSetPause(Player, 0);
+
+	// the new media starts at its beginning, regardless of where the previous one was
+	Clock.Reset(FTimespan::Zero());
+	Clock.SetRate(Rate);
+	CurrentRate = Rate;
+	Callbacks->SetCurrentTime(FTimespan::Zero(), Rate);
+
+	++NumHandovers;
+
+	EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackResumed);
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: Handed over to %s%s"), this, *MediaSource->GetCurrentUrl(), Fade ? TEXT(" (crossfading)") : TEXT(""));
+}
+
+
+bool FVlcMediaPlayer::InitializePlayer()
+{
 	// attach to event managers
-	FLibvlcEventManager* MediaEventManager = FVlc::MediaEventManager(MediaSource.GetMedia());
+	FLibvlcEventManager* MediaEventManager = FVlc::MediaEventManager(MediaSource->GetMedia());
 	FLibvlcEventManager* PlayerEventManager = FVlc::MediaPlayerEventManager(Player);
 
 	if ((MediaEventManager == nullptr) || (PlayerEventManager == nullptr))
 	{
-		FVlc::MediaPlayerRelease(Player);
-		Player = nullptr;
-
 		return false;
 	}
 
@@ -506,8 +1156,29 @@ bool FVlcMediaPlayer::InitializePlayer()
 	FVlc::EventAttach(PlayerEventManager, ELibvlcEventType::MediaPlayerStopped, &FVlcMediaPlayer::StaticEventCallback, this);
 
 	// initialize player
+	Clock.Reset(FTimespan::Zero());
+	Clock.SetRate(0.0f);
 	CurrentRate = 0.0f;
-	CurrentTime = FTimespan::Zero();
+	InputRepeating = false;
+	NumCachedLoops = 0;
+	NumGaplessLoops = 0;
+	NumRestartedLoops = 0;
+	NumScrubRequests = 0;
+	NumScrubSeeks = 0;
+	SeekStartCycles = 0;
+
+	for (FSeekStats& ModeStats : SeekStats)
+	{
+		ModeStats = FSeekStats();
+	}
+
+	ScrubSeekStats = FSeekStats();
+
+	// the keyframe index is only needed for fast seeks
+	if (SeekMode == EVlcMediaSeekMode::Fast)
+	{
+		MediaSource->RequestKeyframeIndex();
+	}
 
 	EventSink.ReceiveMediaEvent(EMediaEvent::MediaOpened);
 
@@ -515,6 +1186,211 @@ bool FVlcMediaPlayer::InitializePlayer()
 }
 
 
+bool FVlcMediaPlayer::StartLoopReplay()
+{
+	const FTimespan Duration = MediaSource->GetDuration();
+	FVlcMediaLoopCache& LoopCache = Callbacks->GetLoopCache();
+
+	if ((Duration <= FTimespan::Zero()) || !LoopCache.FinishRecording(Duration))
+	{
+		return false;
+	}
+
+	const bool Playing = (FVlc::MediaPlayerGetState(Player) == ELibvlcState::Playing);
+
+	if ((Playing && (FVlc::MediaPlayerCanPause(Player) == 0)) || !LoopCache.StartReplay())
+	{
+		return false;
+	}
+
+	// the decoder is no longer needed; samples it already queued are discarded
+	if (Playing)
+	{
+		FVlc::MediaPlayerSetPause(Player, 1);
+	}
+
+	Callbacks->GetSamples().FlushSamples();
+	LoopCache.SeekReplay(Clock.GetTime());
+	Clock.SetRate(CurrentRate);
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: Replaying loops of %s from cache"), this, *GetUrl());
+
+	return true;
+}
+
+
+void FVlcMediaPlayer::StartSeek(FTimespan Time, EVlcMediaSeekMode Mode, bool Scrub)
+{
+	// seeks are not snapped to keyframes until the index was built
+	if (Mode == EVlcMediaSeekMode::Fast)
+	{
+		MediaSource->RequestKeyframeIndex();
+	}
+
+	const TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe>& KeyframeIndex = MediaSource->GetKeyframeIndex();
+	FTimespan SeekTime = Time;
+	int64 SeekMilliseconds = (int64)Time.GetTotalMilliseconds();
+
+	if ((Mode == EVlcMediaSeekMode::Fast) && KeyframeIndex.IsValid())
+	{
+		// VLC starts decoding at the last keyframe before the requested time, so round up
+		SeekTime = KeyframeIndex->FindNearest(Time);
+		SeekMilliseconds = (SeekTime.GetTicks() + ETimespan::TicksPerMillisecond - 1) / ETimespan::TicksPerMillisecond;
+	}
+
+	// start measuring before VLC can flush its audio output for the seek
+	SeekStartCycles = FPlatformTime::Cycles64();
+	SeekStartMode = Mode;
+	SeekStartScrub = Scrub;
+	Callbacks->NotifySeek();
+
+	FVlc::MediaPlayerSetTime(Player, SeekMilliseconds);
+
+	// discard samples that were queued before the seek; the callbacks discard
+	// frames of the previous position that VLC outputs until it processes it
+	Callbacks->GetSamples().FlushSamples();
+	Clock.Reset(SeekTime);
+
+	// the pass being recorded has a gap now
+	Callbacks->GetLoopCache().CancelRecording();
+
+	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Player %p: %s seek to %s (requested %s)"), this, *VlcMedia::SeekModeToString(Mode), *SeekTime.ToString(), *Time.ToString());
+}
+
+
+bool FVlcMediaPlayer::StartOpen(const FString& Url, const TSharedPtr<FArchive, ESPMode::ThreadSafe>& Archive, const IMediaOptions* Options)
+{
+	Callbacks->ApplyOptions(Options);
+	OpenStartCycles = FPlatformTime::Cycles64();
+
+	const bool Precache = (Options != nullptr) && Options->GetMediaOption("PrecacheFile", false);
+
+	OpenTask = MakeShareable(new FVlcMediaOpenTask(VlcInstance, Url, Archive, Precache, Callbacks->IsAudioOnly()));
+	OpenTask->Start();
+
+	PrecacheReportedPercent = 0;
+
+	EventSink.ReceiveMediaEvent(EMediaEvent::MediaConnecting);
+
+	return true;
+}
+
+
+void FVlcMediaPlayer::TickReplay()
+{
+	const FTimespan Duration = MediaSource->GetDuration();
+
+	if (Clock.GetTime() < Duration)
+	{
+		return;
+	}
+
+	EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackEndReached);
+
+	if (ShouldLoop && !NextMedia.IsValid())
+	{
+		Clock.Wrap(Duration);
+		Callbacks->GetLoopCache().SeekReplay(FTimespan::Zero());
+		++NumCachedLoops;
+
+		return;
+	}
+
+	if (NextMedia.IsValid())
+	{
+		HandoverRate = CurrentRate;
+	}
+
+	// the cached samples are kept in case playback is restarted
+	Callbacks->GetLoopCache().StopReplay();
+	FVlc::MediaPlayerStop(Player);
+	InputRepeating = false;
+
+	Clock.SetRate(0.0f);
+	CurrentRate = 0.0f;
+
+	if (HandoverRate == 0.0f)
+	{
+		EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackSuspended);
+	}
+}
+
+
+void FVlcMediaPlayer::TickScrub()
+{
+	if (!ScrubPending)
+	{
+		return;
+	}
+
+	// only one seek is decoded at a time; later requests replace the pending one
+	if ((SeekStartCycles != 0) && (FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - SeekStartCycles) < ScrubSeekTimeout.GetTotalMilliseconds()))
+	{
+		return;
+	}
+
+	ScrubPending = false;
+
+	if (Callbacks->GetLoopCache().IsReplaying())
+	{
+		Seek(ScrubTime);
+		return;
+	}
+
+	// snap to keyframes, if they are indexed
+	StartSeek(ScrubTime, EVlcMediaSeekMode::Fast, true);
+	++NumScrubSeeks;
+
+	// a paused player outputs the frame at the new position only when stepping
+	if (FVlc::MediaPlayerGetState(Player) == ELibvlcState::Paused)
+	{
+		FVlc::MediaPlayerNextFrame(Player);
+	}
+}
+
+
+void FVlcMediaPlayer::UpdateInputRepeat()
+{
+	const FTimespan Duration = MediaSource->GetDuration();
+
+	// the play time can only wrap around if the duration is known; queued media plays instead of looping
+	InputRepeating = ShouldLoop && !NextMedia.IsValid() && (Duration > FTimespan::Zero());
+
+	// the most recently added option takes precedence
+	FVlc::MediaAddOption(MediaSource->GetMedia(), InputRepeating ? ":input-repeat=65535" : ":input-repeat=0");
+	Callbacks->SetLoopDuration(InputRepeating ? Duration : FTimespan::Zero());
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: Input repeat %s"), this, InputRepeating ? TEXT("enabled") : TEXT("disabled"));
+}
+
+
+void FVlcMediaPlayer::UpdatePrecache(FVlcMediaPrecacheArchive& Archive)
+{
+	if (PrecacheReportedPercent >= 100)
+	{
+		return;
+	}
+
+	if (Archive.HasFailed())
+	{
+		// the remaining data is read directly from the file
+		PrecacheArchive.Reset();
+		return;
+	}
+
+	const int32 Percent = (int32)(Archive.GetNumLoadedBytes() * 100 / FMath::Max<int64>(1, Archive.TotalSize()));
+
+	// report progress in steps of ten percent
+	if ((Percent / 10) > (PrecacheReportedPercent / 10))
+	{
+		UE_LOG(LogVlcMedia, Verbose, TEXT("Player %p: Precached %i%% of %s"), this, Percent, *GetUrl());
+
+		PrecacheReportedPercent = Percent;
+		EventSink.ReceiveMediaEvent(EMediaEvent::MediaBuffering);
+	}
+}
+
+
 /* FVlcMediaPlayer static functions
  *****************************************************************************/
 
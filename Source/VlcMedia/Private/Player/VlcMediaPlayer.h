@@ -8,12 +8,17 @@
 #include "IMediaControls.h"
 #include "IMediaPlayer.h"
 #include "IMediaSamples.h"
+#include "IVlcMediaPlayer.h"
 
 #include "VlcMediaCallbacks.h"
+#include "VlcMediaClock.h"
+#include "VlcMediaOpenTask.h"
+#include "VlcMediaPrecacheArchive.h"
 #include "VlcMediaSource.h"
 #include "VlcMediaTracks.h"
 #include "VlcMediaView.h"
 
+class FVlcMediaPreroll;
 class IMediaEventSink;
 class IMediaOutput;
 
@@ -32,6 +37,7 @@ class FVlcMediaPlayer
 	: public IMediaPlayer
 	, protected IMediaCache
 	, protected IMediaControls
+	, public IVlcMediaPlayer
 {
 public:
 
@@ -64,8 +70,50 @@ public:
 	virtual bool Open(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, const IMediaOptions* Options) override;
 	virtual void TickInput(FTimespan DeltaTime, FTimespan Timecode) override;
 
+public:
+
+	//~ IVlcMediaPlayer interface
+
+	virtual bool BeginScrub() override;
+	virtual void CancelNext() override;
+	virtual void EndScrub() override;
+	virtual EVlcMediaSeekMode GetSeekMode() const override;
+	virtual bool IsNextReady() const override;
+	virtual bool IsScrubbing() const override;
+	virtual bool QueueNext(const FString& Url, const IMediaOptions* Options, FTimespan Crossfade) override;
+	virtual void SetSeekMode(EVlcMediaSeekMode Mode) override;
+
+public:
+
+	/** Maximum time to wait for the output of a scrub seek before the next one is started. */
+	static const FTimespan ScrubSeekTimeout;
+
 protected:
 
+	/**
+	 * Stop mixing in and release the player that is fading out.
+	 *
+	 * @see Handover
+	 */
+	void EndCrossfade();
+
+	/**
+	 * Take over the media source and player of the finished open task.
+	 *
+	 * @see OpenTask, StartOpen
+	 */
+	void FinishOpen();
+
+	/**
+	 * Switch playback over to the queued media.
+	 *
+	 * The current player is released, or kept playing until the end of the
+	 * crossfade, and the primed player of the queued media takes its place.
+	 *
+	 * @see EndCrossfade, QueueNext
+	 */
+	void Handover();
+
 	/**
 	 * Initialize the media player.
 	 *
@@ -73,6 +121,48 @@ protected:
 	 */
 	bool InitializePlayer();
 
+	/**
+	 * Serve the following loops from the loop cache, if it holds a complete pass.
+	 *
+	 * @return true if replaying from the cache, false otherwise.
+	 * @see TickReplay
+	 */
+	bool StartLoopReplay();
+
+	/**
+	 * Seek the VLC player.
+	 *
+	 * @param Time The time to seek to.
+	 * @param Mode The seek mode to use.
+	 * @param Scrub Whether this is an intermediate seek while scrubbing.
+	 * @see Seek, TickScrub
+	 */
+	void StartSeek(FTimespan Time, EVlcMediaSeekMode Mode, bool Scrub);
+
+	/**
+	 * Start opening a media source on a worker thread.
+	 *
+	 * @param Url The URL of the media to open.
+	 * @param Archive The archive to read the media from (optional).
+	 * @param Options Optional media parameters.
+	 * @return true if opening started, false otherwise.
+	 * @see FinishOpen
+	 */
+	bool StartOpen(const FString& Url, const TSharedPtr<FArchive, ESPMode::ThreadSafe>& Archive, const IMediaOptions* Options);
+
+	/** Advance the play time while replaying from the loop cache. */
+	void TickReplay();
+
+	/** Start the most recent scrub seek once the previous one was output. */
+	void TickScrub();
+
+	/**
+	 * Report the loading progress of a precached file.
+	 *
+	 * @param Archive The archive of the precached file.
+	 */
+	void UpdatePrecache(FVlcMediaPrecacheArchive& Archive);
+
 protected:
 
 	//~ IMediaControls interface
@@ -91,19 +181,56 @@ protected:
 
 private:
 
+	/** Detach the event handlers from the player and media. */
+	void DetachEvents();
+
+	/**
+	 * Configure whether the VLC input repeats the media.
+	 *
+	 * The repeat count is read when VLC creates the input, so this must be
+	 * called before starting playback from the stopped state.
+	 *
+	 * @see InputRepeating
+	 */
+	void UpdateInputRepeat();
+
 	/** Handles event callbacks. */
 	static void StaticEventCallback(FLibvlcEvent* Event, void* UserData);
 
 private:
 
-	/** VLC callback manager. */
-	FVlcMediaCallbacks Callbacks;
+	/** Latency statistics of one seek mode. */
+	struct FSeekStats
+	{
+		/** Number of seeks whose latency was measured. */
+		int32 Count;
+
+		/** Latency of the most recent seek. */
+		FTimespan Last;
+
+		/** Highest latency. */
+		FTimespan Max;
+
+		/** Sum of all latencies. */
+		FTimespan Total;
+
+		/** Default constructor. */
+		FSeekStats()
+			: Count(0)
+			, Last(FTimespan::Zero())
+			, Max(FTimespan::Zero())
+			, Total(FTimespan::Zero())
+		{ }
+	};
+
+	/** VLC callback manager (replaced on close, because the old one is kept alive until its player is released). */
+	TSharedRef<FVlcMediaCallbacks, ESPMode::ThreadSafe> Callbacks;
 
 	/** Current playback rate. */
 	float CurrentRate;
 
-	/** Current playback time (to work around VLC's broken time tracking). */
-	FTimespan CurrentTime;
+	/** Playback time clock (to work around VLC's broken time tracking). */
+	FVlcMediaClock Clock;
 
 	/** The media event handler. */
 	IMediaEventSink& EventSink;
@@ -111,15 +238,105 @@ private:
 	/** Collection of received player events. */
 	TQueue<ELibvlcEventType, EQueueMode::Mpsc> Events;
 
+	/** Duration of the current crossfade. */
+	FTimespan FadeDuration;
+
+	/** Cycle counter of the handover that started the current crossfade. */
+	uint64 FadeStartCycles;
+
+	/** VLC callback manager of the player that is fading out. */
+	TSharedPtr<FVlcMediaCallbacks, ESPMode::ThreadSafe> FadingCallbacks;
+
+	/** The media source of the player that is fading out. */
+	TSharedPtr<FVlcMediaSource, ESPMode::ThreadSafe> FadingMediaSource;
+
+	/** The VLC player that is fading out (nullptr = not crossfading). */
+	FLibvlcMediaPlayer* FadingPlayer;
+
+	/** Rate to continue at once the queued media is ready (0 = not waiting for it). */
+	float HandoverRate;
+
 	/** Media information string. */
 	FString Info;
 
+	/** Whether the current VLC input repeats the media, so that looping is gapless. */
+	bool InputRepeating;
+
 	/** The media source (from URL or archive). */
-	FVlcMediaSource MediaSource;
+	TSharedPtr<FVlcMediaSource, ESPMode::ThreadSafe> MediaSource;
+
+	/** The media that is queued to play next. */
+	TSharedPtr<FVlcMediaPreroll> NextMedia;
+
+	/** Number of loops that were replayed from the loop cache. */
+	int32 NumCachedLoops;
+
+	/** Number of loops that VLC played without restarting the input. */
+	int32 NumGaplessLoops;
+
+	/** Number of times playback was switched over to queued media. */
+	int32 NumHandovers;
+
+	/** Number of loops that required stopping and restarting the input. */
+	int32 NumRestartedLoops;
+
+	/** Number of seeks that were requested while scrubbing. */
+	int32 NumScrubRequests;
+
+	/** Number of seeks that were started while scrubbing. */
+	int32 NumScrubSeeks;
+
+	/** The task that is opening the media source (only while opening). */
+	TSharedPtr<FVlcMediaOpenTask, ESPMode::ThreadSafe> OpenTask;
+
+	/** Time from the most recent Open call to its first output sample. */
+	FTimespan OpenLatency;
+
+	/** Cycle counter of the most recent Open call (0 = first sample already received). */
+	uint64 OpenStartCycles;
+
+	/** Time that the most recent open task took. */
+	FTimespan OpenTaskDuration;
 
 	/** The VLC media player object. */
 	FLibvlcMediaPlayer* Player;
 
+	/** The precached file (if opened with the PrecacheFile option). */
+	TSharedPtr<FVlcMediaPrecacheArchive, ESPMode::ThreadSafe> PrecacheArchive;
+
+	/** Progress of the file being precached that was last reported (in percent). */
+	int32 PrecacheReportedPercent;
+
+	/** The mode used for seeking. */
+	EVlcMediaSeekMode SeekMode;
+
+	/** Cycle counter of the most recent seek (0 = its first sample was already output). */
+	uint64 SeekStartCycles;
+
+	/** The mode of the most recent seek. */
+	EVlcMediaSeekMode SeekStartMode;
+
+	/** Whether the most recent seek was an intermediate seek while scrubbing. */
+	bool SeekStartScrub;
+
+	/** Latency statistics for each seek mode. */
+	FSeekStats SeekStats[2];
+
+	/** Whether a scrub seek is waiting for the previous one to be output. */
+	bool ScrubPending;
+
+	/** The rate to resume at when scrubbing ends (0 = stay paused). */
+	float ScrubResumeRate;
+
+	/** Whether the player is scrubbing. */
+	bool Scrubbing;
+
+	/** Latency statistics of seeks while scrubbing (kept separate from SeekStats). */
+	FSeekStats ScrubSeekStats;
+
+	/** The most recently requested scrub time. */
+	FTimespan ScrubTime;
+
 	/** Whether playback should be looping. */
 	bool ShouldLoop;
 
@@ -128,4 +345,7 @@ private:
 
 	/** View settings. */
 	FVlcMediaView View;
+
+	/** The LibVLC instance. */
+	FLibvlcInstance* VlcInstance;
 };
@@ -0,0 +1,120 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaPlayerPool.h"
+#include "VlcMediaPrivate.h"
+
+#include "Misc/ScopeLock.h"
+
+#include "Vlc.h"
+
+
+/* FVlcMediaPlayerPool static functions
+ *****************************************************************************/
+
+FVlcMediaPlayerPool& FVlcMediaPlayerPool::Get()
+{
+	static FVlcMediaPlayerPool Pool;
+	return Pool;
+}
+
+
+/* FVlcMediaPlayerPool interface
+ *****************************************************************************/
+
+FLibvlcMediaPlayer* FVlcMediaPlayerPool::Acquire()
+{
+	FLibvlcInstance* Instance = nullptr;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (IdlePlayers.Num() > 0)
+		{
+			return IdlePlayers.Pop(false);
+		}
+
+		Instance = VlcInstance;
+	}
+
+	if (Instance == nullptr)
+	{
+		return nullptr;
+	}
+
+	return FVlc::MediaPlayerNew(Instance);
+}
+
+
+void FVlcMediaPlayerPool::Empty()
+{
+	TArray<FLibvlcMediaPlayer*> ReleasedPlayers;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		ReleasedPlayers = MoveTemp(IdlePlayers);
+		MaxIdlePlayers = 0;
+		VlcInstance = nullptr;
+	}
+
+	for (FLibvlcMediaPlayer* Player : ReleasedPlayers)
+	{
+		FVlc::MediaPlayerRelease(Player);
+	}
+}
+
+
+int32 FVlcMediaPlayerPool::GetNumIdle() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return IdlePlayers.Num();
+}
+
+
+void FVlcMediaPlayerPool::Initialize(FLibvlcInstance* InVlcInstance, int32 InMaxIdlePlayers)
+{
+	Empty();
+
+	TArray<FLibvlcMediaPlayer*> CreatedPlayers;
+
+	for (int32 Index = 0; Index < InMaxIdlePlayers; ++Index)
+	{
+		FLibvlcMediaPlayer* Player = FVlc::MediaPlayerNew(InVlcInstance);
+
+		if (Player == nullptr)
+		{
+			UE_LOG(LogVlcMedia, Warning, TEXT("Failed to create pooled media player: %s"), ANSI_TO_TCHAR(FVlc::Errmsg()));
+			break;
+		}
+
+		CreatedPlayers.Add(Player);
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	IdlePlayers = MoveTemp(CreatedPlayers);
+	MaxIdlePlayers = FMath::Max(0, InMaxIdlePlayers);
+	VlcInstance = (MaxIdlePlayers > 0) ? InVlcInstance : nullptr;
+}
+
+
+void FVlcMediaPlayerPool::Release(FLibvlcMediaPlayer* Player)
+{
+	if (Player == nullptr)
+	{
+		return;
+	}
+
+	// detach the media, so that it can be released
+	FVlc::MediaPlayerSetMedia(Player, nullptr);
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (IdlePlayers.Num() < MaxIdlePlayers)
+		{
+			IdlePlayers.Add(Player);
+			return;
+		}
+	}
+
+	FVlc::MediaPlayerRelease(Player);
+}
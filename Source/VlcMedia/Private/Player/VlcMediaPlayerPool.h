@@ -0,0 +1,99 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+struct FLibvlcInstance;
+struct FLibvlcMediaPlayer;
+
+
+/**
+ * Process-wide pool of idle VLC media players.
+ *
+ * Creating a VLC player is relatively expensive, so players that were closed
+ * are stopped, detached from their media and kept for reuse with the next
+ * media via MediaPlayerSetMedia. The pool is filled up front when initialized.
+ *
+ * This class is thread-safe.
+ */
+class FVlcMediaPlayerPool
+{
+public:
+
+	/**
+	 * Get the singleton instance.
+	 *
+	 * @return The player pool.
+	 */
+	static FVlcMediaPlayerPool& Get();
+
+public:
+
+	/**
+	 * Get an idle player, or create one if the pool is empty.
+	 *
+	 * @return The player, or nullptr if the pool is not initialized or the player could not be created.
+	 * @see Release
+	 */
+	FLibvlcMediaPlayer* Acquire();
+
+	/**
+	 * Release all idle players.
+	 *
+	 * Call this before releasing the LibVLC instance.
+	 *
+	 * @see Initialize
+	 */
+	void Empty();
+
+	/**
+	 * Get the number of idle players.
+	 *
+	 * @return Number of players.
+	 */
+	int32 GetNumIdle() const;
+
+	/**
+	 * Create the idle players.
+	 *
+	 * @param InVlcInstance The LibVLC instance to create players with.
+	 * @param InMaxIdlePlayers Maximum number of idle players to keep (0 = disable pooling).
+	 * @see Empty
+	 */
+	void Initialize(FLibvlcInstance* InVlcInstance, int32 InMaxIdlePlayers);
+
+	/**
+	 * Return a stopped player to the pool.
+	 *
+	 * The player is detached from its media, and released if the pool is full.
+	 * Its callbacks and event handlers must have been unregistered.
+	 *
+	 * @param Player The player to return.
+	 * @see Acquire
+	 */
+	void Release(FLibvlcMediaPlayer* Player);
+
+private:
+
+	/** Hidden constructor (use Get instead). */
+	FVlcMediaPlayerPool()
+		: MaxIdlePlayers(0)
+		, VlcInstance(nullptr)
+	{ }
+
+private:
+
+	/** Critical section for synchronizing access to the idle players. */
+	mutable FCriticalSection CriticalSection;
+
+	/** The idle players. */
+	TArray<FLibvlcMediaPlayer*> IdlePlayers;
+
+	/** Maximum number of idle players to keep. */
+	int32 MaxIdlePlayers;
+
+	/** The LibVLC instance. */
+	FLibvlcInstance* VlcInstance;
+};
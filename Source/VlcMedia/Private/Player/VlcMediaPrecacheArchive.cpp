@@ -0,0 +1,106 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaPrecacheArchive.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/FileManager.h"
+
+#include "VlcMediaFileCache.h"
+
+
+/* FVlcMediaPrecacheArchive structors
+ *****************************************************************************/
+
+FVlcMediaPrecacheArchive::FVlcMediaPrecacheArchive(const TSharedRef<FVlcMediaCachedFile, ESPMode::ThreadSafe>& InFile)
+	: File(InFile)
+	, Position(0)
+{
+	ArIsLoading = true;
+}
+
+
+/* FVlcMediaPrecacheArchive interface
+ *****************************************************************************/
+
+int32 FVlcMediaPrecacheArchive::GetNumShares() const
+{
+	// the cache holds a reference unless the file was evicted or replaced by a newer copy
+	const int32 NumReferences = File.GetSharedReferenceCount();
+
+	return FVlcMediaFileCache::Get().Contains(*File) ? (NumReferences - 1) : NumReferences;
+}
+
+
+/* FArchive interface
+ *****************************************************************************/
+
+FString FVlcMediaPrecacheArchive::GetArchiveName() const
+{
+	return TEXT("FVlcMediaPrecacheArchive");
+}
+
+
+void FVlcMediaPrecacheArchive::Seek(int64 InPos)
+{
+	check((InPos >= 0) && (InPos <= File->GetSize()));
+	Position = InPos;
+}
+
+
+void FVlcMediaPrecacheArchive::Serialize(void* Data, int64 Length)
+{
+	if (Length <= 0)
+	{
+		return;
+	}
+
+	if (Position + Length > File->GetSize())
+	{
+		ArIsError = true;
+		return;
+	}
+
+	if (Position + Length <= File->GetNumLoadedBytes())
+	{
+		FMemory::Memcpy(Data, File->GetData() + Position, Length);
+	}
+	else
+	{
+		// not loaded yet, so read from the file instead of waiting for the loader
+		if (!DirectReader.IsValid())
+		{
+			DirectReader.Reset(IFileManager::Get().CreateFileReader(*File->GetFilePath()));
+		}
+
+		if (!DirectReader.IsValid())
+		{
+			ArIsError = true;
+			return;
+		}
+
+		DirectReader->Seek(Position);
+		DirectReader->Serialize(Data, Length);
+
+		if (DirectReader->IsError())
+		{
+			ArIsError = true;
+			return;
+		}
+
+		NumDirectReads.Increment();
+	}
+
+	Position += Length;
+}
+
+
+int64 FVlcMediaPrecacheArchive::Tell()
+{
+	return Position;
+}
+
+
+int64 FVlcMediaPrecacheArchive::TotalSize()
+{
+	return File->GetSize();
+}
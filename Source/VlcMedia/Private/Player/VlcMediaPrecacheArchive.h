@@ -0,0 +1,112 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Serialization/Archive.h"
+#include "Templates/SharedPointer.h"
+#include "Templates/UniquePtr.h"
+
+#include "VlcMediaCachedFile.h"
+
+
+/**
+ * Archive that reads a local file that is being loaded into memory.
+ *
+ * Reads of data that is already resident are served from the shared cached
+ * file. Reads beyond the loaded range, i.e. for the index at the end of some
+ * containers, are served directly from the file instead of waiting for the
+ * loader.
+ *
+ * Serialize, Seek and Tell must be called from one thread at a time.
+ *
+ * @see FVlcMediaFileCache
+ */
+class FVlcMediaPrecacheArchive
+	: public FArchive
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InFile The cached file to read from.
+	 */
+	FVlcMediaPrecacheArchive(const TSharedRef<FVlcMediaCachedFile, ESPMode::ThreadSafe>& InFile);
+
+public:
+
+	/**
+	 * Get the number of reads that were served from the file because the data was not loaded yet.
+	 *
+	 * @return Number of reads.
+	 */
+	int32 GetNumDirectReads() const
+	{
+		return NumDirectReads.GetValue();
+	}
+
+	/**
+	 * Get the number of bytes that are resident in memory.
+	 *
+	 * @return Number of bytes.
+	 * @see IsComplete
+	 */
+	int64 GetNumLoadedBytes() const
+	{
+		return File->GetNumLoadedBytes();
+	}
+
+	/**
+	 * Get the number of archives that share the cached file.
+	 *
+	 * @return Number of archives, including this one.
+	 */
+	int32 GetNumShares() const;
+
+	/**
+	 * Check whether loading the file failed.
+	 *
+	 * @return true if loading failed, false otherwise.
+	 */
+	bool HasFailed() const
+	{
+		return File->HasFailed();
+	}
+
+	/**
+	 * Check whether the entire file is resident in memory.
+	 *
+	 * @return true if loaded, false otherwise.
+	 * @see GetNumLoadedBytes
+	 */
+	bool IsComplete() const
+	{
+		return File->IsComplete();
+	}
+
+public:
+
+	//~ FArchive interface
+
+	virtual FString GetArchiveName() const override;
+	virtual void Seek(int64 InPos) override;
+	virtual void Serialize(void* Data, int64 Length) override;
+	virtual int64 Tell() override;
+	virtual int64 TotalSize() override;
+
+private:
+
+	/** Archive for reads beyond the loaded range (created on demand). */
+	TUniquePtr<FArchive> DirectReader;
+
+	/** The cached file. */
+	TSharedRef<FVlcMediaCachedFile, ESPMode::ThreadSafe> File;
+
+	/** Number of reads that were served from the file. */
+	FThreadSafeCounter NumDirectReads;
+
+	/** Current read position. */
+	int64 Position;
+};
@@ -0,0 +1,140 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaPreroll.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/PlatformTime.h"
+#include "IMediaOptions.h"
+
+#include "Vlc.h"
+#include "VlcMediaCallbacks.h"
+#include "VlcMediaOpenTask.h"
+#include "VlcMediaReaper.h"
+#include "VlcMediaSource.h"
+
+
+/* FVlcMediaPreroll static initialization
+ *****************************************************************************/
+
+const FTimespan FVlcMediaPreroll::PrimeDuration = FTimespan::FromMilliseconds(100.0);
+
+
+/* FVlcMediaPreroll structors
+ *****************************************************************************/
+
+FVlcMediaPreroll::FVlcMediaPreroll(FLibvlcInstance* InVlcInstance, const FString& InUrl, const IMediaOptions* Options, FTimespan InCrossfade)
+	: Callbacks(MakeShareable(new FVlcMediaCallbacks))
+	, Crossfade(FMath::Max(FTimespan::Zero(), InCrossfade))
+	, Failed(false)
+	, Player(nullptr)
+	, Primed(false)
+	, PrimeStartCycles(0)
+	, Url(InUrl)
+{
+	Callbacks->ApplyOptions(Options);
+
+	const bool Precache = (Options != nullptr) && Options->GetMediaOption("PrecacheFile", false);
+
+	OpenTask = MakeShareable(new FVlcMediaOpenTask(InVlcInstance, Url, nullptr, Precache, Callbacks->IsAudioOnly()));
+	OpenTask->Start();
+}
+
+
+FVlcMediaPreroll::~FVlcMediaPreroll()
+{
+	if (OpenTask.IsValid())
+	{
+		OpenTask->Cancel();
+		OpenTask.Reset();
+	}
+
+	if (Player != nullptr)
+	{
+		FVlcMediaReaper::Get().Reap(Player, Callbacks, MediaSource);
+		Player = nullptr;
+	}
+}
+
+
+/* FVlcMediaPreroll interface
+ *****************************************************************************/
+
+FLibvlcMediaPlayer* FVlcMediaPreroll::DetachPlayer()
+{
+	check(IsReady());
+
+	FLibvlcMediaPlayer* DetachedPlayer = Player;
+	Player = nullptr;
+
+	return DetachedPlayer;
+}
+
+
+void FVlcMediaPreroll::Tick()
+{
+	if (OpenTask.IsValid())
+	{
+		if (!OpenTask->IsDone())
+		{
+			return;
+		}
+
+		TSharedRef<FVlcMediaOpenTask, ESPMode::ThreadSafe> Task = OpenTask.ToSharedRef();
+		OpenTask.Reset();
+
+		if (!Task->Succeeded())
+		{
+			UE_LOG(LogVlcMedia, Warning, TEXT("Failed to pre-roll media %s"), *Url);
+			Failed = true;
+
+			return;
+		}
+
+		MediaSource = Task->GetMediaSource();
+		PrecacheArchive = Task->GetPrecacheArchive();
+		Player = Task->DetachPlayer();
+
+		// samples are timed at zero until the handover, so that the first ones are output right away
+		Callbacks->Initialize(*Player);
+		Callbacks->SetCurrentTime(FTimespan::Zero(), 0.0f);
+
+		if (FVlc::MediaPlayerPlay(Player) == -1)
+		{
+			UE_LOG(LogVlcMedia, Warning, TEXT("Failed to start pre-rolling media %s"), *Url);
+			Failed = true;
+
+			return;
+		}
+
+		PrimeStartCycles = FPlatformTime::Cycles64();
+
+		return;
+	}
+
+	if ((Player == nullptr) || Primed)
+	{
+		return;
+	}
+
+	const ELibvlcState State = FVlc::MediaPlayerGetState(Player);
+
+	if ((State == ELibvlcState::Error) || (State == ELibvlcState::Ended))
+	{
+		UE_LOG(LogVlcMedia, Warning, TEXT("Failed to pre-roll media %s: No samples were output"), *Url);
+		Failed = true;
+
+		return;
+	}
+
+	const uint64 FirstSampleCycles = Callbacks->GetFirstSampleCycles();
+
+	if ((FirstSampleCycles == 0) || (FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - FirstSampleCycles) < PrimeDuration.GetTotalMilliseconds()))
+	{
+		return;
+	}
+
+	FVlc::MediaPlayerSetPause(Player, 1);
+	Primed = true;
+
+	UE_LOG(LogVlcMedia, Verbose, TEXT("Preroll %p: Primed %s in %.1f ms"), this, *Url, FPlatformTime::ToMilliseconds64(FirstSampleCycles - PrimeStartCycles));
+}
@@ -0,0 +1,166 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+
+class FVlcMediaCallbacks;
+class FVlcMediaOpenTask;
+class FVlcMediaPrecacheArchive;
+class FVlcMediaSource;
+class IMediaOptions;
+
+struct FLibvlcInstance;
+struct FLibvlcMediaPlayer;
+
+
+/**
+ * Opens and primes the media that is queued to play next.
+ *
+ * The media is opened on a second VLC player in the background. Once it is
+ * open, the player starts playing into its own sample queues and is paused
+ * as soon as its first samples were output, so that the media player can
+ * hand over to it without waiting for the decoder. If the pre-rolled media
+ * is not taken, it is released in the background.
+ */
+class FVlcMediaPreroll
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InVlcInstance The LibVLC instance to use.
+	 * @param InUrl The URL of the media to open.
+	 * @param Options Optional media parameters.
+	 * @param InCrossfade Duration of the audio crossfade into this media.
+	 */
+	FVlcMediaPreroll(FLibvlcInstance* InVlcInstance, const FString& InUrl, const IMediaOptions* Options, FTimespan InCrossfade);
+
+	/** Destructor. */
+	~FVlcMediaPreroll();
+
+public:
+
+	/**
+	 * Take ownership of the primed player.
+	 *
+	 * Must only be called once the media is ready.
+	 *
+	 * @return The player (paused).
+	 * @see GetCallbacks, GetMediaSource, IsReady
+	 */
+	FLibvlcMediaPlayer* DetachPlayer();
+
+	/**
+	 * Get the output callbacks of the primed player.
+	 *
+	 * @return The callbacks, whose sample queues hold the first samples.
+	 */
+	const TSharedRef<FVlcMediaCallbacks, ESPMode::ThreadSafe>& GetCallbacks() const
+	{
+		return Callbacks;
+	}
+
+	/**
+	 * Get the duration of the audio crossfade into this media.
+	 *
+	 * @return Crossfade duration (0 = switch at the end of the current media).
+	 */
+	FTimespan GetCrossfade() const
+	{
+		return Crossfade;
+	}
+
+	/**
+	 * Get the opened media source.
+	 *
+	 * @return The media source, or nullptr if not opened yet.
+	 */
+	const TSharedPtr<FVlcMediaSource, ESPMode::ThreadSafe>& GetMediaSource() const
+	{
+		return MediaSource;
+	}
+
+	/**
+	 * Get the archive of the precached file, if any.
+	 *
+	 * @return The archive, or nullptr if the file is not being precached.
+	 */
+	const TSharedPtr<FVlcMediaPrecacheArchive, ESPMode::ThreadSafe>& GetPrecacheArchive() const
+	{
+		return PrecacheArchive;
+	}
+
+	/**
+	 * Get the URL of the media.
+	 *
+	 * @return Media URL.
+	 */
+	const FString& GetUrl() const
+	{
+		return Url;
+	}
+
+	/**
+	 * Check whether the media failed to open or play.
+	 *
+	 * @return true if failed, false otherwise.
+	 */
+	bool HasFailed() const
+	{
+		return Failed;
+	}
+
+	/**
+	 * Check whether the media is opened and its first samples were output.
+	 *
+	 * @return true if ready, false otherwise.
+	 * @see DetachPlayer
+	 */
+	bool IsReady() const
+	{
+		return Primed && (Player != nullptr);
+	}
+
+	/** Advance opening and priming (called on the game thread). */
+	void Tick();
+
+public:
+
+	/** Time to keep playing after the first sample, so that all streams output their first samples. */
+	static const FTimespan PrimeDuration;
+
+private:
+
+	/** Output callbacks of the pre-rolled player. */
+	TSharedRef<FVlcMediaCallbacks, ESPMode::ThreadSafe> Callbacks;
+
+	/** Duration of the audio crossfade into this media. */
+	FTimespan Crossfade;
+
+	/** Whether the media failed to open or play. */
+	bool Failed;
+
+	/** The media source. */
+	TSharedPtr<FVlcMediaSource, ESPMode::ThreadSafe> MediaSource;
+
+	/** The task that is opening the media source (only while opening). */
+	TSharedPtr<FVlcMediaOpenTask, ESPMode::ThreadSafe> OpenTask;
+
+	/** The pre-rolled VLC player. */
+	FLibvlcMediaPlayer* Player;
+
+	/** The precached file (if opened with the PrecacheFile option). */
+	TSharedPtr<FVlcMediaPrecacheArchive, ESPMode::ThreadSafe> PrecacheArchive;
+
+	/** Whether the player was paused after its first samples. */
+	bool Primed;
+
+	/** Cycle counter at which priming started. */
+	uint64 PrimeStartCycles;
+
+	/** The URL of the media. */
+	FString Url;
+};
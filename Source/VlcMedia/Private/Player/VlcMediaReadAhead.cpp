@@ -0,0 +1,276 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaReadAhead.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/Archive.h"
+
+
+/* FVlcMediaReadAhead structors
+ *****************************************************************************/
+
+FVlcMediaReadAhead::FVlcMediaReadAhead(const TSharedRef<FArchive, ESPMode::ThreadSafe>& InArchive, SIZE_T WindowSize)
+	: Archive(InArchive)
+	, DataEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	, Error(false)
+	, FillPosition(0)
+	, Generation(0)
+	, NumBlocks(FMath::Max<int32>(2, (int32)FMath::DivideAndRoundUp<SIZE_T>(WindowSize, BlockSize)))
+	, ReadPosition(0)
+	, Size((uint64)FMath::Max<int64>(0, InArchive->TotalSize()))
+	, Stopping(false)
+	, Thread(nullptr)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool(false))
+{
+	// block data is allocated when a block is first filled, so short media does not use the whole window
+	Blocks.SetNum(NumBlocks);
+
+	for (FBlock& Block : Blocks)
+	{
+		Block.Offset = 0;
+		Block.Ready = false;
+	}
+
+	Thread = FRunnableThread::Create(this, TEXT("VlcMediaReadAhead"), 0, TPri_BelowNormal);
+}
+
+
+FVlcMediaReadAhead::~FVlcMediaReadAhead()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(DataEvent);
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+}
+
+
+/* FVlcMediaReadAhead interface
+ *****************************************************************************/
+
+SSIZE_T FVlcMediaReadAhead::Read(void* Buffer, SIZE_T Length)
+{
+	if ((Length == 0) || (Thread == nullptr))
+	{
+		return (Thread == nullptr) ? -1 : 0;
+	}
+
+	double StallStartTime = 0.0;
+
+	while (true)
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			if (ReadPosition >= Size)
+			{
+				return 0;
+			}
+
+			const SIZE_T BytesRead = ReadFromBlocks((uint8*)Buffer, Length);
+
+			if (BytesRead > 0)
+			{
+				if (StallStartTime > 0.0)
+				{
+					NumMisses.Increment();
+					StallMicroseconds.Add((int64)((FPlatformTime::Seconds() - StallStartTime) * 1000000.0));
+				}
+				else
+				{
+					NumHits.Increment();
+				}
+
+				return (SSIZE_T)BytesRead;
+			}
+
+			if (Error || Stopping)
+			{
+				return -1;
+			}
+		}
+
+		// wait for the read-ahead thread
+		if (StallStartTime == 0.0)
+		{
+			StallStartTime = FPlatformTime::Seconds();
+		}
+
+		WorkEvent->Trigger();
+		DataEvent->Wait(100);
+	}
+}
+
+
+bool FVlcMediaReadAhead::Seek(uint64 Offset)
+{
+	if (Offset > Size)
+	{
+		return false;
+	}
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		const uint64 WindowStart = ReadPosition - (ReadPosition % BlockSize);
+
+		ReadPosition = Offset;
+
+		// keep the window if the new position was already read
+		if ((Offset >= WindowStart) && (Offset < FillPosition))
+		{
+			WorkEvent->Trigger();
+
+			return true;
+		}
+
+		// otherwise cancel outstanding blocks and restart at the new position
+		for (FBlock& DiscardedBlock : Blocks)
+		{
+			DiscardedBlock.Ready = false;
+		}
+
+		FillPosition = Offset - (Offset % BlockSize);
+		Error = false;
+		++Generation;
+	}
+
+	WorkEvent->Trigger();
+
+	return true;
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+uint32 FVlcMediaReadAhead::Run()
+{
+	while (true)
+	{
+		uint64 Offset = 0;
+		uint32 BlockGeneration = 0;
+		FBlock* FillBlock = nullptr;
+		int64 BytesToRead = 0;
+
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			if (Stopping)
+			{
+				break;
+			}
+
+			// read the next block if it is inside the window
+			const uint64 WindowStart = ReadPosition - (ReadPosition % BlockSize);
+
+			if (!Error && (FillPosition < Size) && (FillPosition < WindowStart + (uint64)BlockSize * NumBlocks))
+			{
+				FBlock& Block = GetBlock(FillPosition);
+
+				Block.Offset = FillPosition;
+				Block.Ready = false;
+
+				Offset = FillPosition;
+				BlockGeneration = Generation;
+				FillBlock = &Block;
+				BytesToRead = (int64)FMath::Min<uint64>(BlockSize, Size - FillPosition);
+			}
+		}
+
+		if (BytesToRead == 0)
+		{
+			WorkEvent->Wait();
+			continue;
+		}
+
+		// the block can't be reused while being filled, because the
+		// window only moves forward once the block was marked ready
+		if (FillBlock->Data.Num() == 0)
+		{
+			FillBlock->Data.SetNumUninitialized(BlockSize);
+		}
+
+		Archive->Seek(Offset);
+		Archive->Serialize(FillBlock->Data.GetData(), BytesToRead);
+
+		const bool Failed = Archive->IsError();
+
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			if (BlockGeneration == Generation)
+			{
+				if (Failed)
+				{
+					UE_LOG(LogVlcMedia, Warning, TEXT("Read-ahead %p: Failed to read media data at offset %llu"), this, Offset);
+					Error = true;
+				}
+				else
+				{
+					GetBlock(Offset).Ready = true;
+					FillPosition = Offset + BytesToRead;
+				}
+			}
+		}
+
+		DataEvent->Trigger();
+	}
+
+	return 0;
+}
+
+
+void FVlcMediaReadAhead::Stop()
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+		Stopping = true;
+	}
+
+	WorkEvent->Trigger();
+}
+
+
+/* FVlcMediaReadAhead implementation
+ *****************************************************************************/
+
+SIZE_T FVlcMediaReadAhead::ReadFromBlocks(uint8* Buffer, SIZE_T Length)
+{
+	SIZE_T BytesRead = 0;
+
+	while ((BytesRead < Length) && (ReadPosition < Size))
+	{
+		const FBlock& Block = GetBlock(ReadPosition);
+
+		if (!Block.Ready || (Block.Offset > ReadPosition) || (ReadPosition >= Block.Offset + BlockSize))
+		{
+			break;
+		}
+
+		const uint64 BlockOffset = ReadPosition - Block.Offset;
+		const SIZE_T BytesToCopy = (SIZE_T)FMath::Min<uint64>(Length - BytesRead, FMath::Min<uint64>(BlockSize, Size - Block.Offset) - BlockOffset);
+
+		FMemory::Memcpy(Buffer + BytesRead, Block.Data.GetData() + BlockOffset, BytesToCopy);
+
+		BytesRead += BytesToCopy;
+		ReadPosition += BytesToCopy;
+	}
+
+	if (BytesRead > 0)
+	{
+		// blocks before the read position are no longer needed
+		WorkEvent->Trigger();
+	}
+
+	return BytesRead;
+}
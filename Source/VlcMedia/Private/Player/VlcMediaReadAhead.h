@@ -0,0 +1,207 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Templates/SharedPointer.h"
+
+class FArchive;
+class FEvent;
+class FRunnableThread;
+
+
+/**
+ * Reads archive data ahead of the VLC input thread on a background thread.
+ *
+ * The archive is read in fixed-size blocks that fill a window starting at the
+ * current read position, so that the input thread is served from memory while
+ * the next blocks are being read. Seeking outside of the window cancels the
+ * outstanding blocks and restarts reading at the new position. Blocks are
+ * allocated as they are first needed.
+ *
+ * Read and Seek must be called from one thread at a time.
+ */
+class FVlcMediaReadAhead
+	: public FRunnable
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * The archive must not be accessed by anyone else while the read-ahead exists.
+	 *
+	 * @param InArchive The archive to read from.
+	 * @param WindowSize Number of bytes to read ahead (will be rounded up to at least two blocks).
+	 */
+	FVlcMediaReadAhead(const TSharedRef<FArchive, ESPMode::ThreadSafe>& InArchive, SIZE_T WindowSize);
+
+	/** Virtual destructor. */
+	virtual ~FVlcMediaReadAhead();
+
+public:
+
+	/**
+	 * Get the number of reads that were served without waiting.
+	 *
+	 * @return Number of reads.
+	 * @see GetNumMisses, GetStallTime
+	 */
+	int32 GetNumHits() const
+	{
+		return NumHits.GetValue();
+	}
+
+	/**
+	 * Get the number of reads that had to wait for data.
+	 *
+	 * @return Number of reads.
+	 * @see GetNumHits, GetStallTime
+	 */
+	int32 GetNumMisses() const
+	{
+		return NumMisses.GetValue();
+	}
+
+	/**
+	 * Get the total time that reads waited for data.
+	 *
+	 * @return Stall time.
+	 * @see GetNumMisses
+	 */
+	FTimespan GetStallTime() const
+	{
+		return FTimespan::FromMicroseconds((double)StallMicroseconds.GetValue());
+	}
+
+	/**
+	 * Get the size of the archive.
+	 *
+	 * @return Size (in bytes).
+	 */
+	uint64 GetSize() const
+	{
+		return Size;
+	}
+
+	/**
+	 * Get the size of the read-ahead window.
+	 *
+	 * @return Window size (in bytes).
+	 */
+	SIZE_T GetWindowSize() const
+	{
+		return (SIZE_T)BlockSize * NumBlocks;
+	}
+
+	/**
+	 * Read data at the current position.
+	 *
+	 * Blocks until the data is available.
+	 *
+	 * @param Buffer Will contain the data.
+	 * @param Length Maximum number of bytes to read.
+	 * @return Number of bytes read, 0 at the end of the archive, or -1 on error.
+	 * @see Seek
+	 */
+	SSIZE_T Read(void* Buffer, SIZE_T Length);
+
+	/**
+	 * Set the current read position.
+	 *
+	 * @param Offset The new position.
+	 * @return true on success, false if the position is beyond the end of the archive.
+	 * @see Read
+	 */
+	bool Seek(uint64 Offset);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+public:
+
+	/** Size of a read-ahead block (in bytes). */
+	static const uint32 BlockSize = 1024 * 1024;
+
+private:
+
+	/** A block of archive data. */
+	struct FBlock
+	{
+		/** The block's data (allocated by the read-ahead thread when the block is first filled). */
+		TArray<uint8> Data;
+
+		/** Archive offset of the block's first byte. */
+		uint64 Offset;
+
+		/** Whether the block's data is valid. */
+		bool Ready;
+	};
+
+	/** Get the block at the specified archive offset (must hold the critical section). */
+	FBlock& GetBlock(uint64 Offset)
+	{
+		return Blocks[(Offset / BlockSize) % NumBlocks];
+	}
+
+	/** Copy ready data at the read position into the buffer (must hold the critical section). */
+	SIZE_T ReadFromBlocks(uint8* Buffer, SIZE_T Length);
+
+private:
+
+	/** The archive to read from (accessed by read-ahead thread only). */
+	TSharedRef<FArchive, ESPMode::ThreadSafe> Archive;
+
+	/** The read-ahead blocks. */
+	TArray<FBlock> Blocks;
+
+	/** Critical section for synchronizing access to the blocks and positions. */
+	FCriticalSection CriticalSection;
+
+	/** Event that signals that a block was read. */
+	FEvent* DataEvent;
+
+	/** Whether the archive failed to read. */
+	bool Error;
+
+	/** Archive offset of the next block to be read. */
+	uint64 FillPosition;
+
+	/** Incremented on seeks that discard the blocks, so that outstanding reads are dropped. */
+	uint32 Generation;
+
+	/** Number of blocks in the window. */
+	int32 NumBlocks;
+
+	/** Number of reads that were served without waiting. */
+	FThreadSafeCounter NumHits;
+
+	/** Number of reads that had to wait for data. */
+	FThreadSafeCounter NumMisses;
+
+	/** Current read position. */
+	uint64 ReadPosition;
+
+	/** The archive size (in bytes). */
+	uint64 Size;
+
+	/** Total time that reads waited for data (in microseconds). */
+	FThreadSafeCounter64 StallMicroseconds;
+
+	/** Whether the thread should stop. */
+	bool Stopping;
+
+	/** The read-ahead thread. */
+	FRunnableThread* Thread;
+
+	/** Event that signals the read-ahead thread that there is work to do. */
+	FEvent* WorkEvent;
+};
@@ -0,0 +1,158 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaReaper.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+#include "Vlc.h"
+#include "VlcMediaCallbacks.h"
+#include "VlcMediaPlayerPool.h"
+#include "VlcMediaSource.h"
+
+
+/* FVlcMediaReaper structors
+ *****************************************************************************/
+
+FVlcMediaReaper::FVlcMediaReaper()
+	: Stopping(false)
+	, Thread(nullptr)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool(false))
+{ }
+
+
+FVlcMediaReaper::~FVlcMediaReaper()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	ReapPending();
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+}
+
+
+/* FVlcMediaReaper static functions
+ *****************************************************************************/
+
+FVlcMediaReaper& FVlcMediaReaper::Get()
+{
+	static FVlcMediaReaper Reaper;
+	return Reaper;
+}
+
+
+/* FVlcMediaReaper interface
+ *****************************************************************************/
+
+void FVlcMediaReaper::Flush()
+{
+	FScopeLock Lock(&ThreadCriticalSection);
+
+	if (Thread == nullptr)
+	{
+		ReapPending();
+		return;
+	}
+
+	while (NumPending.GetValue() > 0)
+	{
+		WorkEvent->Trigger();
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	// the thread will be recreated when needed
+	Thread->Kill(true);
+	delete Thread;
+	Thread = nullptr;
+	Stopping = false;
+}
+
+
+void FVlcMediaReaper::Reap(FLibvlcMediaPlayer* Player, const TSharedRef<FVlcMediaCallbacks, ESPMode::ThreadSafe>& Callbacks, const TSharedPtr<FVlcMediaSource, ESPMode::ThreadSafe>& MediaSource)
+{
+	FJob Job;
+	{
+		Job.Callbacks = Callbacks;
+		Job.MediaSource = MediaSource;
+		Job.Player = Player;
+	}
+
+	NumPending.Increment();
+	Jobs.Enqueue(Job);
+
+	FScopeLock Lock(&ThreadCriticalSection);
+
+	// fall back to releasing synchronously if threads are not available
+	if ((Thread == nullptr) && FPlatformProcess::SupportsMultithreading())
+	{
+		Thread = FRunnableThread::Create(this, TEXT("VlcMediaReaper"), 0, TPri_BelowNormal);
+	}
+
+	if (Thread == nullptr)
+	{
+		// the queue has a single consumer, which the lock guarantees without the thread
+		ReapPending();
+	}
+	else
+	{
+		WorkEvent->Trigger();
+	}
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+uint32 FVlcMediaReaper::Run()
+{
+	while (!Stopping)
+	{
+		WorkEvent->Wait();
+		ReapPending();
+	}
+
+	return 0;
+}
+
+
+void FVlcMediaReaper::Stop()
+{
+	Stopping = true;
+	WorkEvent->Trigger();
+}
+
+
+/* FVlcMediaReaper implementation
+ *****************************************************************************/
+
+void FVlcMediaReaper::ReapPending()
+{
+	FJob Job;
+
+	while (Jobs.Dequeue(Job))
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		// stopping joins the input and decoder threads, which may still call the callbacks
+		FVlc::MediaPlayerStop(Job.Player);
+		Job.Callbacks->Shutdown();
+		FVlcMediaPlayerPool::Get().Release(Job.Player);
+
+		// the media must outlive the player that reads from it
+		Job.Callbacks.Reset();
+		Job.MediaSource.Reset();
+
+		UE_LOG(LogVlcMedia, Verbose, TEXT("Reaper: Stopped player %p in %.1f ms"), Job.Player, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		NumPending.Decrement();
+	}
+}
@@ -0,0 +1,123 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Templates/SharedPointer.h"
+
+class FEvent;
+class FRunnableThread;
+class FVlcMediaCallbacks;
+class FVlcMediaSource;
+
+struct FLibvlcMediaPlayer;
+
+
+/**
+ * Stops VLC media players on a background thread and returns them to the player pool.
+ *
+ * Stopping a player joins LibVLC's input and decoder threads, which can take
+ * a long time for network streams. Players hand their VLC player over to the
+ * reaper when closing, together with the objects that its callbacks refer to,
+ * so that those stay alive until the player has been released.
+ *
+ * This class is thread-safe.
+ */
+class FVlcMediaReaper
+	: public FRunnable
+{
+public:
+
+	/**
+	 * Get the singleton instance.
+	 *
+	 * @return The reaper.
+	 */
+	static FVlcMediaReaper& Get();
+
+	/** Virtual destructor. */
+	virtual ~FVlcMediaReaper();
+
+public:
+
+	/**
+	 * Wait until all pending players have been released, and stop the reaper thread.
+	 *
+	 * Call this before releasing the LibVLC instance.
+	 */
+	void Flush();
+
+	/**
+	 * Get the number of players waiting to be released.
+	 *
+	 * @return Number of players.
+	 */
+	int32 GetNumPending() const
+	{
+		return NumPending.GetValue();
+	}
+
+	/**
+	 * Stop and release a player in the background.
+	 *
+	 * The player's event handlers must have been detached.
+	 *
+	 * @param Player The player to release.
+	 * @param Callbacks The player's output callbacks (will be shut down after the player stopped).
+	 * @param MediaSource The player's media source (will be released after the player).
+	 */
+	void Reap(FLibvlcMediaPlayer* Player, const TSharedRef<FVlcMediaCallbacks, ESPMode::ThreadSafe>& Callbacks, const TSharedPtr<FVlcMediaSource, ESPMode::ThreadSafe>& MediaSource);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+
+	/** Hidden constructor (use Get instead). */
+	FVlcMediaReaper();
+
+	/** Release all queued players. */
+	void ReapPending();
+
+private:
+
+	/** A player waiting to be released. */
+	struct FJob
+	{
+		/** The player's output callbacks. */
+		TSharedPtr<FVlcMediaCallbacks, ESPMode::ThreadSafe> Callbacks;
+
+		/** The player's media source. */
+		TSharedPtr<FVlcMediaSource, ESPMode::ThreadSafe> MediaSource;
+
+		/** The player to release. */
+		FLibvlcMediaPlayer* Player;
+	};
+
+	/** Players waiting to be released. */
+	TQueue<FJob, EQueueMode::Mpsc> Jobs;
+
+	/** Number of players waiting to be released. */
+	FThreadSafeCounter NumPending;
+
+	/** Whether the thread should stop. */
+	FThreadSafeBool Stopping;
+
+	/** The reaper thread (created on demand). */
+	FRunnableThread* Thread;
+
+	/** Critical section for synchronizing access to the thread, and for releasing players without it. */
+	FCriticalSection ThreadCriticalSection;
+
+	/** Event that signals the reaper thread that there is work to do. */
+	FEvent* WorkEvent;
+};
@@ -0,0 +1,314 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaSamples.h"
+#include "VlcMediaPrivate.h"
+
+#include "IMediaAudioSample.h"
+#include "IMediaTextureSample.h"
+#include "Misc/ScopeLock.h"
+
+
+namespace VlcMediaSamples
+{
+	/** Remove and return the oldest sample if it overlaps the specified time range. */
+	template<typename SampleType>
+	bool FetchSample(TArray<TSharedRef<SampleType, ESPMode::ThreadSafe>>& Samples, TRange<FTimespan> TimeRange, TSharedPtr<SampleType, ESPMode::ThreadSafe>& OutSample)
+	{
+		if (Samples.Num() == 0)
+		{
+			return false;
+		}
+
+		const TSharedRef<SampleType, ESPMode::ThreadSafe>& Sample = Samples[0];
+		const FTimespan SampleTime = Sample->GetTime();
+
+		if (!TimeRange.Overlaps(TRange<FTimespan>(SampleTime, SampleTime + Sample->GetDuration())))
+		{
+			return false;
+		}
+
+		OutSample = Sample;
+		Samples.RemoveAt(0, 1, false);
+
+		return true;
+	}
+}
+
+
+/* FVlcMediaSamples structors
+ *****************************************************************************/
+
+FVlcMediaSamples::FVlcMediaSamples()
+	: CrossfadeDuration(FTimespan::Zero())
+	, CrossfadeMixedFrames(0)
+	, CrossfadePendingFrames(0)
+	, CrossfadeSource(nullptr)
+	, VideoDropPolicy(EVlcMediaDropPolicy::DropOldest)
+	, VideoMaxBytes(0)
+	, VideoMaxFrames(0)
+	, VideoQueuedBytes(0)
+	, VideoReservedBytes(0)
+	, VideoReservedFrames(0)
+{ }
+
+
+/* FVlcMediaSamples interface
+ *****************************************************************************/
+
+void FVlcMediaSamples::AddVideo(const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>& Sample)
+{
+	LoopCache.RecordVideo(Sample);
+
+	FScopeLock Lock(&VideoCriticalSection);
+
+	VideoSamples.Add(Sample);
+	VideoQueuedBytes += GetVideoSampleSize(*Sample);
+}
+
+
+int32 FVlcMediaSamples::NumVideo() const
+{
+	FScopeLock Lock(&VideoCriticalSection);
+	return VideoSamples.Num();
+}
+
+
+void FVlcMediaSamples::ReleaseVideoReservation(SIZE_T SampleSize)
+{
+	FScopeLock Lock(&VideoCriticalSection);
+
+	// reservations may have been reset while the frame was being decoded
+	VideoReservedFrames = FMath::Max(0, VideoReservedFrames - 1);
+	VideoReservedBytes -= FMath::Min(VideoReservedBytes, SampleSize);
+}
+
+
+bool FVlcMediaSamples::ReserveVideo(SIZE_T SampleSize)
+{
+	// discarded samples are released outside the lock, because they return to their pool
+	TArray<TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>> DroppedSamples;
+
+	{
+		FScopeLock Lock(&VideoCriticalSection);
+
+		// frames that are being decoded count towards the limits, so that concurrent reservations cannot exceed them
+		auto IsFull = [&]() -> bool
+		{
+			if (VideoSamples.Num() == 0)
+			{
+				return false;
+			}
+
+			return ((VideoMaxFrames > 0) && (VideoSamples.Num() + VideoReservedFrames >= VideoMaxFrames)) ||
+				((VideoMaxBytes > 0) && (VideoQueuedBytes + VideoReservedBytes + SampleSize > VideoMaxBytes));
+		};
+
+		if (!IsFull())
+		{
+			++VideoReservedFrames;
+			VideoReservedBytes += SampleSize;
+
+			return true;
+		}
+
+		if (VideoDropPolicy == EVlcMediaDropPolicy::DropNewest)
+		{
+			DroppedVideoFrames.Increment();
+			return false;
+		}
+
+		while (IsFull())
+		{
+			const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe> Sample = VideoSamples[0];
+
+			VideoSamples.RemoveAt(0, 1, false);
+			VideoQueuedBytes -= GetVideoSampleSize(*Sample);
+			DroppedSamples.Add(Sample);
+			DiscardedVideoFrames.Increment();
+			DroppedVideoFrames.Increment();
+		}
+
+		++VideoReservedFrames;
+		VideoReservedBytes += SampleSize;
+	}
+
+	UE_LOG(LogVlcMedia, VeryVerbose, TEXT("Samples %llx: Dropped %i queued video frame(s)"), this, DroppedSamples.Num());
+
+	return true;
+}
+
+
+void FVlcMediaSamples::ResetVideoReservations()
+{
+	FScopeLock Lock(&VideoCriticalSection);
+
+	VideoReservedBytes = 0;
+	VideoReservedFrames = 0;
+}
+
+
+void FVlcMediaSamples::SetCrossfade(FVlcMediaSamples* Source, FTimespan Duration)
+{
+	FScopeLock Lock(&CrossfadeCriticalSection);
+
+	CrossfadeDuration = Duration;
+	CrossfadeMixedFrames = 0;
+	CrossfadePending.Reset();
+	CrossfadePendingFrames = 0;
+	CrossfadeSource = (Duration > FTimespan::Zero()) ? Source : nullptr;
+}
+
+
+void FVlcMediaSamples::SetVideoLimits(int32 InMaxFrames, SIZE_T InMaxBytes, EVlcMediaDropPolicy InDropPolicy)
+{
+	FScopeLock Lock(&VideoCriticalSection);
+
+	VideoDropPolicy = InDropPolicy;
+	VideoMaxBytes = InMaxBytes;
+	VideoMaxFrames = FMath::Max(0, InMaxFrames);
+}
+
+
+/* IMediaSamples interface
+ *****************************************************************************/
+
+bool FVlcMediaSamples::FetchAudio(TRange<FTimespan> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample)
+{
+	if (LoopCache.IsReplaying())
+	{
+		return LoopCache.FetchAudio(TimeRange, OutSample);
+	}
+
+	if (!AudioRing.Fetch(TimeRange, OutSample))
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CrossfadeCriticalSection);
+
+	if (CrossfadeSource != nullptr)
+	{
+		// the ring only holds VLC audio samples
+		MixCrossfade(static_cast<FVlcMediaAudioSample&>(*OutSample));
+	}
+
+	return true;
+}
+
+
+bool FVlcMediaSamples::FetchVideo(TRange<FTimespan> TimeRange, TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe>& OutSample)
+{
+	if (LoopCache.IsReplaying())
+	{
+		return LoopCache.FetchVideo(TimeRange, OutSample);
+	}
+
+	FScopeLock Lock(&VideoCriticalSection);
+
+	if (!VlcMediaSamples::FetchSample(VideoSamples, TimeRange, OutSample))
+	{
+		return false;
+	}
+
+	VideoQueuedBytes -= GetVideoSampleSize(*OutSample);
+
+	return true;
+}
+
+
+void FVlcMediaSamples::FlushSamples()
+{
+	TArray<TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>> FlushedVideoSamples;
+
+	AudioRing.Flush();
+
+	{
+		FScopeLock Lock(&VideoCriticalSection);
+		Swap(VideoSamples, FlushedVideoSamples);
+		DiscardedVideoFrames.Add(FlushedVideoSamples.Num());
+		VideoQueuedBytes = 0;
+		VideoReservedBytes = 0;
+		VideoReservedFrames = 0;
+	}
+}
+
+
+/* FVlcMediaSamples implementation
+ *****************************************************************************/
+
+SIZE_T FVlcMediaSamples::GetVideoSampleSize(const IMediaTextureSample& Sample)
+{
+	return (SIZE_T)Sample.GetStride() * Sample.GetDim().Y;
+}
+
+
+void FVlcMediaSamples::MixCrossfade(FVlcMediaAudioSample& Sample)
+{
+	// VLC is configured to output 32-bit float
+	if (Sample.GetFormat() != EMediaAudioSampleFormat::Float)
+	{
+		return;
+	}
+
+	const uint32 Channels = Sample.GetChannels();
+	const uint32 Frames = Sample.GetFrames();
+
+	const double CrossfadeSeconds = CrossfadeDuration.GetTotalSeconds();
+	const double GainPerFrame = 1.0 / (CrossfadeSeconds * FMath::Max(1u, Sample.GetSampleRate()));
+	const double StartGain = CrossfadeMixedFrames * GainPerFrame;
+
+	CrossfadeMixedFrames += Frames;
+
+	float* Dest = (float*)Sample.GetMutableBuffer();
+
+	for (uint32 Frame = 0; Frame < Frames; ++Frame)
+	{
+		const float Gain = (float)FMath::Clamp(StartGain + Frame * GainPerFrame, 0.0, 1.0);
+
+		for (uint32 Channel = 0; Channel < Channels; ++Channel)
+		{
+			Dest[Frame * Channels + Channel] *= Gain;
+		}
+	}
+
+	// the fading media's clock is no longer updated, so its frames are mixed in order,
+	// and frames left over from a chunk are mixed into the next fetched chunk
+	uint32 Frame = 0;
+
+	while (Frame < Frames)
+	{
+		if (!CrossfadePending.IsValid() || (CrossfadePendingFrames >= CrossfadePending->GetFrames()))
+		{
+			CrossfadePending.Reset();
+			CrossfadePendingFrames = 0;
+
+			if (!CrossfadeSource->AudioRing.Fetch(TRange<FTimespan>::All(), CrossfadePending))
+			{
+				break;
+			}
+
+			if ((CrossfadePending->GetChannels() != Channels) ||
+				(CrossfadePending->GetSampleRate() != Sample.GetSampleRate()) ||
+				(CrossfadePending->GetFormat() != Sample.GetFormat()))
+			{
+				CrossfadePending.Reset();
+				continue;
+			}
+		}
+
+		const uint32 NumFrames = FMath::Min(Frames - Frame, CrossfadePending->GetFrames() - CrossfadePendingFrames);
+		const float* Source = (const float*)CrossfadePending->GetBuffer() + CrossfadePendingFrames * Channels;
+
+		for (uint32 Index = 0; Index < NumFrames; ++Index, ++Frame)
+		{
+			const float Gain = (float)FMath::Clamp(StartGain + Frame * GainPerFrame, 0.0, 1.0);
+
+			for (uint32 Channel = 0; Channel < Channels; ++Channel)
+			{
+				Dest[Frame * Channels + Channel] += Source[Index * Channels + Channel] * (1.0f - Gain);
+			}
+		}
+
+		CrossfadePendingFrames += NumFrames;
+	}
+}
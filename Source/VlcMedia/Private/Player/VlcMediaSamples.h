@@ -0,0 +1,304 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "IMediaSamples.h"
+#include "Templates/SharedPointer.h"
+
+#include "VlcMediaAudioSample.h"
+#include "VlcMediaLoopCache.h"
+
+class IMediaAudioSample;
+class IMediaTextureSample;
+
+enum class EVlcMediaDropPolicy : uint8;
+
+
+/**
+ * Queues of media samples produced by the VLC callbacks.
+ *
+ * Unlike FMediaSamples, the video queue is bounded. Room for a new frame is
+ * reserved before the decoder writes into a pooled buffer, so that frames are
+ * not decoded only to be discarded when the game thread stalls.
+ *
+ * Audio is queued in a lock-free ring of fixed-size chunks that is written by
+ * the VLC audio thread and read by the thread that fetches samples.
+ *
+ * Samples that are added are also recorded by the loop cache, if enabled.
+ * While the loop cache is replaying, samples are fetched from the cache only.
+ */
+class FVlcMediaSamples
+	: public IMediaSamples
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaSamples();
+
+	/** Virtual destructor. */
+	virtual ~FVlcMediaSamples() { }
+
+public:
+
+	/**
+	 * Add audio frames to the queue.
+	 *
+	 * Must be called on the VLC audio thread only.
+	 *
+	 * @param Buffer The audio frames to add.
+	 * @param NumFrames Number of frames in the buffer.
+	 * @param Time The time of the first frame (in the player's local clock).
+	 * @see AddVideo, NumAudio, SetAudioFormat
+	 */
+	void AddAudio(const void* Buffer, uint32 NumFrames, FTimespan Time)
+	{
+		AudioRing.Write(Buffer, NumFrames, Time);
+		LoopCache.RecordAudio(Buffer, NumFrames, Time);
+	}
+
+	/**
+	 * Add a video sample to the queue.
+	 *
+	 * The reservation that was made for the sample's frame must have been
+	 * released already.
+	 *
+	 * @param Sample The sample to add.
+	 * @see AddAudio, NumVideo, ReleaseVideoReservation
+	 */
+	void AddVideo(const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>& Sample);
+
+	/**
+	 * Discard all audio frames that were added so far.
+	 *
+	 * Must be called on the VLC audio thread only.
+	 *
+	 * @see AddAudio, DrainAudio
+	 */
+	void DiscardAudio()
+	{
+		AudioRing.Discard();
+	}
+
+	/**
+	 * Make frames that were added so far available, because no more frames will follow.
+	 *
+	 * Must be called on the VLC audio thread only.
+	 *
+	 * @see AddAudio, DiscardAudio
+	 */
+	void DrainAudio()
+	{
+		AudioRing.Drain();
+	}
+
+	/**
+	 * Get the number of audio frames that were dropped because the audio queue was full.
+	 *
+	 * @return Number of dropped frames.
+	 * @see AddAudio
+	 */
+	int32 GetDroppedAudioFrames() const
+	{
+		return AudioRing.GetDroppedFrames();
+	}
+
+	/**
+	 * Get the number of queued video frames that were removed without being fetched.
+	 *
+	 * This includes frames dropped because the queue was full and frames
+	 * removed by flushing.
+	 *
+	 * @return Number of discarded frames.
+	 * @see GetDroppedVideoFrames
+	 */
+	int32 GetDiscardedVideoFrames() const
+	{
+		return DiscardedVideoFrames.GetValue();
+	}
+
+	/**
+	 * Get the number of frames that were dropped because the video queue was full.
+	 *
+	 * @return Number of dropped frames.
+	 * @see SetVideoLimits
+	 */
+	int32 GetDroppedVideoFrames() const
+	{
+		return DroppedVideoFrames.GetValue();
+	}
+
+	/**
+	 * Get the cache of decoded samples for short looping media.
+	 *
+	 * @return The loop cache.
+	 */
+	FVlcMediaLoopCache& GetLoopCache()
+	{
+		return LoopCache;
+	}
+
+	/**
+	 * Get the number of queued audio samples.
+	 *
+	 * @return Number of samples.
+	 * @see AddAudio, NumVideo
+	 */
+	int32 NumAudio() const
+	{
+		return AudioRing.Num();
+	}
+
+	/**
+	 * Get the number of queued video samples.
+	 *
+	 * @return Number of samples.
+	 * @see AddVideo, NumAudio
+	 */
+	int32 NumVideo() const;
+
+	/**
+	 * Release the reservation of a frame that was decoded, or that will not be decoded.
+	 *
+	 * @param SampleSize Size of the frame's buffer (in bytes), as passed to ReserveVideo.
+	 * @see ReserveVideo
+	 */
+	void ReleaseVideoReservation(SIZE_T SampleSize);
+
+	/**
+	 * Make room in the video queue for a frame that is about to be decoded.
+	 *
+	 * Depending on the drop policy, this either discards queued frames or
+	 * rejects the new frame. A frame that exceeds the byte limit on its own
+	 * is accepted if the queue is empty. Accepted frames count towards the
+	 * limits until their reservation is released.
+	 *
+	 * @param SampleSize Size of the frame's buffer (in bytes).
+	 * @return true if the frame should be decoded into a sample, false if it should be dropped.
+	 * @see ReleaseVideoReservation, ResetVideoReservations, SetVideoLimits
+	 */
+	bool ReserveVideo(SIZE_T SampleSize);
+
+	/**
+	 * Forget all video frame reservations, e.g. when the frame format changes.
+	 *
+	 * Reservations that are released later are ignored.
+	 *
+	 * @see ReserveVideo
+	 */
+	void ResetVideoReservations();
+
+	/**
+	 * Set the format of audio frames to be added.
+	 *
+	 * Must be called on the VLC audio thread only.
+	 *
+	 * @param Channels Number of audio channels.
+	 * @param SampleFormat The sample format.
+	 * @param SampleRate The sample rate.
+	 * @param SampleSize Size of a single sample (in bytes).
+	 * @see AddAudio
+	 */
+	void SetAudioFormat(uint32 Channels, EMediaAudioSampleFormat SampleFormat, uint32 SampleRate, uint32 SampleSize)
+	{
+		AudioRing.SetFormat(Channels, SampleFormat, SampleRate, SampleSize);
+		LoopCache.SetAudioFormat(Channels, SampleFormat, SampleRate, SampleSize);
+	}
+
+	/**
+	 * Mix the audio of another sample queue into this one, fading it out.
+	 *
+	 * Audio frames of the other queue are consumed in order, as many as each
+	 * chunk that is fetched from this queue holds, and this queue's audio is
+	 * faded in over the crossfade duration, counted in frames that were mixed.
+	 * Chunk times are not used, because primed chunks share the same time.
+	 *
+	 * @param Source The sample queue to fade out (nullptr = stop mixing; must stay alive until then).
+	 * @param Duration Duration of the crossfade.
+	 */
+	void SetCrossfade(FVlcMediaSamples* Source, FTimespan Duration);
+
+	/**
+	 * Set the limits of the video queue.
+	 *
+	 * @param InMaxFrames Maximum number of queued frames (0 = unlimited).
+	 * @param InMaxBytes Maximum size of queued frames (in bytes; 0 = unlimited).
+	 * @param InDropPolicy Which frame to discard when the queue is full.
+	 * @see ReserveVideo
+	 */
+	void SetVideoLimits(int32 InMaxFrames, SIZE_T InMaxBytes, EVlcMediaDropPolicy InDropPolicy);
+
+public:
+
+	//~ IMediaSamples interface
+
+	virtual bool FetchAudio(TRange<FTimespan> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample) override;
+	virtual bool FetchVideo(TRange<FTimespan> TimeRange, TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe>& OutSample) override;
+	virtual void FlushSamples() override;
+
+private:
+
+	/** Get the size of a video sample's buffer (in bytes). */
+	static SIZE_T GetVideoSampleSize(const IMediaTextureSample& Sample);
+
+	/** Mix the next audio frames of the crossfade source into a fetched chunk (must hold CrossfadeCriticalSection). */
+	void MixCrossfade(FVlcMediaAudioSample& Sample);
+
+private:
+
+	/** Queued audio chunks. */
+	FVlcMediaAudioRingBuffer AudioRing;
+
+	/** Critical section for synchronizing access to the crossfade settings. */
+	FCriticalSection CrossfadeCriticalSection;
+
+	/** Duration of the crossfade. */
+	FTimespan CrossfadeDuration;
+
+	/** Number of frames that were mixed since the crossfade started. */
+	uint64 CrossfadeMixedFrames;
+
+	/** The crossfade source's chunk that is partially mixed (nullptr = none). */
+	TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe> CrossfadePending;
+
+	/** Number of frames of the pending chunk that were mixed already. */
+	uint32 CrossfadePendingFrames;
+
+	/** The sample queue whose audio is faded out (nullptr = none). */
+	FVlcMediaSamples* CrossfadeSource;
+
+	/** Number of queued video frames that were removed without being fetched. */
+	FThreadSafeCounter DiscardedVideoFrames;
+
+	/** Number of frames dropped because the video queue was full. */
+	FThreadSafeCounter DroppedVideoFrames;
+
+	/** Decoded samples of short looping media. */
+	FVlcMediaLoopCache LoopCache;
+
+	/** Which frame to discard when the video queue is full. */
+	EVlcMediaDropPolicy VideoDropPolicy;
+
+	/** Maximum size of queued video frames (in bytes; 0 = unlimited). */
+	SIZE_T VideoMaxBytes;
+
+	/** Maximum number of queued video frames (0 = unlimited). */
+	int32 VideoMaxFrames;
+
+	/** Total size of queued video frames (in bytes). */
+	SIZE_T VideoQueuedBytes;
+
+	/** Total size of video frames that are reserved, but not queued yet (in bytes). */
+	SIZE_T VideoReservedBytes;
+
+	/** Number of video frames that are reserved, but not queued yet. */
+	int32 VideoReservedFrames;
+
+	/** Queued video samples (oldest first). */
+	TArray<TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>> VideoSamples;
+
+	/** Critical section for synchronizing access to the video queue and its limits. */
+	mutable FCriticalSection VideoCriticalSection;
+};
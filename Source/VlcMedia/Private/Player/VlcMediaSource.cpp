@@ -2,19 +2,49 @@
 
 #include "VlcMediaSource.h"
 #include "VlcMediaPrivate.h"
+#include "VlcMediaReadAhead.h"
+
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
 
 #include "Vlc.h"
+#include "VlcMediaKeyframeCache.h"
+#include "VlcMediaKeyframeIndex.h"
+
+
+namespace VlcMediaSource
+{
+	/** Check whether an archive reads from memory, i.e. a file that was precached by the engine. */
+	bool IsMemoryArchive(const FArchive& Archive)
+	{
+		const FString ArchiveName = Archive.GetArchiveName();
+
+		return ArchiveName.StartsWith(TEXT("FArrayReader")) ||
+			ArchiveName.StartsWith(TEXT("FBufferReader")) ||
+			ArchiveName.StartsWith(TEXT("FLargeMemoryReader")) ||
+			ArchiveName.StartsWith(TEXT("FMemory"));
+	}
+}
 
 
 /* FVlcMediaReader structors
 *****************************************************************************/
 
 FVlcMediaSource::FVlcMediaSource(FLibvlcInstance* InVlcInstance)
-	: Media(nullptr)
+	: KeyframeIndexRequested(false)
+	, MappedPosition(0)
+	, Media(nullptr)
 	, VlcInstance(InVlcInstance)
 { }
 
 
+FVlcMediaSource::~FVlcMediaSource()
+{
+	Close();
+}
+
+
 /* FVlcMediaReader interface
 *****************************************************************************/
 
@@ -36,13 +66,47 @@ FTimespan FVlcMediaSource::GetDuration() const
 }
 
 
-FLibvlcMedia* FVlcMediaSource::OpenArchive(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl)
+FString FVlcMediaSource::GetStats() const
+{
+	TSharedPtr<FVlcMediaReadAhead, ESPMode::ThreadSafe> ReadAhead = DataReadAhead;
+
+	if (!ReadAhead.IsValid())
+	{
+		return FString();
+	}
+
+	const int32 NumHits = ReadAhead->GetNumHits();
+	const int32 NumReads = NumHits + ReadAhead->GetNumMisses();
+
+	FString StatsString;
+	{
+		StatsString += TEXT("Read-Ahead\n");
+		StatsString += FString::Printf(TEXT("    Window: %i MB\n"), (int32)(ReadAhead->GetWindowSize() / (1024 * 1024)));
+		StatsString += FString::Printf(TEXT("    Hit Rate: %.1f%% (%i of %i reads)\n"), (NumReads > 0) ? (100.0f * NumHits / NumReads) : 0.0f, NumHits, NumReads);
+		StatsString += FString::Printf(TEXT("    Stall Time: %.1f ms\n"), ReadAhead->GetStallTime().GetTotalMilliseconds());
+		StatsString += TEXT("\n");
+	}
+
+	return StatsString;
+}
+
+
+FLibvlcMedia* FVlcMediaSource::OpenArchive(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, bool ReadAhead)
 {
 	check(Media == nullptr);
 
 	if (Archive->TotalSize() > 0)
 	{
 		Data = Archive;
+
+		const int32 ReadAheadMegabytes = GetDefault<UVlcMediaSettings>()->ReadAheadMegabytes;
+
+		// reading ahead in-memory archives would only add a copy and a thread
+		if (ReadAhead && (ReadAheadMegabytes > 0) && !VlcMediaSource::IsMemoryArchive(*Archive))
+		{
+			DataReadAhead = MakeShareable(new FVlcMediaReadAhead(Archive, (SIZE_T)ReadAheadMegabytes * 1024 * 1024));
+		}
+
 		Media = FVlc::MediaNewCallbacks(
 			VlcInstance,
 			nullptr,
@@ -55,6 +119,7 @@ FLibvlcMedia* FVlcMediaSource::OpenArchive(const TSharedRef<FArchive, ESPMode::T
 		if (Media == nullptr)
 		{
 			UE_LOG(LogVlcMedia, Warning, TEXT("Failed to open media from archive: %s (%s)"), *OriginalUrl, ANSI_TO_TCHAR(FVlc::Errmsg()));
+			DataReadAhead.Reset();
 			Data.Reset();
 		}
 		else
@@ -67,6 +132,57 @@ FLibvlcMedia* FVlcMediaSource::OpenArchive(const TSharedRef<FArchive, ESPMode::T
 }
 
 
+FLibvlcMedia* FVlcMediaSource::OpenMappedFile(const FString& FilePath, const FString& OriginalUrl)
+{
+	check(Media == nullptr);
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+
+	if (!MappedFile.IsValid() || (MappedFile->GetFileSize() <= 0))
+	{
+		UE_LOG(LogVlcMedia, Verbose, TEXT("Failed to memory map media file: %s"), *FilePath);
+		MappedFile.Reset();
+
+		return nullptr;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion());
+
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogVlcMedia, Verbose, TEXT("Failed to memory map media file region: %s"), *FilePath);
+		MappedFile.Reset();
+
+		return nullptr;
+	}
+
+	MappedPosition = 0;
+
+	Media = FVlc::MediaNewCallbacks(
+		VlcInstance,
+		&FVlcMediaSource::HandleMappedMediaOpen,
+		&FVlcMediaSource::HandleMappedMediaRead,
+		&FVlcMediaSource::HandleMappedMediaSeek,
+		&FVlcMediaSource::HandleMappedMediaClose,
+		this
+	);
+
+	if (Media == nullptr)
+	{
+		UE_LOG(LogVlcMedia, Warning, TEXT("Failed to open memory mapped media file: %s (%s)"), *OriginalUrl, ANSI_TO_TCHAR(FVlc::Errmsg()));
+
+		MappedRegion.Reset();
+		MappedFile.Reset();
+	}
+	else
+	{
+		CurrentUrl = OriginalUrl;
+	}
+
+	return Media;
+}
+
+
 FLibvlcMedia* FVlcMediaSource::OpenUrl(const FString& Url)
 {
 	check(Media == nullptr);
@@ -94,11 +210,44 @@ void FVlcMediaSource::Close()
 		Media = nullptr;
 	}
 
+	DataReadAhead.Reset();
 	Data.Reset();
+	KeyframeFilePath.Reset();
+	KeyframeIndex.Reset();
+	KeyframeIndexFuture = TFuture<TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe>>();
+	KeyframeIndexRequested = false;
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	MappedPosition = 0;
 	CurrentUrl.Reset();
 }
 
 
+void FVlcMediaSource::RequestKeyframeIndex()
+{
+	if (!KeyframeIndexRequested)
+	{
+		KeyframeIndexRequested = true;
+
+		if (!KeyframeFilePath.IsEmpty())
+		{
+			const FString FilePath = KeyframeFilePath;
+
+			// reading the sample tables may take a while
+			KeyframeIndexFuture = Async<TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe>>(EAsyncExecution::ThreadPool, [FilePath]()
+			{
+				return FVlcMediaKeyframeCache::Get().Find(FilePath);
+			});
+		}
+	}
+	else if (KeyframeIndexFuture.IsValid() && KeyframeIndexFuture.IsReady())
+	{
+		KeyframeIndex = KeyframeIndexFuture.Get();
+		KeyframeIndexFuture = TFuture<TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe>>();
+	}
+}
+
+
 /* FVlcMediaReader static functions
 *****************************************************************************/
 
@@ -126,6 +275,13 @@ SSIZE_T FVlcMediaSource::HandleMediaRead(void* Opaque, void* Buffer, SIZE_T Leng
 		return -1;
 	}
 
+	TSharedPtr<FVlcMediaReadAhead, ESPMode::ThreadSafe> ReadAhead = Reader->DataReadAhead;
+
+	if (ReadAhead.IsValid())
+	{
+		return ReadAhead->Read(Buffer, Length);
+	}
+
 	TSharedPtr<FArchive, ESPMode::ThreadSafe> Data = Reader->Data;
 
 	if (!Reader->Data.IsValid())
@@ -160,6 +316,19 @@ int FVlcMediaSource::HandleMediaSeek(void* Opaque, uint64 Offset)
 		return -1;
 	}
 
+	TSharedPtr<FVlcMediaReadAhead, ESPMode::ThreadSafe> ReadAhead = Reader->DataReadAhead;
+
+	if (ReadAhead.IsValid())
+	{
+		if (ReadAhead->GetSize() <= Offset)
+		{
+			return -1;
+		}
+
+		// cancels outstanding reads if the offset is outside the read-ahead window
+		return ReadAhead->Seek(Offset) ? 0 : -1;
+	}
+
 	TSharedPtr<FArchive, ESPMode::ThreadSafe> Data = Reader->Data;
 
 	if (!Reader->Data.IsValid())
@@ -182,8 +351,88 @@ void FVlcMediaSource::HandleMediaClose(void* Opaque)
 {
 	auto Reader = (FVlcMediaSource*)Opaque;
 
-	if (Reader != nullptr)
+	if (Reader == nullptr)
+	{
+		return;
+	}
+
+	TSharedPtr<FVlcMediaReadAhead, ESPMode::ThreadSafe> ReadAhead = Reader->DataReadAhead;
+
+	if (ReadAhead.IsValid())
+	{
+		ReadAhead->Seek(0);
+	}
+	else if (Reader->Data.IsValid())
 	{
 		Reader->Data->Seek(0);
 	}
 }
+
+
+int FVlcMediaSource::HandleMappedMediaOpen(void* Opaque, void** OutData, uint64* OutSize)
+{
+	auto Reader = (FVlcMediaSource*)Opaque;
+
+	if ((Reader == nullptr) || !Reader->MappedRegion.IsValid())
+	{
+		return -1;
+	}
+
+	Reader->MappedPosition = 0;
+
+	*OutData = Reader;
+	*OutSize = (uint64)Reader->MappedRegion->GetMappedSize();
+
+	return 0;
+}
+
+
+SSIZE_T FVlcMediaSource::HandleMappedMediaRead(void* Opaque, void* Buffer, SIZE_T Length)
+{
+	auto Reader = (FVlcMediaSource*)Opaque;
+
+	if ((Reader == nullptr) || !Reader->MappedRegion.IsValid())
+	{
+		return -1;
+	}
+
+	const uint64 MappedSize = (uint64)Reader->MappedRegion->GetMappedSize();
+
+	if (Reader->MappedPosition >= MappedSize)
+	{
+		return 0;
+	}
+
+	const SIZE_T BytesToRead = (SIZE_T)FMath::Min<uint64>(Length, MappedSize - Reader->MappedPosition);
+
+	FMemory::Memcpy(Buffer, Reader->MappedRegion->GetMappedPtr() + Reader->MappedPosition, BytesToRead);
+	Reader->MappedPosition += BytesToRead;
+
+	return (SSIZE_T)BytesToRead;
+}
+
+
+int FVlcMediaSource::HandleMappedMediaSeek(void* Opaque, uint64 Offset)
+{
+	auto Reader = (FVlcMediaSource*)Opaque;
+
+	if ((Reader == nullptr) || !Reader->MappedRegion.IsValid() || ((uint64)Reader->MappedRegion->GetMappedSize() < Offset))
+	{
+		return -1;
+	}
+
+	Reader->MappedPosition = Offset;
+
+	return 0;
+}
+
+
+void FVlcMediaSource::HandleMappedMediaClose(void* Opaque)
+{
+	auto Reader = (FVlcMediaSource*)Opaque;
+
+	if (Reader != nullptr)
+	{
+		Reader->MappedPosition = 0;
+	}
+}
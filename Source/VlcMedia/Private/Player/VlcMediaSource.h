@@ -3,6 +3,14 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Templates/SharedPointer.h"
+#include "Templates/UniquePtr.h"
+
+class FVlcMediaKeyframeIndex;
+class FVlcMediaReadAhead;
+class IMappedFileHandle;
+class IMappedFileRegion;
 
 
 struct FLibvlcInstance;
@@ -23,6 +31,9 @@ public:
 	 */
 	FVlcMediaSource(FLibvlcInstance* InVlcInstance);
 
+	/** Destructor. */
+	~FVlcMediaSource();
+
 public:
 
 	/** Get the media object. */
@@ -44,16 +55,52 @@ public:
 	 */
 	FTimespan GetDuration() const;
 
+	/**
+	 * Get the keyframe index of the media.
+	 *
+	 * @return The index, or nullptr if the media was not indexed (yet).
+	 * @see RequestKeyframeIndex
+	 */
+	const TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe>& GetKeyframeIndex() const
+	{
+		return KeyframeIndex;
+	}
+
+	/**
+	 * Get the media source's read statistics.
+	 *
+	 * @return Statistics string, or empty string if not available.
+	 */
+	FString GetStats() const;
+
 	/**
 	 * Open a media source using the given archive.
 	 *
 	 * You must call Close() if this media source is open prior to calling this method.
 	 *
 	 * @param Archive The archive to read media data from.
+	 * @param OriginalUrl The URL of the media that the archive was created for.
+	 * @param ReadAhead Whether to read the archive ahead on a background thread (ignored for in-memory archives).
 	 * @return The media object.
 	 * @see OpenUrl, Close
 	 */
-	FLibvlcMedia* OpenArchive(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl);
+	FLibvlcMedia* OpenArchive(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, bool ReadAhead);
+
+	/**
+	 * Open a media source by memory mapping a local file.
+	 *
+	 * Reads are served directly from the mapping, and the mapped pages are
+	 * shared with other players that open the same file. This fails if the
+	 * platform does not support memory mapped files.
+	 *
+	 * You must call Close() if this media source is open prior to calling this method.
+	 *
+	 * @param FilePath The path of the file to map.
+	 * @param OriginalUrl The URL of the file.
+	 * @return The media object, or nullptr if the file could not be mapped.
+	 * @see OpenArchive, OpenUrl, Close
+	 */
+	FLibvlcMedia* OpenMappedFile(const FString& FilePath, const FString& OriginalUrl);
 
 	/**
 	 * Open a media source from the specified URL.
@@ -73,6 +120,28 @@ public:
 	 */
 	void Close();
 
+	/**
+	 * Build the keyframe index of the media in the background, if it can be indexed.
+	 *
+	 * The index is built on the first call only. Later calls pick up the
+	 * index once it is done, so that it is not built for media that is
+	 * never seeked in fast mode.
+	 *
+	 * @see GetKeyframeIndex, SetKeyframeFile
+	 */
+	void RequestKeyframeIndex();
+
+	/**
+	 * Set the local file that the keyframe index can be built from.
+	 *
+	 * @param FilePath The path of the media file.
+	 * @see RequestKeyframeIndex
+	 */
+	void SetKeyframeFile(const FString& FilePath)
+	{
+		KeyframeFilePath = FilePath;
+	}
+
 private:
 
 	/** Handles open callbacks from VLC. */
@@ -87,11 +156,47 @@ private:
 	/** Handles close callbacks from VLC. */
 	static void HandleMediaClose(void* Opaque);
 
+	/** Handles open callbacks from VLC for memory mapped files. */
+	static int HandleMappedMediaOpen(void* Opaque, void** OutData, uint64* OutSize);
+
+	/** Handles read callbacks from VLC for memory mapped files. */
+	static SSIZE_T HandleMappedMediaRead(void* Opaque, void* Buffer, SIZE_T Length);
+
+	/** Handles seek callbacks from VLC for memory mapped files. */
+	static int HandleMappedMediaSeek(void* Opaque, uint64 Offset);
+
+	/** Handles close callbacks from VLC for memory mapped files. */
+	static void HandleMappedMediaClose(void* Opaque);
+
 private:
 
 	/** The file or memory archive to stream from (for local media only). */
 	TSharedPtr<FArchive, ESPMode::ThreadSafe> Data;
 
+	/** Reads the archive ahead of VLC's input thread (optional). */
+	TSharedPtr<FVlcMediaReadAhead, ESPMode::ThreadSafe> DataReadAhead;
+
+	/** Path of the local file to build the keyframe index from (empty = media can't be indexed). */
+	FString KeyframeFilePath;
+
+	/** Keyframe index of the media (optional). */
+	TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe> KeyframeIndex;
+
+	/** The keyframe index being built (only while building). */
+	TFuture<TSharedPtr<FVlcMediaKeyframeIndex, ESPMode::ThreadSafe>> KeyframeIndexFuture;
+
+	/** Whether the keyframe index was requested already. */
+	bool KeyframeIndexRequested;
+
+	/** The mapped file (for memory mapped local media only). */
+	TUniquePtr<IMappedFileHandle> MappedFile;
+
+	/** Current read position in the mapped file (accessed by VLC input thread only). */
+	uint64 MappedPosition;
+
+	/** The mapped region covering the entire file. */
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
 	/** The media object. */
 	FLibvlcMedia* Media;
 
@@ -0,0 +1,252 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaTextureSample.h"
+#include "VlcMediaPrivate.h"
+
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+
+
+/**
+ * Storage for pooled texture samples.
+ */
+class FVlcMediaTextureSamplePool::FStorage
+{
+public:
+
+	/** Default constructor. */
+	FStorage()
+		: AllocatedBytes(0)
+		, BufferSize(0)
+		, HighWaterBytes(0)
+		, NumSamples(0)
+	{ }
+
+	/** Destructor. */
+	~FStorage()
+	{
+		Reset();
+	}
+
+public:
+
+	/** Acquire a sample with a buffer of the specified size. */
+	FVlcMediaTextureSample* Acquire(SIZE_T InBufferSize)
+	{
+		FVlcMediaTextureSample* Sample = nullptr;
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			BufferSize = InBufferSize;
+
+			// prefer samples whose buffer can be reused as is
+			for (int32 Index = Available.Num() - 1; Index >= 0; --Index)
+			{
+				if (Available[Index]->GetBufferSize() == InBufferSize)
+				{
+					Sample = Available[Index];
+					Available.RemoveAtSwap(Index, 1, false);
+
+					break;
+				}
+			}
+
+			if (Sample == nullptr)
+			{
+				if (Available.Num() > 0)
+				{
+					Sample = Available.Pop(false);
+				}
+				else
+				{
+					Sample = new FVlcMediaTextureSample;
+					++NumSamples;
+				}
+
+				ResizeBuffer(*Sample, InBufferSize);
+			}
+		}
+
+		Sample->InitializePoolable();
+
+		return Sample;
+	}
+
+	/** Make sure that the specified number of samples with the given buffer size are available. */
+	void Prewarm(int32 NumPrewarm, SIZE_T InBufferSize)
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		BufferSize = InBufferSize;
+
+		int32 NumReady = 0;
+
+		for (FVlcMediaTextureSample* Sample : Available)
+		{
+			if (Sample->GetBufferSize() == InBufferSize)
+			{
+				++NumReady;
+			}
+			else if (NumReady < NumPrewarm)
+			{
+				ResizeBuffer(*Sample, InBufferSize);
+				++NumReady;
+			}
+			else
+			{
+				ResizeBuffer(*Sample, 0);
+			}
+		}
+
+		while (NumReady < NumPrewarm)
+		{
+			FVlcMediaTextureSample* Sample = new FVlcMediaTextureSample;
+			ResizeBuffer(*Sample, InBufferSize);
+
+			Available.Add(Sample);
+
+			++NumReady;
+			++NumSamples;
+		}
+	}
+
+	/** Return a sample to the pool. */
+	void Release(FVlcMediaTextureSample* Sample)
+	{
+		Sample->ShutdownPoolable();
+
+		FScopeLock Lock(&CriticalSection);
+
+		// buffers of previous frame formats are not kept around
+		if (Sample->GetBufferSize() != BufferSize)
+		{
+			ResizeBuffer(*Sample, 0);
+		}
+
+		Available.Add(Sample);
+	}
+
+	/** Delete all available samples. */
+	void Reset()
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		for (FVlcMediaTextureSample* Sample : Available)
+		{
+			AllocatedBytes -= Sample->GetBufferSize();
+			delete Sample;
+		}
+
+		NumSamples -= Available.Num();
+		Available.Empty();
+	}
+
+public:
+
+	/** Total size of the buffers owned by samples of this pool (in bytes). */
+	SIZE_T AllocatedBytes;
+
+	/** Buffer size of the current frame format (in bytes). */
+	SIZE_T BufferSize;
+
+	/** Critical section for synchronizing access to this storage. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Largest value of AllocatedBytes so far. */
+	SIZE_T HighWaterBytes;
+
+	/** Number of samples created by this pool that have not been deleted. */
+	int32 NumSamples;
+
+private:
+
+	/** Resize a sample's buffer and update the allocation statistics (must be called under lock). */
+	void ResizeBuffer(FVlcMediaTextureSample& Sample, SIZE_T NewSize)
+	{
+		AllocatedBytes -= Sample.GetBufferSize();
+		Sample.ResizeBuffer(NewSize);
+		AllocatedBytes += NewSize;
+
+		HighWaterBytes = FMath::Max(HighWaterBytes, AllocatedBytes);
+	}
+
+	/** Samples that are currently not in use. */
+	TArray<FVlcMediaTextureSample*> Available;
+};
+
+
+/* FVlcMediaTextureSamplePool structors
+ *****************************************************************************/
+
+FVlcMediaTextureSamplePool::FVlcMediaTextureSamplePool()
+	: Storage(MakeShareable(new FStorage))
+{ }
+
+
+FVlcMediaTextureSamplePool::~FVlcMediaTextureSamplePool()
+{
+	Storage->Reset();
+}
+
+
+/* FVlcMediaTextureSamplePool interface
+ *****************************************************************************/
+
+FVlcMediaTextureSample* FVlcMediaTextureSamplePool::Acquire(SIZE_T BufferSize)
+{
+	return Storage->Acquire(BufferSize);
+}
+
+
+SIZE_T FVlcMediaTextureSamplePool::GetAllocatedBytes() const
+{
+	FScopeLock Lock(&Storage->CriticalSection);
+	return Storage->AllocatedBytes;
+}
+
+
+SIZE_T FVlcMediaTextureSamplePool::GetHighWaterBytes() const
+{
+	FScopeLock Lock(&Storage->CriticalSection);
+	return Storage->HighWaterBytes;
+}
+
+
+int32 FVlcMediaTextureSamplePool::GetNumSamples() const
+{
+	FScopeLock Lock(&Storage->CriticalSection);
+	return Storage->NumSamples;
+}
+
+
+void FVlcMediaTextureSamplePool::Prewarm(int32 NumSamples, SIZE_T BufferSize)
+{
+	Storage->Prewarm(NumSamples, BufferSize);
+}
+
+
+void FVlcMediaTextureSamplePool::Release(FVlcMediaTextureSample* Sample)
+{
+	if (Sample != nullptr)
+	{
+		Storage->Release(Sample);
+	}
+}
+
+
+void FVlcMediaTextureSamplePool::Reset()
+{
+	Storage->Reset();
+}
+
+
+TSharedRef<FVlcMediaTextureSample, ESPMode::ThreadSafe> FVlcMediaTextureSamplePool::ToShared(FVlcMediaTextureSample* Sample)
+{
+	check(Sample != nullptr);
+
+	TSharedRef<FStorage, ESPMode::ThreadSafe> StorageRef = Storage;
+
+	return MakeShareable(Sample, [StorageRef](FVlcMediaTextureSample* ObjectToDelete) {
+		StorageRef->Release(ObjectToDelete);
+	});
+}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreTypes.h"
+#include "HAL/ThreadSafeCounter64.h"
 #include "IMediaTextureSample.h"
 #include "MediaObjectPool.h"
 #include "Math/IntPoint.h"
@@ -10,6 +11,101 @@
 #include "Templates/SharedPointer.h"
 
 
+/**
+ * Describes the memory layout of the planes in a video frame buffer.
+ *
+ * All planes are stored back to back in a single buffer, so that semi-planar
+ * formats, such as NV12, can be handed to the engine without repacking.
+ */
+struct FVlcMediaPlaneLayout
+{
+	/** Maximum number of planes (must match FVlc::MaxPlanes). */
+	static const uint32 MaxPlanes = 5;
+
+	/** Number of rows in each plane. */
+	uint32 Lines[MaxPlanes];
+
+	/** Number of planes in use. */
+	uint32 NumPlanes;
+
+	/** Number of bytes per row in each plane. */
+	uint32 Pitches[MaxPlanes];
+
+public:
+
+	/** Default constructor. */
+	FVlcMediaPlaneLayout()
+		: NumPlanes(0)
+	{
+		FMemory::Memzero(Lines, sizeof(Lines));
+		FMemory::Memzero(Pitches, sizeof(Pitches));
+	}
+
+public:
+
+	/**
+	 * Add a plane to the layout.
+	 *
+	 * @param Pitch Number of bytes per row.
+	 * @param NumLines Number of rows.
+	 */
+	void AddPlane(uint32 Pitch, uint32 NumLines)
+	{
+		check(NumPlanes < MaxPlanes);
+
+		Lines[NumPlanes] = NumLines;
+		Pitches[NumPlanes] = Pitch;
+
+		++NumPlanes;
+	}
+
+	/**
+	 * Get the total size of all planes.
+	 *
+	 * @return Buffer size (in bytes).
+	 */
+	SIZE_T GetBufferSize() const
+	{
+		SIZE_T BufferSize = 0;
+
+		for (uint32 PlaneIndex = 0; PlaneIndex < NumPlanes; ++PlaneIndex)
+		{
+			BufferSize += (SIZE_T)Pitches[PlaneIndex] * Lines[PlaneIndex];
+		}
+
+		return BufferSize;
+	}
+
+	/**
+	 * Get pointers to the individual planes in the given buffer.
+	 *
+	 * @param Buffer The frame buffer.
+	 * @param OutPlanes Will contain the plane pointers (must hold MaxPlanes entries).
+	 */
+	void GetPlanes(void* Buffer, void** OutPlanes) const
+	{
+		if (Buffer == nullptr)
+		{
+			return;
+		}
+
+		uint8* Plane = (uint8*)Buffer;
+
+		for (uint32 PlaneIndex = 0; PlaneIndex < NumPlanes; ++PlaneIndex)
+		{
+			OutPlanes[PlaneIndex] = Plane;
+			Plane += (SIZE_T)Pitches[PlaneIndex] * Lines[PlaneIndex];
+		}
+	}
+
+	/** Reset the layout. */
+	void Reset()
+	{
+		*this = FVlcMediaPlaneLayout();
+	}
+};
+
+
 /**
  * Texture sample generated by VlcMedia player.
  */
@@ -25,8 +121,11 @@ public:
 		, BufferSize(0)
 		, Dim(FIntPoint::ZeroValue)
 		, Duration(FTimespan::Zero())
+		, Hash(0)
 		, OutputDim(FIntPoint::ZeroValue)
 		, SampleFormat(EMediaTextureSampleFormat::Undefined)
+		, StagingBuffer(nullptr)
+		, StagingBufferSize(0)
 		, Stride(0)
 		, Time(FTimespan::Zero())
 	{ }
@@ -35,10 +134,46 @@ public:
 	virtual ~FVlcMediaTextureSample()
 	{
 		FreeBuffer();
+		ResizeStagingBuffer(0);
 	}
 
 public:
 
+	/**
+	 * Extend the sample's duration so that it ends at the specified time.
+	 *
+	 * This is used instead of outputting frames that are identical to this
+	 * one, and may be called while the sample is queued or in use.
+	 *
+	 * @param EndTime The new end time (in the player's clock).
+	 */
+	void ExtendDuration(FTimespan EndTime)
+	{
+		ExtraDuration.Set(FMath::Max<int64>(0, (EndTime - Time - Duration).GetTicks()));
+	}
+
+	/**
+	 * Get the hash of the sample's frame.
+	 *
+	 * @return The hash value (only valid if identical frames are skipped).
+	 * @see SetHash
+	 */
+	uint64 GetHash() const
+	{
+		return Hash;
+	}
+
+	/**
+	 * Get the allocated size of the sample buffer.
+	 *
+	 * @return Buffer size (in bytes).
+	 * @see ResizeBuffer
+	 */
+	SIZE_T GetBufferSize() const
+	{
+		return BufferSize;
+	}
+
 	/**
 	 * Get a writable pointer to the sample buffer.
 	 *
@@ -50,6 +185,28 @@ public:
 		return Buffer;
 	}
 
+	/**
+	 * Get writable pointers to the individual planes in the sample buffer.
+	 *
+	 * @param OutPlanes Will contain the plane pointers (must hold FVlcMediaPlaneLayout::MaxPlanes entries).
+	 * @see GetMutableBuffer, Initialize
+	 */
+	void GetMutablePlanes(void** OutPlanes) const
+	{
+		Layout.GetPlanes(Buffer, OutPlanes);
+	}
+
+	/**
+	 * Get the buffer that the decoder writes into before the frame is converted.
+	 *
+	 * @return The staging buffer, or nullptr if none is allocated.
+	 * @see ResizeStagingBuffer
+	 */
+	void* GetMutableStagingBuffer()
+	{
+		return StagingBuffer;
+	}
+
 	/**
 	 * Initialize the sample.
 	 *
@@ -57,6 +214,7 @@ public:
 	 * @param InOutputDim The sample's output width and height (in pixels).
 	 * @param InSampleFormat The sample format.
 	 * @param InStride Number of bytes per pixel row.
+	 * @param InLayout The layout of the planes in the sample buffer.
 	 * @param InDuration The duration for which the sample is valid.
 	 * @return true on success, false otherwise.
 	 */
@@ -65,6 +223,7 @@ public:
 		const FIntPoint& InOutputDim,
 		EMediaTextureSampleFormat InSampleFormat,
 		uint32 InStride,
+		const FVlcMediaPlaneLayout& InLayout,
 		FTimespan InDuration)
 	{
 		if (InSampleFormat == EMediaTextureSampleFormat::Undefined)
@@ -72,21 +231,19 @@ public:
 			return false;
 		}
 
-		const SIZE_T RequiredBufferSize = InStride * InDim.Y;
+		const SIZE_T RequiredBufferSize = InLayout.GetBufferSize();
 
 		if (RequiredBufferSize == 0)
 		{
 			return false;
 		}
 
-		if (RequiredBufferSize > BufferSize)
-		{
-			Buffer = FMemory::Realloc(Buffer, RequiredBufferSize, 32);
-			BufferSize = RequiredBufferSize;
-		}
+		ResizeBuffer(RequiredBufferSize);
 
 		Dim = InDim;
 		Duration = InDuration;
+		ExtraDuration.Reset();
+		Layout = InLayout;
 		OutputDim = InOutputDim;
 		SampleFormat = InSampleFormat;
 		Stride = InStride;
@@ -94,6 +251,87 @@ public:
 		return true;
 	}
 
+	/**
+	 * Reallocate the sample buffer to exactly the specified size.
+	 *
+	 * The buffer's contents are not preserved.
+	 *
+	 * @param NewSize The new buffer size (in bytes), or 0 to free the buffer.
+	 * @see GetBufferSize
+	 */
+	void ResizeBuffer(SIZE_T NewSize)
+	{
+		if (NewSize == BufferSize)
+		{
+			return;
+		}
+
+		FreeBuffer();
+
+		if (NewSize > 0)
+		{
+			Buffer = FMemory::Malloc(NewSize, 32);
+			BufferSize = NewSize;
+		}
+	}
+
+	/**
+	 * Reallocate the staging buffer to exactly the specified size.
+	 *
+	 * Each sample has its own staging buffer, because VLC may hold several
+	 * locked pictures at the same time, i.e. while reordering B-frames.
+	 * The buffer is kept while the sample is pooled, so that it is only
+	 * reallocated when the frame format changes.
+	 *
+	 * @param NewSize The new buffer size (in bytes), or 0 to free the buffer.
+	 * @see GetMutableStagingBuffer
+	 */
+	void ResizeStagingBuffer(SIZE_T NewSize)
+	{
+		if (NewSize == StagingBufferSize)
+		{
+			return;
+		}
+
+		if (StagingBuffer != nullptr)
+		{
+			FMemory::Free(StagingBuffer);
+			StagingBuffer = nullptr;
+		}
+
+		if (NewSize > 0)
+		{
+			StagingBuffer = FMemory::Malloc(NewSize, 32);
+		}
+
+		StagingBufferSize = NewSize;
+	}
+
+	/**
+	 * Set the hash of the sample's frame, so that identical frames can be detected when it is displayed.
+	 *
+	 * Each sample carries its own hash, because VLC may decode several
+	 * pictures before it displays the first one.
+	 *
+	 * @param InHash The hash value.
+	 * @see GetHash
+	 */
+	void SetHash(uint64 InHash)
+	{
+		Hash = InHash;
+	}
+
+	/**
+	 * Set the size of the video queue reservation that was made for this sample's frame.
+	 *
+	 * @param Size The reserved size (in bytes).
+	 * @see TakeReservation
+	 */
+	void SetReservation(SIZE_T Size)
+	{
+		ReservedBytes.Set((int64)Size);
+	}
+
 	/**
 	 * Set the time for which the sample was generated.
 	 *
@@ -104,6 +342,20 @@ public:
 		Time = InTime;
 	}
 
+	/**
+	 * Take the video queue reservation that was made for this sample's frame.
+	 *
+	 * The reservation is returned only once, so that whichever VLC callback
+	 * sees the frame first can release it.
+	 *
+	 * @return The reserved size (in bytes; 0 = none, or taken already).
+	 * @see SetReservation
+	 */
+	SIZE_T TakeReservation()
+	{
+		return (SIZE_T)ReservedBytes.Set(0);
+	}
+
 public:
 
 	//~ IMediaTextureSample interface
@@ -120,7 +372,7 @@ public:
 
 	virtual FTimespan GetDuration() const override
 	{
-		return Duration;
+		return Duration + FTimespan(ExtraDuration.GetValue());
 	}
 
 	virtual EMediaTextureSampleFormat GetFormat() const override
@@ -188,12 +440,30 @@ private:
 	/** Duration for which the sample is valid. */
 	FTimespan Duration;
 
+	/** Time (in ticks) by which the duration was extended because following frames were identical. */
+	FThreadSafeCounter64 ExtraDuration;
+
+	/** Hash of the frame (set by the VLC unlock callback). */
+	uint64 Hash;
+
+	/** Layout of the planes in the frame buffer. */
+	FVlcMediaPlaneLayout Layout;
+
 	/** Width and height of the output. */
 	FIntPoint OutputDim;
 
+	/** Size of the video queue reservation of this sample's frame (in bytes; 0 = none). */
+	FThreadSafeCounter64 ReservedBytes;
+
 	/** The sample format. */
 	EMediaTextureSampleFormat SampleFormat;
 
+	/** Buffer that the decoder writes into if frames are converted by the plug-in. */
+	void* StagingBuffer;
+
+	/** Allocated size of the staging buffer (in bytes). */
+	SIZE_T StagingBufferSize;
+
 	/** Number of bytes per pixel row. */
 	uint32 Stride;
 
@@ -202,5 +472,92 @@ private:
 };
 
 
-/** Implements a pool for VLC texture sample objects. */
-class FVlcMediaTextureSamplePool : public TMediaObjectPool<FVlcMediaTextureSample> { };
+/**
+ * Implements a pool for VLC texture sample objects.
+ *
+ * Samples are handed out by buffer size. Buffers that do not match the
+ * current frame size are freed when their samples return to the pool,
+ * so that memory use follows resolution changes instead of staying at
+ * the largest frame size ever decoded.
+ */
+class FVlcMediaTextureSamplePool
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaTextureSamplePool();
+
+	/** Destructor. */
+	~FVlcMediaTextureSamplePool();
+
+public:
+
+	/**
+	 * Acquire a sample with a buffer of the specified size.
+	 *
+	 * @param BufferSize The required buffer size (in bytes).
+	 * @return The sample.
+	 * @see Release, ToShared
+	 */
+	FVlcMediaTextureSample* Acquire(SIZE_T BufferSize);
+
+	/**
+	 * Get the total size of the buffers owned by pooled samples, including samples in use.
+	 *
+	 * @return Allocated size (in bytes).
+	 * @see GetHighWaterBytes
+	 */
+	SIZE_T GetAllocatedBytes() const;
+
+	/**
+	 * Get the largest total size of buffers that were allocated at the same time.
+	 *
+	 * @return High-water mark (in bytes).
+	 * @see GetAllocatedBytes
+	 */
+	SIZE_T GetHighWaterBytes() const;
+
+	/**
+	 * Get the number of samples created by this pool.
+	 *
+	 * @return Number of samples, including samples in use.
+	 */
+	int32 GetNumSamples() const;
+
+	/**
+	 * Set the current buffer size and make sure that enough samples are available.
+	 *
+	 * Available samples with buffers of other sizes are trimmed.
+	 *
+	 * @param NumSamples The number of samples to have available.
+	 * @param BufferSize The buffer size of the new frame format (in bytes).
+	 */
+	void Prewarm(int32 NumSamples, SIZE_T BufferSize);
+
+	/**
+	 * Return a sample that was not converted to a shared reference.
+	 *
+	 * @param Sample The sample to return.
+	 * @see Acquire
+	 */
+	void Release(FVlcMediaTextureSample* Sample);
+
+	/** Free all available samples. Samples in use are returned to the pool later. */
+	void Reset();
+
+	/**
+	 * Convert an acquired sample into a shared reference that returns it to the pool.
+	 *
+	 * @param Sample The sample to convert.
+	 * @return The shared reference.
+	 * @see Acquire
+	 */
+	TSharedRef<FVlcMediaTextureSample, ESPMode::ThreadSafe> ToShared(FVlcMediaTextureSample* Sample);
+
+private:
+
+	class FStorage;
+
+	/** The pool's storage (shared with outstanding samples, which may outlive the pool). */
+	TSharedRef<FStorage, ESPMode::ThreadSafe> Storage;
+};
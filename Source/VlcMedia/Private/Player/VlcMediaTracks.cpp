@@ -1,19 +1,57 @@
 // Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
 
 #include "VlcMediaTracks.h"
-#include "Vlc.h"
+#include "VlcMediaPrivate.h"
 
 #include "MediaHelpers.h"
 
+#include "Vlc.h"
+#include "VlcMediaCallbacks.h"
+
 
 #define LOCTEXT_NAMESPACE "FVlcMediaTracks"
 
 
+namespace VlcMediaTracks
+{
+	/** Find the media track with the specified identifier. */
+	const FLibvlcMediaTrack* FindMediaTrack(FLibvlcMediaTrack** MediaTracks, uint32 NumMediaTracks, ELibvlcTrackType Type, int32 Id)
+	{
+		for (uint32 MediaTrackIndex = 0; MediaTrackIndex < NumMediaTracks; ++MediaTrackIndex)
+		{
+			const FLibvlcMediaTrack* MediaTrack = MediaTracks[MediaTrackIndex];
+
+			if ((MediaTrack != nullptr) && (MediaTrack->Type == Type) && (MediaTrack->Id == Id))
+			{
+				return MediaTrack;
+			}
+		}
+
+		return nullptr;
+	}
+
+	/** Convert a FourCC code to a string. */
+	FString FourccToString(uint32 Fourcc)
+	{
+		ANSICHAR Chars[5] = { 0 };
+
+		for (int32 CharIndex = 0; CharIndex < 4; ++CharIndex)
+		{
+			const ANSICHAR Char = (ANSICHAR)((Fourcc >> (CharIndex * 8)) & 0xff);
+			Chars[CharIndex] = FChar::IsPrint(Char) ? Char : ' ';
+		}
+
+		return FString(ANSI_TO_TCHAR(Chars)).TrimEnd();
+	}
+}
+
+
 /* FVlcMediaTracks structors
 *****************************************************************************/
 
 FVlcMediaTracks::FVlcMediaTracks()
-	: Player(nullptr)
+	: AudioOutputSampleRate(0)
+	, Player(nullptr)
 { }
 
 
@@ -28,13 +66,20 @@ void FVlcMediaTracks::Initialize(FLibvlcMediaPlayer& InPlayer, FString& OutInfo)
 
 	Player = &InPlayer;
 
-	int32 Width = FVlc::VideoGetWidth(Player);
-	int32 Height = FVlc::VideoGetHeight(Player);
 	int32 StreamCount = 0;
 
-	// @todo gmp: fix audio specs
-	FVlc::AudioSetFormat(Player, "S16N", 44100, 2);
-	FVlc::VideoSetFormat(Player, "RV32", Width, Height, Width * 4);
+	// audio & video formats are negotiated in the format callbacks, if any
+	AudioOutputSampleRate = (uint32)FMath::Max(0, GetDefault<UVlcMediaSettings>()->AudioOutputSampleRate);
+
+	// get elementary stream formats
+	FLibvlcMedia* Media = FVlc::MediaPlayerGetMedia(Player);
+	FLibvlcMediaTrack** MediaTracks = nullptr;
+	uint32 NumMediaTracks = 0;
+
+	if (Media != nullptr)
+	{
+		NumMediaTracks = FVlc::MediaTracksGet(Media, &MediaTracks);
+	}
 
 	// initialize audio tracks
 	FLibvlcTrackDescription* AudioTrackDescr = FVlc::AudioGetTrackDescription(Player);
@@ -50,6 +95,15 @@ void FVlcMediaTracks::Initialize(FLibvlcMediaPlayer& InPlayer, FString& OutInfo)
 					Track.DisplayName = Track.Name.IsEmpty()
 						? FText::Format(LOCTEXT("AudioTrackFormat", "Audio Track {0}"), FText::AsNumber(AudioTracks.Num()))
 						: FText::FromString(Track.Name);
+
+					const FLibvlcMediaTrack* MediaTrack = VlcMediaTracks::FindMediaTrack(MediaTracks, NumMediaTracks, ELibvlcTrackType::Audio, Track.Id);
+
+					if ((MediaTrack != nullptr) && (MediaTrack->Audio != nullptr))
+					{
+						Track.Codec = MediaTrack->Codec;
+						Track.NumChannels = MediaTrack->Audio->Channels;
+						Track.SampleRate = MediaTrack->Audio->Rate;
+					}
 				}
 
 				AudioTracks.Add(Track);
@@ -57,6 +111,9 @@ void FVlcMediaTracks::Initialize(FLibvlcMediaPlayer& InPlayer, FString& OutInfo)
 				OutInfo += FString::Printf(TEXT("Stream %i\n"), StreamCount);
 				OutInfo += TEXT("    Type: Audio\n");
 				OutInfo += FString::Printf(TEXT("    Name: %s\n"), *Track.Name);
+				OutInfo += FString::Printf(TEXT("    Codec: %s\n"), *VlcMediaTracks::FourccToString(Track.Codec));
+				OutInfo += FString::Printf(TEXT("    Channels: %i\n"), Track.NumChannels);
+				OutInfo += FString::Printf(TEXT("    Sample Rate: %i Hz\n"), Track.SampleRate);
 				OutInfo += TEXT("\n");
 
 				++StreamCount;
@@ -129,6 +186,16 @@ void FVlcMediaTracks::Initialize(FLibvlcMediaPlayer& InPlayer, FString& OutInfo)
 	}
 	FVlc::TrackDescriptionListRelease(VideoTrackDescr);
 
+	if (Media != nullptr)
+	{
+		if (MediaTracks != nullptr)
+		{
+			FVlc::MediaTracksRelease(MediaTracks, NumMediaTracks);
+		}
+
+		FVlc::MediaRelease(Media);
+	}
+
 	UE_LOG(LogVlcMedia, Verbose, TEXT("Tracks %p: Found %i streams"), this, StreamCount);
 }
 
@@ -156,10 +223,13 @@ bool FVlcMediaTracks::GetAudioTrackFormat(int32 TrackIndex, int32 FormatIndex, F
 		return false;
 	}
 
-	// @todo gmp: fix audio format
-	OutFormat.BitsPerSample = 0;
-	OutFormat.NumChannels = 2;
-	OutFormat.SampleRate = 44100;
+	const FTrack& Track = AudioTracks[TrackIndex];
+
+	// samples are decoded to 32-bit float PCM in the track's channel layout;
+	// the source codec is reported in the media info string
+	OutFormat.BitsPerSample = 32;
+	OutFormat.NumChannels = FMath::Min(Track.NumChannels, (uint32)FVlcMediaCallbacks::MaxAudioChannels);
+	OutFormat.SampleRate = (AudioOutputSampleRate > 0) ? AudioOutputSampleRate : Track.SampleRate;
 	OutFormat.TypeName = TEXT("PCM");
 
 	return true;
@@ -18,9 +18,19 @@ class FVlcMediaTracks
 {
 	struct FTrack
 	{
+		uint32 Codec;
 		FText DisplayName;
 		int32 Id;
 		FString Name;
+		uint32 NumChannels;
+		uint32 SampleRate;
+
+		FTrack()
+			: Codec(0)
+			, Id(INDEX_NONE)
+			, NumChannels(0)
+			, SampleRate(0)
+		{ }
 	}; 
 
 public:
@@ -62,6 +72,9 @@ private:
 	/** Audio track descriptors. */
 	TArray<FTrack> AudioTracks;
 
+	/** Sample rate at which audio is decoded (in Hz; 0 = source sample rate). */
+	uint32 AudioOutputSampleRate;
+
 	/** Caption track descriptors. */
 	TArray<FTrack> CaptionTracks;
 
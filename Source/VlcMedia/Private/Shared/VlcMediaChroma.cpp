@@ -0,0 +1,820 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaChroma.h"
+#include "VlcMediaPrivate.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+#if VLCMEDIA_SIMD_X86
+	#include <emmintrin.h>
+	#include <immintrin.h>
+#endif
+
+#if VLCMEDIA_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+
+namespace VlcMediaChroma
+{
+	/** Number of rows per band when converting in parallel (must be even). */
+	const int32 RowsPerBand = 64;
+
+	/**
+	 * Coefficients for limited range 8-bit YUV to RGB conversion in 6-bit fixed point.
+	 *
+	 * R = (Y' + Rv * V' + 32) >> 6
+	 * G = (Y' - (Gu * U' + Gv * V') + 32) >> 6
+	 * B = (Y' + Bu * U' + 32) >> 6
+	 *
+	 * where Y' = (Y - 16) * Y, U' = U - 128, V' = V - 128
+	 */
+	struct FYuvCoefficients
+	{
+		int16 Y;
+		int16 Rv;
+		int16 Gu;
+		int16 Gv;
+		int16 Bu;
+	};
+
+	/** ITU-R BT.601 (standard definition). */
+	const FYuvCoefficients Bt601 = { 75, 102, 25, 52, 129 };
+
+	/** ITU-R BT.709 (high definition). */
+	const FYuvCoefficients Bt709 = { 75, 115, 14, 34, 135 };
+
+	/** ITU-R BT.2020 coefficients for normalized 10-bit samples (P010 is used almost exclusively for UHD content). */
+	const float P010YScale = 1.0f / 876.0f;
+	const float P010CScale = 1.0f / 896.0f;
+	const float P010Rv = 1.4746f;
+	const float P010Gu = 0.16455f;
+	const float P010Gv = 0.57135f;
+	const float P010Bu = 1.8814f;
+
+	/** The half precision floating point value 1.0 (used for the alpha channel). */
+	const uint16 HalfOne = 0x3c00;
+
+	/** Converts a row of 8-bit 4:2:0 pixels (U and V point to the same row if chroma is interleaved). */
+	typedef void (*FConvertRow8Func)(const uint8* Y, const uint8* U, const uint8* V, uint8* Dest, int32 Width, const FYuvCoefficients& C);
+
+	/** Converts a row of 10-bit semi-planar 4:2:0 pixels. */
+	typedef void (*FConvertRow16Func)(const uint16* Y, const uint16* UV, uint16* Dest, int32 Width);
+
+
+	/* Scalar kernels
+	 *****************************************************************************/
+
+	FORCEINLINE uint8 ScalarClamp(int32 Value)
+	{
+		return (uint8)FMath::Clamp((Value + 32) >> 6, 0, 255);
+	}
+
+	FORCEINLINE void ScalarPixel8(int32 Y, int32 U, int32 V, uint8* Dest, const FYuvCoefficients& C)
+	{
+		const int32 Luma = (Y - 16) * C.Y;
+		const int32 Cu = U - 128;
+		const int32 Cv = V - 128;
+
+		Dest[0] = ScalarClamp(Luma + C.Bu * Cu);
+		Dest[1] = ScalarClamp(Luma - (C.Gu * Cu + C.Gv * Cv));
+		Dest[2] = ScalarClamp(Luma + C.Rv * Cv);
+		Dest[3] = 0xff;
+	}
+
+	/** Convert a float in [0, 1] to half precision (denormals are flushed to zero, rounds to nearest even). */
+	FORCEINLINE uint16 ScalarToHalf(float Value)
+	{
+		uint32 Bits;
+		FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+
+		if (Bits < 0x38800000)
+		{
+			return 0;
+		}
+
+		return (uint16)((Bits - 0x38000000 + 0x0fff + ((Bits >> 13) & 1)) >> 13);
+	}
+
+	FORCEINLINE void ScalarPixel16(uint16 Y, uint16 U, uint16 V, uint16* Dest)
+	{
+		const float Luma = (float)((int32)(Y >> 6) - 64) * P010YScale;
+		const float Cb = (float)((int32)(U >> 6) - 512) * P010CScale;
+		const float Cr = (float)((int32)(V >> 6) - 512) * P010CScale;
+
+		Dest[0] = ScalarToHalf(FMath::Clamp(Luma + Cr * P010Rv, 0.0f, 1.0f));
+		Dest[1] = ScalarToHalf(FMath::Clamp(Luma - (Cb * P010Gu + Cr * P010Gv), 0.0f, 1.0f));
+		Dest[2] = ScalarToHalf(FMath::Clamp(Luma + Cb * P010Bu, 0.0f, 1.0f));
+		Dest[3] = HalfOne;
+	}
+
+	template<bool Interleaved>
+	FORCEINLINE void ScalarRow8(const uint8* Y, const uint8* U, const uint8* V, uint8* Dest, int32 Begin, int32 End, const FYuvCoefficients& C)
+	{
+		for (int32 X = Begin; X < End; ++X)
+		{
+			if (Interleaved)
+			{
+				ScalarPixel8(Y[X], U[X & ~1], U[X | 1], Dest + X * 4, C);
+			}
+			else
+			{
+				ScalarPixel8(Y[X], U[X / 2], V[X / 2], Dest + X * 4, C);
+			}
+		}
+	}
+
+	FORCEINLINE void ScalarRow16(const uint16* Y, const uint16* UV, uint16* Dest, int32 Begin, int32 End)
+	{
+		for (int32 X = Begin; X < End; ++X)
+		{
+			ScalarPixel16(Y[X], UV[X & ~1], UV[X | 1], Dest + X * 4);
+		}
+	}
+
+	template<bool Interleaved>
+	void ConvertRow8Scalar(const uint8* Y, const uint8* U, const uint8* V, uint8* Dest, int32 Width, const FYuvCoefficients& C)
+	{
+		ScalarRow8<Interleaved>(Y, U, V, Dest, 0, Width, C);
+	}
+
+	void ConvertRow16Scalar(const uint16* Y, const uint16* UV, uint16* Dest, int32 Width)
+	{
+		ScalarRow16(Y, UV, Dest, 0, Width);
+	}
+
+
+#if VLCMEDIA_SIMD_X86
+
+	/* SSE2 kernels
+	 *****************************************************************************/
+
+	/** Add the chroma contribution to 16 luma values and pack the result to bytes. */
+	FORCEINLINE __m128i Sse2AddChroma(__m128i LumaLo, __m128i LumaHi, __m128i Chroma)
+	{
+		const __m128i Lo = _mm_srai_epi16(_mm_adds_epi16(LumaLo, _mm_unpacklo_epi16(Chroma, Chroma)), 6);
+		const __m128i Hi = _mm_srai_epi16(_mm_adds_epi16(LumaHi, _mm_unpackhi_epi16(Chroma, Chroma)), 6);
+
+		return _mm_packus_epi16(Lo, Hi);
+	}
+
+	/** Interleave and store 16 BGRA pixels. */
+	FORCEINLINE void Sse2StoreBgra(uint8* Dest, __m128i B, __m128i G, __m128i R, __m128i A)
+	{
+		const __m128i BgLo = _mm_unpacklo_epi8(B, G);
+		const __m128i BgHi = _mm_unpackhi_epi8(B, G);
+		const __m128i RaLo = _mm_unpacklo_epi8(R, A);
+		const __m128i RaHi = _mm_unpackhi_epi8(R, A);
+
+		_mm_storeu_si128((__m128i*)(Dest + 0), _mm_unpacklo_epi16(BgLo, RaLo));
+		_mm_storeu_si128((__m128i*)(Dest + 16), _mm_unpackhi_epi16(BgLo, RaLo));
+		_mm_storeu_si128((__m128i*)(Dest + 32), _mm_unpacklo_epi16(BgHi, RaHi));
+		_mm_storeu_si128((__m128i*)(Dest + 48), _mm_unpackhi_epi16(BgHi, RaHi));
+	}
+
+	template<bool Interleaved>
+	void ConvertRow8Sse2(const uint8* Y, const uint8* U, const uint8* V, uint8* Dest, int32 Width, const FYuvCoefficients& C)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i Alpha = _mm_set1_epi8((char)0xff);
+		const __m128i ByteMask = _mm_set1_epi16(0x00ff);
+		const __m128i ChromaOffset = _mm_set1_epi16(128);
+		const __m128i LumaOffset = _mm_set1_epi16(16);
+		const __m128i Round = _mm_set1_epi16(32);
+		const __m128i YScale = _mm_set1_epi16(C.Y);
+		const __m128i Rv = _mm_set1_epi16(C.Rv);
+		const __m128i Gu = _mm_set1_epi16(C.Gu);
+		const __m128i Gv = _mm_set1_epi16(C.Gv);
+		const __m128i Bu = _mm_set1_epi16(C.Bu);
+
+		int32 X = 0;
+
+		for (; X + 16 <= Width; X += 16)
+		{
+			const __m128i Y8 = _mm_loadu_si128((const __m128i*)(Y + X));
+			__m128i U16, V16;
+
+			if (Interleaved)
+			{
+				const __m128i UV = _mm_loadu_si128((const __m128i*)(U + X));
+				U16 = _mm_and_si128(UV, ByteMask);
+				V16 = _mm_srli_epi16(UV, 8);
+			}
+			else
+			{
+				U16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(U + X / 2)), Zero);
+				V16 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(V + X / 2)), Zero);
+			}
+
+			U16 = _mm_sub_epi16(U16, ChromaOffset);
+			V16 = _mm_sub_epi16(V16, ChromaOffset);
+
+			const __m128i RChroma = _mm_mullo_epi16(V16, Rv);
+			const __m128i GChroma = _mm_sub_epi16(Zero, _mm_add_epi16(_mm_mullo_epi16(U16, Gu), _mm_mullo_epi16(V16, Gv)));
+			const __m128i BChroma = _mm_mullo_epi16(U16, Bu);
+
+			const __m128i LumaLo = _mm_adds_epi16(_mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(Y8, Zero), LumaOffset), YScale), Round);
+			const __m128i LumaHi = _mm_adds_epi16(_mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(Y8, Zero), LumaOffset), YScale), Round);
+
+			Sse2StoreBgra(Dest + X * 4,
+				Sse2AddChroma(LumaLo, LumaHi, BChroma),
+				Sse2AddChroma(LumaLo, LumaHi, GChroma),
+				Sse2AddChroma(LumaLo, LumaHi, RChroma),
+				Alpha
+			);
+		}
+
+		ScalarRow8<Interleaved>(Y, U, V, Dest, X, Width, C);
+	}
+
+	/** Convert four floats in [0, 1] to half precision (same rounding as ScalarToHalf). */
+	FORCEINLINE __m128i Sse2ToHalf(__m128 Value)
+	{
+		const __m128i Bits = _mm_castps_si128(Value);
+		const __m128i Round = _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(Bits, 13), _mm_set1_epi32(1)), _mm_set1_epi32(0x0fff));
+		const __m128i Half = _mm_srli_epi32(_mm_add_epi32(_mm_sub_epi32(Bits, _mm_set1_epi32(0x38000000)), Round), 13);
+		const __m128i Tiny = _mm_cmplt_epi32(Bits, _mm_set1_epi32(0x38800000));
+
+		return _mm_andnot_si128(Tiny, Half);
+	}
+
+	FORCEINLINE __m128 Sse2Saturate(__m128 Value)
+	{
+		return _mm_min_ps(_mm_max_ps(Value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	}
+
+	/** Convert and store four RGBA half pixels. */
+	FORCEINLINE void Sse2StoreRgbaHalf(uint16* Dest, __m128 Luma, __m128 RChroma, __m128 GChroma, __m128 BChroma)
+	{
+		const __m128i R = Sse2ToHalf(Sse2Saturate(_mm_add_ps(Luma, RChroma)));
+		const __m128i G = Sse2ToHalf(Sse2Saturate(_mm_sub_ps(Luma, GChroma)));
+		const __m128i B = Sse2ToHalf(Sse2Saturate(_mm_add_ps(Luma, BChroma)));
+		const __m128i A = _mm_set1_epi32(HalfOne);
+
+		const __m128i Rg = _mm_or_si128(R, _mm_slli_epi32(G, 16));
+		const __m128i Ba = _mm_or_si128(B, _mm_slli_epi32(A, 16));
+
+		_mm_storeu_si128((__m128i*)(Dest + 0), _mm_unpacklo_epi32(Rg, Ba));
+		_mm_storeu_si128((__m128i*)(Dest + 8), _mm_unpackhi_epi32(Rg, Ba));
+	}
+
+	void ConvertRow16Sse2(const uint16* Y, const uint16* UV, uint16* Dest, int32 Width)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		const __m128i ChromaOffset = _mm_set1_epi32(512);
+		const __m128i LumaOffset = _mm_set1_epi32(64);
+		const __m128 YScale = _mm_set1_ps(P010YScale);
+		const __m128 CScale = _mm_set1_ps(P010CScale);
+		const __m128 Rv = _mm_set1_ps(P010Rv);
+		const __m128 Gu = _mm_set1_ps(P010Gu);
+		const __m128 Gv = _mm_set1_ps(P010Gv);
+		const __m128 Bu = _mm_set1_ps(P010Bu);
+
+		int32 X = 0;
+
+		for (; X + 8 <= Width; X += 8)
+		{
+			const __m128i Y16 = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)(Y + X)), 6);
+			const __m128i UV16 = _mm_loadu_si128((const __m128i*)(UV + X));
+
+			const __m128 Cb = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(_mm_slli_epi32(UV16, 16), 22), ChromaOffset)), CScale);
+			const __m128 Cr = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(UV16, 22), ChromaOffset)), CScale);
+
+			const __m128 RChroma = _mm_mul_ps(Cr, Rv);
+			const __m128 GChroma = _mm_add_ps(_mm_mul_ps(Cb, Gu), _mm_mul_ps(Cr, Gv));
+			const __m128 BChroma = _mm_mul_ps(Cb, Bu);
+
+			const __m128 LumaLo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpacklo_epi16(Y16, Zero), LumaOffset)), YScale);
+			const __m128 LumaHi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpackhi_epi16(Y16, Zero), LumaOffset)), YScale);
+
+			Sse2StoreRgbaHalf(Dest + X * 4, LumaLo, _mm_unpacklo_ps(RChroma, RChroma), _mm_unpacklo_ps(GChroma, GChroma), _mm_unpacklo_ps(BChroma, BChroma));
+			Sse2StoreRgbaHalf(Dest + X * 4 + 16, LumaHi, _mm_unpackhi_ps(RChroma, RChroma), _mm_unpackhi_ps(GChroma, GChroma), _mm_unpackhi_ps(BChroma, BChroma));
+		}
+
+		ScalarRow16(Y, UV, Dest, X, Width);
+	}
+
+
+	/* AVX2 kernels
+	 *****************************************************************************/
+
+	/** Add the chroma contribution to 32 luma values and pack the result to bytes (in pixel order). */
+	VLCMEDIA_TARGET_AVX2 FORCEINLINE __m256i Avx2AddChroma(__m256i LumaLo, __m256i LumaHi, __m256i Chroma)
+	{
+		// unpacking works within 128-bit lanes, so chroma and packed results need to be reordered
+		const __m256i Ordered = _mm256_permute4x64_epi64(Chroma, 0xd8);
+		const __m256i Lo = _mm256_srai_epi16(_mm256_adds_epi16(LumaLo, _mm256_unpacklo_epi16(Ordered, Ordered)), 6);
+		const __m256i Hi = _mm256_srai_epi16(_mm256_adds_epi16(LumaHi, _mm256_unpackhi_epi16(Ordered, Ordered)), 6);
+
+		return _mm256_permute4x64_epi64(_mm256_packus_epi16(Lo, Hi), 0xd8);
+	}
+
+	template<bool Interleaved>
+	VLCMEDIA_TARGET_AVX2 void ConvertRow8Avx2(const uint8* Y, const uint8* U, const uint8* V, uint8* Dest, int32 Width, const FYuvCoefficients& C)
+	{
+		const __m128i Alpha = _mm_set1_epi8((char)0xff);
+		const __m256i ByteMask = _mm256_set1_epi16(0x00ff);
+		const __m256i ChromaOffset = _mm256_set1_epi16(128);
+		const __m256i LumaOffset = _mm256_set1_epi16(16);
+		const __m256i Round = _mm256_set1_epi16(32);
+		const __m256i YScale = _mm256_set1_epi16(C.Y);
+		const __m256i Rv = _mm256_set1_epi16(C.Rv);
+		const __m256i Gu = _mm256_set1_epi16(C.Gu);
+		const __m256i Gv = _mm256_set1_epi16(C.Gv);
+		const __m256i Bu = _mm256_set1_epi16(C.Bu);
+
+		int32 X = 0;
+
+		for (; X + 32 <= Width; X += 32)
+		{
+			const __m256i YLo16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(Y + X)));
+			const __m256i YHi16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(Y + X + 16)));
+			__m256i U16, V16;
+
+			if (Interleaved)
+			{
+				const __m256i UV = _mm256_loadu_si256((const __m256i*)(U + X));
+				U16 = _mm256_and_si256(UV, ByteMask);
+				V16 = _mm256_srli_epi16(UV, 8);
+			}
+			else
+			{
+				U16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(U + X / 2)));
+				V16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(V + X / 2)));
+			}
+
+			U16 = _mm256_sub_epi16(U16, ChromaOffset);
+			V16 = _mm256_sub_epi16(V16, ChromaOffset);
+
+			const __m256i RChroma = _mm256_mullo_epi16(V16, Rv);
+			const __m256i GChroma = _mm256_sub_epi16(_mm256_setzero_si256(), _mm256_add_epi16(_mm256_mullo_epi16(U16, Gu), _mm256_mullo_epi16(V16, Gv)));
+			const __m256i BChroma = _mm256_mullo_epi16(U16, Bu);
+
+			const __m256i LumaLo = _mm256_adds_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(YLo16, LumaOffset), YScale), Round);
+			const __m256i LumaHi = _mm256_adds_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(YHi16, LumaOffset), YScale), Round);
+
+			const __m256i B = Avx2AddChroma(LumaLo, LumaHi, BChroma);
+			const __m256i G = Avx2AddChroma(LumaLo, LumaHi, GChroma);
+			const __m256i R = Avx2AddChroma(LumaLo, LumaHi, RChroma);
+
+			Sse2StoreBgra(Dest + X * 4, _mm256_castsi256_si128(B), _mm256_castsi256_si128(G), _mm256_castsi256_si128(R), Alpha);
+			Sse2StoreBgra(Dest + X * 4 + 64, _mm256_extracti128_si256(B, 1), _mm256_extracti128_si256(G, 1), _mm256_extracti128_si256(R, 1), Alpha);
+		}
+
+		ScalarRow8<Interleaved>(Y, U, V, Dest, X, Width, C);
+	}
+
+	VLCMEDIA_TARGET_AVX2 FORCEINLINE __m256i Avx2ToHalf(__m256 Value)
+	{
+		const __m256i Bits = _mm256_castps_si256(Value);
+		const __m256i Round = _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(Bits, 13), _mm256_set1_epi32(1)), _mm256_set1_epi32(0x0fff));
+		const __m256i Half = _mm256_srli_epi32(_mm256_add_epi32(_mm256_sub_epi32(Bits, _mm256_set1_epi32(0x38000000)), Round), 13);
+		const __m256i Tiny = _mm256_cmpgt_epi32(_mm256_set1_epi32(0x38800000), Bits);
+
+		return _mm256_andnot_si256(Tiny, Half);
+	}
+
+	VLCMEDIA_TARGET_AVX2 FORCEINLINE __m256 Avx2Saturate(__m256 Value)
+	{
+		return _mm256_min_ps(_mm256_max_ps(Value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+	}
+
+	/** Convert and store eight RGBA half pixels. */
+	VLCMEDIA_TARGET_AVX2 FORCEINLINE void Avx2StoreRgbaHalf(uint16* Dest, __m256 Luma, __m256 RChroma, __m256 GChroma, __m256 BChroma)
+	{
+		const __m256i R = Avx2ToHalf(Avx2Saturate(_mm256_add_ps(Luma, RChroma)));
+		const __m256i G = Avx2ToHalf(Avx2Saturate(_mm256_sub_ps(Luma, GChroma)));
+		const __m256i B = Avx2ToHalf(Avx2Saturate(_mm256_add_ps(Luma, BChroma)));
+		const __m256i A = _mm256_set1_epi32(HalfOne);
+
+		const __m256i Rg = _mm256_or_si256(R, _mm256_slli_epi32(G, 16));
+		const __m256i Ba = _mm256_or_si256(B, _mm256_slli_epi32(A, 16));
+		const __m256i Lo = _mm256_unpacklo_epi32(Rg, Ba);
+		const __m256i Hi = _mm256_unpackhi_epi32(Rg, Ba);
+
+		_mm256_storeu_si256((__m256i*)(Dest + 0), _mm256_permute2x128_si256(Lo, Hi, 0x20));
+		_mm256_storeu_si256((__m256i*)(Dest + 16), _mm256_permute2x128_si256(Lo, Hi, 0x31));
+	}
+
+	/** Duplicate each chroma value for two horizontally adjacent pixels (returns pixels 0-7 and 8-15). */
+	VLCMEDIA_TARGET_AVX2 FORCEINLINE void Avx2DuplicateChroma(__m256 Chroma, __m256& OutLo, __m256& OutHi)
+	{
+		const __m256 Lo = _mm256_unpacklo_ps(Chroma, Chroma);
+		const __m256 Hi = _mm256_unpackhi_ps(Chroma, Chroma);
+
+		OutLo = _mm256_permute2f128_ps(Lo, Hi, 0x20);
+		OutHi = _mm256_permute2f128_ps(Lo, Hi, 0x31);
+	}
+
+	VLCMEDIA_TARGET_AVX2 void ConvertRow16Avx2(const uint16* Y, const uint16* UV, uint16* Dest, int32 Width)
+	{
+		const __m256i ChromaOffset = _mm256_set1_epi32(512);
+		const __m256i LumaOffset = _mm256_set1_epi32(64);
+		const __m256 YScale = _mm256_set1_ps(P010YScale);
+		const __m256 CScale = _mm256_set1_ps(P010CScale);
+		const __m256 Rv = _mm256_set1_ps(P010Rv);
+		const __m256 Gu = _mm256_set1_ps(P010Gu);
+		const __m256 Gv = _mm256_set1_ps(P010Gv);
+		const __m256 Bu = _mm256_set1_ps(P010Bu);
+
+		int32 X = 0;
+
+		for (; X + 16 <= Width; X += 16)
+		{
+			const __m256i Y16 = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i*)(Y + X)), 6);
+			const __m256i UV16 = _mm256_loadu_si256((const __m256i*)(UV + X));
+
+			const __m256 Cb = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(_mm256_slli_epi32(UV16, 16), 22), ChromaOffset)), CScale);
+			const __m256 Cr = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(UV16, 22), ChromaOffset)), CScale);
+
+			__m256 RLo, RHi, GLo, GHi, BLo, BHi;
+			Avx2DuplicateChroma(_mm256_mul_ps(Cr, Rv), RLo, RHi);
+			Avx2DuplicateChroma(_mm256_add_ps(_mm256_mul_ps(Cb, Gu), _mm256_mul_ps(Cr, Gv)), GLo, GHi);
+			Avx2DuplicateChroma(_mm256_mul_ps(Cb, Bu), BLo, BHi);
+
+			const __m256 LumaLo = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(Y16)), LumaOffset)), YScale);
+			const __m256 LumaHi = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(Y16, 1)), LumaOffset)), YScale);
+
+			Avx2StoreRgbaHalf(Dest + X * 4, LumaLo, RLo, GLo, BLo);
+			Avx2StoreRgbaHalf(Dest + X * 4 + 32, LumaHi, RHi, GHi, BHi);
+		}
+
+		ScalarRow16(Y, UV, Dest, X, Width);
+	}
+
+#endif //VLCMEDIA_SIMD_X86
+
+
+#if VLCMEDIA_SIMD_NEON
+
+	/* NEON kernels
+	 *****************************************************************************/
+
+	/** Add the chroma contribution to 16 luma values and narrow the result to bytes. */
+	FORCEINLINE uint8x16_t NeonAddChroma(int16x8_t LumaLo, int16x8_t LumaHi, int16x8_t Chroma)
+	{
+		const int16x8x2_t Pairs = vzipq_s16(Chroma, Chroma);
+
+		return vcombine_u8(
+			vqrshrun_n_s16(vqaddq_s16(LumaLo, Pairs.val[0]), 6),
+			vqrshrun_n_s16(vqaddq_s16(LumaHi, Pairs.val[1]), 6)
+		);
+	}
+
+	template<bool Interleaved>
+	void ConvertRow8Neon(const uint8* Y, const uint8* U, const uint8* V, uint8* Dest, int32 Width, const FYuvCoefficients& C)
+	{
+		const int16x8_t ChromaOffset = vdupq_n_s16(128);
+		const int16x8_t LumaOffset = vdupq_n_s16(16);
+
+		int32 X = 0;
+
+		for (; X + 16 <= Width; X += 16)
+		{
+			const uint8x16_t Y8 = vld1q_u8(Y + X);
+			int16x8_t U16, V16;
+
+			if (Interleaved)
+			{
+				const uint8x8x2_t UV = vld2_u8(U + X);
+				U16 = vreinterpretq_s16_u16(vmovl_u8(UV.val[0]));
+				V16 = vreinterpretq_s16_u16(vmovl_u8(UV.val[1]));
+			}
+			else
+			{
+				U16 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(U + X / 2)));
+				V16 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(V + X / 2)));
+			}
+
+			U16 = vsubq_s16(U16, ChromaOffset);
+			V16 = vsubq_s16(V16, ChromaOffset);
+
+			const int16x8_t RChroma = vmulq_n_s16(V16, C.Rv);
+			const int16x8_t GChroma = vnegq_s16(vmlaq_n_s16(vmulq_n_s16(U16, C.Gu), V16, C.Gv));
+			const int16x8_t BChroma = vmulq_n_s16(U16, C.Bu);
+
+			const int16x8_t LumaLo = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(Y8))), LumaOffset), C.Y);
+			const int16x8_t LumaHi = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(Y8))), LumaOffset), C.Y);
+
+			uint8x16x4_t Bgra;
+			{
+				Bgra.val[0] = NeonAddChroma(LumaLo, LumaHi, BChroma);
+				Bgra.val[1] = NeonAddChroma(LumaLo, LumaHi, GChroma);
+				Bgra.val[2] = NeonAddChroma(LumaLo, LumaHi, RChroma);
+				Bgra.val[3] = vdupq_n_u8(0xff);
+			}
+
+			vst4q_u8(Dest + X * 4, Bgra);
+		}
+
+		ScalarRow8<Interleaved>(Y, U, V, Dest, X, Width, C);
+	}
+
+	FORCEINLINE uint16x4_t NeonToHalf(float32x4_t Value)
+	{
+		const uint32x4_t Bits = vreinterpretq_u32_f32(Value);
+		const uint32x4_t Round = vaddq_u32(vandq_u32(vshrq_n_u32(Bits, 13), vdupq_n_u32(1)), vdupq_n_u32(0x0fff));
+		const uint32x4_t Half = vshrq_n_u32(vaddq_u32(vsubq_u32(Bits, vdupq_n_u32(0x38000000)), Round), 13);
+		const uint32x4_t Tiny = vcltq_u32(Bits, vdupq_n_u32(0x38800000));
+
+		return vmovn_u32(vbicq_u32(Half, Tiny));
+	}
+
+	FORCEINLINE float32x4_t NeonSaturate(float32x4_t Value)
+	{
+		return vminq_f32(vmaxq_f32(Value, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+	}
+
+	/** Convert and store four RGBA half pixels. */
+	FORCEINLINE void NeonStoreRgbaHalf(uint16* Dest, float32x4_t Luma, float32x4_t RChroma, float32x4_t GChroma, float32x4_t BChroma)
+	{
+		uint16x4x4_t Rgba;
+		{
+			Rgba.val[0] = NeonToHalf(NeonSaturate(vaddq_f32(Luma, RChroma)));
+			Rgba.val[1] = NeonToHalf(NeonSaturate(vsubq_f32(Luma, GChroma)));
+			Rgba.val[2] = NeonToHalf(NeonSaturate(vaddq_f32(Luma, BChroma)));
+			Rgba.val[3] = vdup_n_u16(HalfOne);
+		}
+
+		vst4_u16(Dest, Rgba);
+	}
+
+	void ConvertRow16Neon(const uint16* Y, const uint16* UV, uint16* Dest, int32 Width)
+	{
+		const int32x4_t ChromaOffset = vdupq_n_s32(512);
+		const int32x4_t LumaOffset = vdupq_n_s32(64);
+
+		int32 X = 0;
+
+		for (; X + 8 <= Width; X += 8)
+		{
+			const uint16x8_t Y16 = vshrq_n_u16(vld1q_u16(Y + X), 6);
+			const uint16x4x2_t UV16 = vld2_u16(UV + X);
+
+			const float32x4_t Cb = vmulq_n_f32(vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vshr_n_u16(UV16.val[0], 6))), ChromaOffset)), P010CScale);
+			const float32x4_t Cr = vmulq_n_f32(vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vshr_n_u16(UV16.val[1], 6))), ChromaOffset)), P010CScale);
+
+			const float32x4x2_t R = vzipq_f32(vmulq_n_f32(Cr, P010Rv), vmulq_n_f32(Cr, P010Rv));
+			const float32x4_t GChroma = vaddq_f32(vmulq_n_f32(Cb, P010Gu), vmulq_n_f32(Cr, P010Gv));
+			const float32x4x2_t G = vzipq_f32(GChroma, GChroma);
+			const float32x4x2_t B = vzipq_f32(vmulq_n_f32(Cb, P010Bu), vmulq_n_f32(Cb, P010Bu));
+
+			const float32x4_t LumaLo = vmulq_n_f32(vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(Y16))), LumaOffset)), P010YScale);
+			const float32x4_t LumaHi = vmulq_n_f32(vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(Y16))), LumaOffset)), P010YScale);
+
+			NeonStoreRgbaHalf(Dest + X * 4, LumaLo, R.val[0], G.val[0], B.val[0]);
+			NeonStoreRgbaHalf(Dest + X * 4 + 16, LumaHi, R.val[1], G.val[1], B.val[1]);
+		}
+
+		ScalarRow16(Y, UV, Dest, X, Width);
+	}
+
+#endif //VLCMEDIA_SIMD_NEON
+
+
+	/* Dispatch
+	 *****************************************************************************/
+
+	template<bool Interleaved>
+	FConvertRow8Func GetConvertRow8Func(VlcMedia::ESimdLevel Level)
+	{
+		switch (Level)
+		{
+#if VLCMEDIA_SIMD_X86
+		case VlcMedia::ESimdLevel::Sse2: return &ConvertRow8Sse2<Interleaved>;
+		case VlcMedia::ESimdLevel::Avx2: return &ConvertRow8Avx2<Interleaved>;
+#endif
+#if VLCMEDIA_SIMD_NEON
+		case VlcMedia::ESimdLevel::Neon: return &ConvertRow8Neon<Interleaved>;
+#endif
+		default:
+			return &ConvertRow8Scalar<Interleaved>;
+		}
+	}
+
+	FConvertRow16Func GetConvertRow16Func(VlcMedia::ESimdLevel Level)
+	{
+		switch (Level)
+		{
+#if VLCMEDIA_SIMD_X86
+		case VlcMedia::ESimdLevel::Sse2: return &ConvertRow16Sse2;
+		case VlcMedia::ESimdLevel::Avx2: return &ConvertRow16Avx2;
+#endif
+#if VLCMEDIA_SIMD_NEON
+		case VlcMedia::ESimdLevel::Neon: return &ConvertRow16Neon;
+#endif
+		default:
+			return &ConvertRow16Scalar;
+		}
+	}
+
+	/** Convert the rows in the specified range. */
+	void ConvertRows(VlcMedia::EChromaConversion Conversion, const VlcMedia::FChromaPlanes& Source, int32 Width, int32 RowBegin, int32 RowEnd, uint8* Dest, uint32 DestStride, VlcMedia::ESimdLevel Level, const FYuvCoefficients& C)
+	{
+		switch (Conversion)
+		{
+		case VlcMedia::EChromaConversion::I420ToBgra:
+			{
+				const FConvertRow8Func ConvertRow = GetConvertRow8Func<false>(Level);
+
+				for (int32 Row = RowBegin; Row < RowEnd; ++Row)
+				{
+					ConvertRow(
+						Source.Planes[0] + Row * Source.Pitches[0],
+						Source.Planes[1] + (Row / 2) * Source.Pitches[1],
+						Source.Planes[2] + (Row / 2) * Source.Pitches[2],
+						Dest + Row * DestStride,
+						Width,
+						C
+					);
+				}
+			}
+			break;
+
+		case VlcMedia::EChromaConversion::Nv12ToBgra:
+			{
+				const FConvertRow8Func ConvertRow = GetConvertRow8Func<true>(Level);
+
+				for (int32 Row = RowBegin; Row < RowEnd; ++Row)
+				{
+					const uint8* UV = Source.Planes[1] + (Row / 2) * Source.Pitches[1];
+					ConvertRow(Source.Planes[0] + Row * Source.Pitches[0], UV, UV, Dest + Row * DestStride, Width, C);
+				}
+			}
+			break;
+
+		case VlcMedia::EChromaConversion::P010ToRgbaHalf:
+			{
+				const FConvertRow16Func ConvertRow = GetConvertRow16Func(Level);
+
+				for (int32 Row = RowBegin; Row < RowEnd; ++Row)
+				{
+					ConvertRow(
+						(const uint16*)(Source.Planes[0] + Row * Source.Pitches[0]),
+						(const uint16*)(Source.Planes[1] + (Row / 2) * Source.Pitches[1]),
+						(uint16*)(Dest + Row * DestStride),
+						Width
+					);
+				}
+			}
+			break;
+		}
+	}
+
+
+	/* Benchmark
+	 *****************************************************************************/
+
+	/** Runs all chroma conversion kernels on synthetic frames and logs their throughput. */
+	void BenchmarkChroma(const TArray<FString>& Args)
+	{
+		const int32 NumIterations = (Args.Num() > 0) ? FMath::Max(1, FCString::Atoi(*Args[0])) : 20;
+		const FIntPoint Resolutions[] = { FIntPoint(1280, 720), FIntPoint(1920, 1080), FIntPoint(3840, 2160) };
+		const VlcMedia::EChromaConversion Conversions[] = { VlcMedia::EChromaConversion::I420ToBgra, VlcMedia::EChromaConversion::Nv12ToBgra, VlcMedia::EChromaConversion::P010ToRgbaHalf };
+		const VlcMedia::ESimdLevel Levels[] = { VlcMedia::ESimdLevel::Scalar, VlcMedia::ESimdLevel::Sse2, VlcMedia::ESimdLevel::Avx2, VlcMedia::ESimdLevel::Neon };
+
+		UE_LOG(LogVlcMedia, Display, TEXT("Benchmarking chroma conversions (%i iterations, throughput = source + destination bytes)"), NumIterations);
+
+		for (const VlcMedia::EChromaConversion Conversion : Conversions)
+		{
+			const bool HighBitDepth = (Conversion == VlcMedia::EChromaConversion::P010ToRgbaHalf);
+			const uint32 BytesPerSample = HighBitDepth ? 2 : 1;
+			const uint32 DestBytesPerPixel = VlcMedia::GetChromaDestBytesPerPixel(Conversion);
+
+			for (const FIntPoint& Dim : Resolutions)
+			{
+				// create synthetic source frame
+				const uint32 LumaPitch = Dim.X * BytesPerSample;
+				const uint32 ChromaPitch = (Conversion == VlcMedia::EChromaConversion::I420ToBgra) ? LumaPitch / 2 : LumaPitch;
+				const SIZE_T LumaSize = (SIZE_T)LumaPitch * Dim.Y;
+				const SIZE_T ChromaSize = (SIZE_T)ChromaPitch * (Dim.Y / 2);
+
+				TArray<uint8> SourceBuffer;
+				SourceBuffer.SetNumUninitialized(LumaSize + 2 * ChromaSize);
+
+				uint32 Seed = 0x12345678;
+
+				for (uint8& Byte : SourceBuffer)
+				{
+					Seed = Seed * 1664525 + 1013904223;
+					Byte = (uint8)(Seed >> 24);
+				}
+
+				VlcMedia::FChromaPlanes Source;
+				{
+					Source.Planes[0] = SourceBuffer.GetData();
+					Source.Planes[1] = SourceBuffer.GetData() + LumaSize;
+					Source.Planes[2] = SourceBuffer.GetData() + LumaSize + ChromaSize;
+					Source.Pitches[0] = LumaPitch;
+					Source.Pitches[1] = ChromaPitch;
+					Source.Pitches[2] = ChromaPitch;
+				}
+
+				const SIZE_T SourceBytes = LumaSize + ((Conversion == VlcMedia::EChromaConversion::I420ToBgra) ? 2 * ChromaSize : ChromaSize);
+				const uint32 DestStride = Dim.X * DestBytesPerPixel;
+
+				TArray<uint8> Reference;
+				Reference.SetNumUninitialized(DestStride * Dim.Y);
+				VlcMedia::ConvertChroma(Conversion, Source, Dim, Reference.GetData(), DestStride, VlcMedia::ESimdLevel::Scalar, false);
+
+				TArray<uint8> DestBuffer;
+				DestBuffer.SetNumUninitialized(DestStride * Dim.Y);
+
+				for (const VlcMedia::ESimdLevel Level : Levels)
+				{
+					if (!VlcMedia::IsSimdLevelSupported(Level))
+					{
+						continue;
+					}
+
+					double GigabytesPerSecond[2];
+
+					for (int32 Parallel = 0; Parallel < 2; ++Parallel)
+					{
+						VlcMedia::ConvertChroma(Conversion, Source, Dim, DestBuffer.GetData(), DestStride, Level, Parallel != 0); // warm up
+
+						const double StartTime = FPlatformTime::Seconds();
+
+						for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+						{
+							VlcMedia::ConvertChroma(Conversion, Source, Dim, DestBuffer.GetData(), DestStride, Level, Parallel != 0);
+						}
+
+						const double Seconds = FMath::Max(FPlatformTime::Seconds() - StartTime, SMALL_NUMBER);
+						GigabytesPerSecond[Parallel] = ((double)(SourceBytes + DestBuffer.Num()) * NumIterations) / Seconds / 1.0e9;
+					}
+
+					const bool Matches = (FMemory::Memcmp(Reference.GetData(), DestBuffer.GetData(), DestBuffer.Num()) == 0);
+
+					UE_LOG(LogVlcMedia, Display, TEXT("    %s %ix%i %s: %.2f GB/s (1 thread), %.2f GB/s (parallel)%s"),
+						VlcMedia::ChromaConversionToString(Conversion),
+						Dim.X,
+						Dim.Y,
+						VlcMedia::SimdLevelToString(Level),
+						GigabytesPerSecond[0],
+						GigabytesPerSecond[1],
+						Matches ? TEXT("") : TEXT(" [OUTPUT MISMATCH]")
+					);
+				}
+			}
+		}
+	}
+
+	FAutoConsoleCommand BenchmarkChromaCommand(
+		TEXT("VlcMedia.BenchmarkChroma"),
+		TEXT("Measure the throughput of the VlcMedia chroma conversion kernels.\nUsage: VlcMedia.BenchmarkChroma [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkChroma)
+	);
+}
+
+
+namespace VlcMedia
+{
+	void ConvertChroma(EChromaConversion Conversion, const FChromaPlanes& Source, const FIntPoint& Dim, uint8* Dest, uint32 DestStride, ESimdLevel Level, bool Parallel)
+	{
+		check(IsSimdLevelSupported(Level));
+
+		if ((Dim.X <= 0) || (Dim.Y <= 0))
+		{
+			return;
+		}
+
+		const VlcMediaChroma::FYuvCoefficients& Coefficients = (Dim.Y > 576) ? VlcMediaChroma::Bt709 : VlcMediaChroma::Bt601;
+		const int32 NumBands = (Dim.Y + VlcMediaChroma::RowsPerBand - 1) / VlcMediaChroma::RowsPerBand;
+
+		ParallelFor(NumBands, [&](int32 Band)
+		{
+			const int32 RowBegin = Band * VlcMediaChroma::RowsPerBand;
+			const int32 RowEnd = FMath::Min(RowBegin + VlcMediaChroma::RowsPerBand, Dim.Y);
+
+			VlcMediaChroma::ConvertRows(Conversion, Source, Dim.X, RowBegin, RowEnd, Dest, DestStride, Level, Coefficients);
+		}, !Parallel || (NumBands == 1));
+	}
+
+
+	void ConvertChroma(EChromaConversion Conversion, const FChromaPlanes& Source, const FIntPoint& Dim, uint8* Dest, uint32 DestStride)
+	{
+		ConvertChroma(Conversion, Source, Dim, Dest, DestStride, GetSimdLevel(), true);
+	}
+
+
+	const TCHAR* ChromaConversionToString(EChromaConversion Conversion)
+	{
+		switch (Conversion)
+		{
+		case EChromaConversion::I420ToBgra: return TEXT("I420 to BGRA");
+		case EChromaConversion::Nv12ToBgra: return TEXT("NV12 to BGRA");
+		case EChromaConversion::P010ToRgbaHalf: return TEXT("P010 to RGBA (half)");
+		default:
+			return TEXT("Unknown");
+		}
+	}
+
+
+	uint32 GetChromaDestBytesPerPixel(EChromaConversion Conversion)
+	{
+		return (Conversion == EChromaConversion::P010ToRgbaHalf) ? 8 : 4;
+	}
+}
@@ -0,0 +1,86 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VlcMediaSimd.h"
+
+
+namespace VlcMedia
+{
+	/** Enumerates chroma conversions implemented by the plug-in. */
+	enum class EChromaConversion
+	{
+		/** 8-bit planar 4:2:0 to 8-bit BGRA. */
+		I420ToBgra,
+
+		/** 8-bit semi-planar 4:2:0 to 8-bit BGRA. */
+		Nv12ToBgra,
+
+		/** 10-bit semi-planar 4:2:0 to 16-bit floating point RGBA. */
+		P010ToRgbaHalf
+	};
+
+
+	/**
+	 * Source planes of a frame to be converted.
+	 *
+	 * Planar formats use all three planes (Y, U, V), semi-planar
+	 * formats use the first two (Y, interleaved UV).
+	 */
+	struct FChromaPlanes
+	{
+		/** Pointers to the first row of each plane. */
+		const uint8* Planes[3];
+
+		/** Number of bytes per row in each plane. */
+		uint32 Pitches[3];
+	};
+
+
+	/**
+	 * Convert a frame to RGB.
+	 *
+	 * The frame is split into bands of rows that are converted in parallel
+	 * on the task graph. The calling thread participates in the conversion
+	 * and returns once the entire frame has been converted.
+	 *
+	 * @param Conversion The conversion to perform.
+	 * @param Source The source planes.
+	 * @param Dim Width and height of the frame (in pixels).
+	 * @param Dest The destination buffer.
+	 * @param DestStride Number of bytes per row in the destination buffer.
+	 * @param Level The instruction set to use (must be supported by the CPU).
+	 * @param Parallel Whether to distribute rows across worker threads.
+	 * @see GetChromaDestBytesPerPixel, GetSimdLevel
+	 */
+	void ConvertChroma(EChromaConversion Conversion, const FChromaPlanes& Source, const FIntPoint& Dim, uint8* Dest, uint32 DestStride, ESimdLevel Level, bool Parallel);
+
+	/**
+	 * Convert a frame to RGB using the best instruction set available.
+	 *
+	 * @param Conversion The conversion to perform.
+	 * @param Source The source planes.
+	 * @param Dim Width and height of the frame (in pixels).
+	 * @param Dest The destination buffer.
+	 * @param DestStride Number of bytes per row in the destination buffer.
+	 */
+	void ConvertChroma(EChromaConversion Conversion, const FChromaPlanes& Source, const FIntPoint& Dim, uint8* Dest, uint32 DestStride);
+
+	/**
+	 * Convert a chroma conversion to string.
+	 *
+	 * @param Conversion The conversion to convert.
+	 * @return The corresponding string.
+	 */
+	const TCHAR* ChromaConversionToString(EChromaConversion Conversion);
+
+	/**
+	 * Get the number of bytes per pixel produced by a chroma conversion.
+	 *
+	 * @param Conversion The conversion.
+	 * @return Bytes per destination pixel.
+	 */
+	uint32 GetChromaDestBytesPerPixel(EChromaConversion Conversion);
+}
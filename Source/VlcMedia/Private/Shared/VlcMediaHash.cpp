@@ -0,0 +1,423 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaHash.h"
+
+#if VLCMEDIA_SIMD_X86
+	#include <emmintrin.h>
+	#include <immintrin.h>
+#endif
+
+#if VLCMEDIA_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+
+/*
+ * The hash accumulates 64 byte stripes into eight 64-bit lanes using the
+ * multiply-accumulate scheme of XXH3, which maps directly to 32x32->64 bit
+ * vector multiplies. Lanes are scrambled every 16 stripes and at the end
+ * of each row. All implementations follow the same schedule, so that they
+ * produce identical results.
+ */
+namespace VlcMediaHash
+{
+	/** Number of bytes per stripe. */
+	const uint32 StripeSize = 64;
+
+	/** Number of stripes between lane scrambles. */
+	const uint32 StripesPerScramble = 16;
+
+	/** Per-lane keys for the accumulate step. */
+	alignas(32) const uint64 AccumulateKeys[8] =
+	{
+		0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+		0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull
+	};
+
+	/** Per-lane keys for the scramble step. */
+	alignas(32) const uint64 ScrambleKeys[8] =
+	{
+		0xcb00c391bb52283cull, 0xa32e531b8b65d088ull, 0x4ef90da297486471ull, 0xd8acdea946ef1938ull,
+		0x3f349ce33f76faa8ull, 0x1d4f0bc7c7bbdcf9ull, 0x3159b4cd4be0518aull, 0x647378d9c97e9fc8ull
+	};
+
+	const uint32 Prime32 = 0x9e3779b1u;
+	const uint64 Prime64A = 0x9e3779b185ebca87ull;
+	const uint64 Prime64B = 0xc2b2ae3d27d4eb4full;
+	const uint64 Prime64C = 0x165667b19e3779f9ull;
+	const uint64 Prime64D = 0x85ebca77c2b2ae63ull;
+
+	/** Hashes a single row into the lane accumulators. */
+	typedef void (*FAccumulateRowFunc)(uint64* Acc, const uint8* Row, uint32 RowBytes);
+
+	/** Pads the last partial stripe of a row with zeros. */
+	FORCEINLINE void CopyTail(uint8* Stripe, const uint8* Row, uint32 Offset, uint32 RowBytes)
+	{
+		FMemory::Memzero(Stripe, StripeSize);
+		FMemory::Memcpy(Stripe, Row + Offset, RowBytes - Offset);
+	}
+
+
+	/* Scalar implementation
+	 *****************************************************************************/
+
+	FORCEINLINE void ScalarAccumulate(uint64* Acc, const uint8* Stripe)
+	{
+		for (int32 Lane = 0; Lane < 8; ++Lane)
+		{
+			uint64 Data;
+			FMemory::Memcpy(&Data, Stripe + Lane * 8, sizeof(Data));
+
+			const uint64 DataKey = Data ^ AccumulateKeys[Lane];
+
+			Acc[Lane ^ 1] += Data;
+			Acc[Lane] += (DataKey & 0xffffffffull) * (DataKey >> 32);
+		}
+	}
+
+	FORCEINLINE void ScalarScramble(uint64* Acc)
+	{
+		for (int32 Lane = 0; Lane < 8; ++Lane)
+		{
+			uint64 Value = Acc[Lane];
+			Value ^= Value >> 47;
+			Value ^= ScrambleKeys[Lane];
+			Acc[Lane] = Value * Prime32;
+		}
+	}
+
+	void AccumulateRowScalar(uint64* Acc, const uint8* Row, uint32 RowBytes)
+	{
+		uint32 Offset = 0;
+		uint32 NumStripes = 0;
+
+		for (; Offset + StripeSize <= RowBytes; Offset += StripeSize)
+		{
+			ScalarAccumulate(Acc, Row + Offset);
+
+			if (++NumStripes % StripesPerScramble == 0)
+			{
+				ScalarScramble(Acc);
+			}
+		}
+
+		if (Offset < RowBytes)
+		{
+			uint8 Tail[StripeSize];
+			CopyTail(Tail, Row, Offset, RowBytes);
+			ScalarAccumulate(Acc, Tail);
+		}
+
+		ScalarScramble(Acc);
+	}
+
+
+#if VLCMEDIA_SIMD_X86
+
+	/* SSE2 implementation
+	 *****************************************************************************/
+
+	FORCEINLINE void Sse2Accumulate(__m128i* Acc, const uint8* Stripe)
+	{
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			const __m128i Data = _mm_loadu_si128((const __m128i*)(Stripe + Index * 16));
+			const __m128i DataKey = _mm_xor_si128(Data, _mm_load_si128((const __m128i*)(AccumulateKeys + Index * 2)));
+			const __m128i Product = _mm_mul_epu32(DataKey, _mm_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+			const __m128i DataSwap = _mm_shuffle_epi32(Data, _MM_SHUFFLE(1, 0, 3, 2));
+
+			Acc[Index] = _mm_add_epi64(Acc[Index], _mm_add_epi64(Product, DataSwap));
+		}
+	}
+
+	FORCEINLINE void Sse2Scramble(__m128i* Acc)
+	{
+		const __m128i Prime = _mm_set1_epi32(Prime32);
+
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			__m128i Value = Acc[Index];
+			Value = _mm_xor_si128(Value, _mm_srli_epi64(Value, 47));
+			Value = _mm_xor_si128(Value, _mm_load_si128((const __m128i*)(ScrambleKeys + Index * 2)));
+
+			const __m128i Lo = _mm_mul_epu32(Value, Prime);
+			const __m128i Hi = _mm_mul_epu32(_mm_shuffle_epi32(Value, _MM_SHUFFLE(0, 3, 0, 1)), Prime);
+
+			Acc[Index] = _mm_add_epi64(Lo, _mm_slli_epi64(Hi, 32));
+		}
+	}
+
+	void AccumulateRowSse2(uint64* Acc, const uint8* Row, uint32 RowBytes)
+	{
+		__m128i Lanes[4];
+
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			Lanes[Index] = _mm_loadu_si128((const __m128i*)(Acc + Index * 2));
+		}
+
+		uint32 Offset = 0;
+		uint32 NumStripes = 0;
+
+		for (; Offset + StripeSize <= RowBytes; Offset += StripeSize)
+		{
+			Sse2Accumulate(Lanes, Row + Offset);
+
+			if (++NumStripes % StripesPerScramble == 0)
+			{
+				Sse2Scramble(Lanes);
+			}
+		}
+
+		if (Offset < RowBytes)
+		{
+			uint8 Tail[StripeSize];
+			CopyTail(Tail, Row, Offset, RowBytes);
+			Sse2Accumulate(Lanes, Tail);
+		}
+
+		Sse2Scramble(Lanes);
+
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			_mm_storeu_si128((__m128i*)(Acc + Index * 2), Lanes[Index]);
+		}
+	}
+
+
+	/* AVX2 implementation
+	 *****************************************************************************/
+
+	VLCMEDIA_TARGET_AVX2 FORCEINLINE void Avx2Accumulate(__m256i* Acc, const uint8* Stripe)
+	{
+		for (int32 Index = 0; Index < 2; ++Index)
+		{
+			const __m256i Data = _mm256_loadu_si256((const __m256i*)(Stripe + Index * 32));
+			const __m256i DataKey = _mm256_xor_si256(Data, _mm256_load_si256((const __m256i*)(AccumulateKeys + Index * 4)));
+			const __m256i Product = _mm256_mul_epu32(DataKey, _mm256_shuffle_epi32(DataKey, _MM_SHUFFLE(0, 3, 0, 1)));
+			const __m256i DataSwap = _mm256_shuffle_epi32(Data, _MM_SHUFFLE(1, 0, 3, 2));
+
+			Acc[Index] = _mm256_add_epi64(Acc[Index], _mm256_add_epi64(Product, DataSwap));
+		}
+	}
+
+	VLCMEDIA_TARGET_AVX2 FORCEINLINE void Avx2Scramble(__m256i* Acc)
+	{
+		const __m256i Prime = _mm256_set1_epi32(Prime32);
+
+		for (int32 Index = 0; Index < 2; ++Index)
+		{
+			__m256i Value = Acc[Index];
+			Value = _mm256_xor_si256(Value, _mm256_srli_epi64(Value, 47));
+			Value = _mm256_xor_si256(Value, _mm256_load_si256((const __m256i*)(ScrambleKeys + Index * 4)));
+
+			const __m256i Lo = _mm256_mul_epu32(Value, Prime);
+			const __m256i Hi = _mm256_mul_epu32(_mm256_shuffle_epi32(Value, _MM_SHUFFLE(0, 3, 0, 1)), Prime);
+
+			Acc[Index] = _mm256_add_epi64(Lo, _mm256_slli_epi64(Hi, 32));
+		}
+	}
+
+	VLCMEDIA_TARGET_AVX2 void AccumulateRowAvx2(uint64* Acc, const uint8* Row, uint32 RowBytes)
+	{
+		__m256i Lanes[2];
+
+		for (int32 Index = 0; Index < 2; ++Index)
+		{
+			Lanes[Index] = _mm256_loadu_si256((const __m256i*)(Acc + Index * 4));
+		}
+
+		uint32 Offset = 0;
+		uint32 NumStripes = 0;
+
+		for (; Offset + StripeSize <= RowBytes; Offset += StripeSize)
+		{
+			Avx2Accumulate(Lanes, Row + Offset);
+
+			if (++NumStripes % StripesPerScramble == 0)
+			{
+				Avx2Scramble(Lanes);
+			}
+		}
+
+		if (Offset < RowBytes)
+		{
+			uint8 Tail[StripeSize];
+			CopyTail(Tail, Row, Offset, RowBytes);
+			Avx2Accumulate(Lanes, Tail);
+		}
+
+		Avx2Scramble(Lanes);
+
+		for (int32 Index = 0; Index < 2; ++Index)
+		{
+			_mm256_storeu_si256((__m256i*)(Acc + Index * 4), Lanes[Index]);
+		}
+	}
+
+#endif //VLCMEDIA_SIMD_X86
+
+
+#if VLCMEDIA_SIMD_NEON
+
+	/* NEON implementation
+	 *****************************************************************************/
+
+	FORCEINLINE void NeonAccumulate(uint64x2_t* Acc, const uint8* Stripe)
+	{
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			const uint64x2_t Data = vreinterpretq_u64_u8(vld1q_u8(Stripe + Index * 16));
+			const uint64x2_t DataKey = veorq_u64(Data, vld1q_u64(AccumulateKeys + Index * 2));
+			const uint64x2_t Product = vmull_u32(vmovn_u64(DataKey), vshrn_n_u64(DataKey, 32));
+			const uint64x2_t DataSwap = vextq_u64(Data, Data, 1);
+
+			Acc[Index] = vaddq_u64(Acc[Index], vaddq_u64(Product, DataSwap));
+		}
+	}
+
+	FORCEINLINE void NeonScramble(uint64x2_t* Acc)
+	{
+		const uint32x2_t Prime = vdup_n_u32(Prime32);
+
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			uint64x2_t Value = Acc[Index];
+			Value = veorq_u64(Value, vshrq_n_u64(Value, 47));
+			Value = veorq_u64(Value, vld1q_u64(ScrambleKeys + Index * 2));
+
+			const uint64x2_t Lo = vmull_u32(vmovn_u64(Value), Prime);
+			const uint64x2_t Hi = vmull_u32(vshrn_n_u64(Value, 32), Prime);
+
+			Acc[Index] = vaddq_u64(Lo, vshlq_n_u64(Hi, 32));
+		}
+	}
+
+	void AccumulateRowNeon(uint64* Acc, const uint8* Row, uint32 RowBytes)
+	{
+		uint64x2_t Lanes[4];
+
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			Lanes[Index] = vld1q_u64(Acc + Index * 2);
+		}
+
+		uint32 Offset = 0;
+		uint32 NumStripes = 0;
+
+		for (; Offset + StripeSize <= RowBytes; Offset += StripeSize)
+		{
+			NeonAccumulate(Lanes, Row + Offset);
+
+			if (++NumStripes % StripesPerScramble == 0)
+			{
+				NeonScramble(Lanes);
+			}
+		}
+
+		if (Offset < RowBytes)
+		{
+			uint8 Tail[StripeSize];
+			CopyTail(Tail, Row, Offset, RowBytes);
+			NeonAccumulate(Lanes, Tail);
+		}
+
+		NeonScramble(Lanes);
+
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			vst1q_u64(Acc + Index * 2, Lanes[Index]);
+		}
+	}
+
+#endif //VLCMEDIA_SIMD_NEON
+
+
+	/* Dispatch
+	 *****************************************************************************/
+
+	FAccumulateRowFunc GetAccumulateRowFunc(VlcMedia::ESimdLevel Level)
+	{
+		switch (Level)
+		{
+#if VLCMEDIA_SIMD_X86
+		case VlcMedia::ESimdLevel::Sse2: return &AccumulateRowSse2;
+		case VlcMedia::ESimdLevel::Avx2: return &AccumulateRowAvx2;
+#endif
+#if VLCMEDIA_SIMD_NEON
+		case VlcMedia::ESimdLevel::Neon: return &AccumulateRowNeon;
+#endif
+		default:
+			return &AccumulateRowScalar;
+		}
+	}
+
+	FORCEINLINE uint64 RotateLeft(uint64 Value, uint32 Bits)
+	{
+		return (Value << Bits) | (Value >> (64 - Bits));
+	}
+
+	/** Fold the lane accumulators into the final hash value. */
+	uint64 Finalize(const uint64* Acc, uint64 TotalBytes)
+	{
+		uint64 Result = TotalBytes * Prime64A;
+
+		for (int32 Lane = 0; Lane < 8; ++Lane)
+		{
+			Result ^= RotateLeft(Acc[Lane] * Prime64B, 31) * Prime64A;
+			Result = RotateLeft(Result, 27) * Prime64A + Prime64D;
+		}
+
+		Result ^= Result >> 33;
+		Result *= Prime64B;
+		Result ^= Result >> 29;
+		Result *= Prime64C;
+		Result ^= Result >> 32;
+
+		return Result;
+	}
+}
+
+
+namespace VlcMedia
+{
+	uint64 HashImage(const FHashRegion* Regions, int32 NumRegions, ESimdLevel Level)
+	{
+		check(IsSimdLevelSupported(Level));
+
+		const VlcMediaHash::FAccumulateRowFunc AccumulateRow = VlcMediaHash::GetAccumulateRowFunc(Level);
+
+		uint64 Acc[8] =
+		{
+			VlcMediaHash::Prime32, VlcMediaHash::Prime64A, VlcMediaHash::Prime64B, VlcMediaHash::Prime64C,
+			VlcMediaHash::Prime64D, VlcMediaHash::Prime32, VlcMediaHash::Prime64A, VlcMediaHash::Prime64B
+		};
+
+		uint64 TotalBytes = 0;
+
+		for (int32 RegionIndex = 0; RegionIndex < NumRegions; ++RegionIndex)
+		{
+			const FHashRegion& Region = Regions[RegionIndex];
+
+			if ((Region.Data == nullptr) || (Region.RowBytes == 0))
+			{
+				continue;
+			}
+
+			for (uint32 Row = 0; Row < Region.NumRows; ++Row)
+			{
+				AccumulateRow(Acc, Region.Data + (SIZE_T)Row * Region.Pitch, Region.RowBytes);
+			}
+
+			TotalBytes += (uint64)Region.RowBytes * Region.NumRows;
+		}
+
+		return VlcMediaHash::Finalize(Acc, TotalBytes);
+	}
+
+
+	uint64 HashImage(const FHashRegion* Regions, int32 NumRegions)
+	{
+		return HashImage(Regions, NumRegions, GetSimdLevel());
+	}
+}
@@ -0,0 +1,55 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VlcMediaSimd.h"
+
+
+namespace VlcMedia
+{
+	/**
+	 * Describes a rectangular region of image memory to be hashed.
+	 *
+	 * Only the first RowBytes bytes of each row are hashed, so that
+	 * padding bytes that the decoder does not write are ignored.
+	 */
+	struct FHashRegion
+	{
+		/** Pointer to the first row. */
+		const uint8* Data;
+
+		/** Number of bytes between the starts of consecutive rows. */
+		uint32 Pitch;
+
+		/** Number of bytes to hash per row. */
+		uint32 RowBytes;
+
+		/** Number of rows to hash. */
+		uint32 NumRows;
+	};
+
+
+	/**
+	 * Calculate a 64-bit hash of the specified image regions.
+	 *
+	 * All instruction sets produce the same hash value.
+	 *
+	 * @param Regions The regions to hash (in order).
+	 * @param NumRegions Number of regions.
+	 * @param Level The instruction set to use (must be supported by the CPU).
+	 * @return The hash value.
+	 * @see GetSimdLevel
+	 */
+	uint64 HashImage(const FHashRegion* Regions, int32 NumRegions, ESimdLevel Level);
+
+	/**
+	 * Calculate a 64-bit hash of the specified image regions using the best instruction set available.
+	 *
+	 * @param Regions The regions to hash (in order).
+	 * @param NumRegions Number of regions.
+	 * @return The hash value.
+	 */
+	uint64 HashImage(const FHashRegion* Regions, int32 NumRegions);
+}
@@ -0,0 +1,172 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#include "VlcMediaSimd.h"
+
+#if VLCMEDIA_SIMD_X86
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#include <immintrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+
+namespace VlcMediaSimd
+{
+#if VLCMEDIA_SIMD_X86
+	/** Execute the CPUID instruction. */
+	void Cpuid(uint32 Leaf, uint32 SubLeaf, uint32 OutRegisters[4])
+	{
+#if defined(_MSC_VER)
+		int Registers[4];
+		__cpuidex(Registers, (int)Leaf, (int)SubLeaf);
+
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			OutRegisters[Index] = (uint32)Registers[Index];
+		}
+#else
+		if (Leaf > __get_cpuid_max(Leaf & 0x80000000, nullptr))
+		{
+			FMemory::Memzero(OutRegisters, 4 * sizeof(uint32));
+			return;
+		}
+
+		__cpuid_count(Leaf, SubLeaf, OutRegisters[0], OutRegisters[1], OutRegisters[2], OutRegisters[3]);
+#endif
+	}
+
+	/** Read the extended control register that holds the OS enabled register states. */
+	uint64 ReadXcr0()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		uint32 Eax = 0;
+		uint32 Edx = 0;
+		__asm__ __volatile__("xgetbv" : "=a"(Eax), "=d"(Edx) : "c"(0));
+
+		return ((uint64)Edx << 32) | Eax;
+#endif
+	}
+
+	/** Check whether the CPU and the operating system support AVX2. */
+	bool DetectAvx2()
+	{
+		uint32 Registers[4];
+		Cpuid(0, 0, Registers);
+
+		if (Registers[0] < 7)
+		{
+			return false;
+		}
+
+		// AVX & OSXSAVE
+		Cpuid(1, 0, Registers);
+
+		if ((Registers[2] & ((1 << 27) | (1 << 28))) != ((1 << 27) | (1 << 28)))
+		{
+			return false;
+		}
+
+		// XMM & YMM state enabled by OS
+		if ((ReadXcr0() & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		Cpuid(7, 0, Registers);
+
+		return ((Registers[1] & (1 << 5)) != 0);
+	}
+
+	/** Check whether the CPU supports SSE2. */
+	bool DetectSse2()
+	{
+#if defined(_M_X64) || defined(__x86_64__)
+		return true;
+#else
+		uint32 Registers[4];
+		Cpuid(1, 0, Registers);
+
+		return ((Registers[3] & (1 << 26)) != 0);
+#endif
+	}
+#endif //VLCMEDIA_SIMD_X86
+}
+
+
+namespace VlcMedia
+{
+	ESimdLevel GetSimdLevel()
+	{
+		static const ESimdLevel Level = []()
+		{
+			if (IsSimdLevelSupported(ESimdLevel::Avx2))
+			{
+				return ESimdLevel::Avx2;
+			}
+
+			if (IsSimdLevelSupported(ESimdLevel::Sse2))
+			{
+				return ESimdLevel::Sse2;
+			}
+
+			if (IsSimdLevelSupported(ESimdLevel::Neon))
+			{
+				return ESimdLevel::Neon;
+			}
+
+			return ESimdLevel::Scalar;
+		}();
+
+		return Level;
+	}
+
+
+	bool IsSimdLevelSupported(ESimdLevel Level)
+	{
+		switch (Level)
+		{
+		case ESimdLevel::Scalar:
+			return true;
+
+#if VLCMEDIA_SIMD_X86
+		case ESimdLevel::Sse2:
+			{
+				static const bool Supported = VlcMediaSimd::DetectSse2();
+				return Supported;
+			}
+
+		case ESimdLevel::Avx2:
+			{
+				static const bool Supported = VlcMediaSimd::DetectAvx2();
+				return Supported;
+			}
+#endif
+
+#if VLCMEDIA_SIMD_NEON
+		case ESimdLevel::Neon:
+			return true;
+#endif
+
+		default:
+			return false;
+		}
+	}
+
+
+	const TCHAR* SimdLevelToString(ESimdLevel Level)
+	{
+		switch (Level)
+		{
+		case ESimdLevel::Scalar: return TEXT("Scalar");
+		case ESimdLevel::Sse2: return TEXT("SSE2");
+		case ESimdLevel::Avx2: return TEXT("AVX2");
+		case ESimdLevel::Neon: return TEXT("NEON");
+		default:
+			return TEXT("Unknown");
+		}
+	}
+}
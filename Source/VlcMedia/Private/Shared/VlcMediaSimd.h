@@ -0,0 +1,68 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define VLCMEDIA_SIMD_X86 1
+#else
+	#define VLCMEDIA_SIMD_X86 0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+	#define VLCMEDIA_SIMD_NEON 1
+#else
+	#define VLCMEDIA_SIMD_NEON 0
+#endif
+
+/** Marks a function that may use AVX2 instructions (selected at run-time only). */
+#if VLCMEDIA_SIMD_X86 && (defined(__clang__) || defined(__GNUC__))
+	#define VLCMEDIA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define VLCMEDIA_TARGET_AVX2
+#endif
+
+
+namespace VlcMedia
+{
+	/** Enumerates instruction sets available to the plug-in's SIMD kernels. */
+	enum class ESimdLevel
+	{
+		/** Portable C++ implementation. */
+		Scalar,
+
+		/** x86 SSE2 instructions. */
+		Sse2,
+
+		/** x86 AVX2 instructions. */
+		Avx2,
+
+		/** ARM NEON instructions. */
+		Neon
+	};
+
+	/**
+	 * Get the best instruction set supported by the CPU.
+	 *
+	 * @return The instruction set.
+	 */
+	ESimdLevel GetSimdLevel();
+
+	/**
+	 * Check whether the CPU supports the specified instruction set.
+	 *
+	 * @param Level The instruction set to check.
+	 * @return true if supported, false otherwise.
+	 */
+	bool IsSimdLevelSupported(ESimdLevel Level);
+
+	/**
+	 * Convert an instruction set to string.
+	 *
+	 * @param Level The instruction set to convert.
+	 * @return The corresponding string.
+	 */
+	const TCHAR* SimdLevelToString(ESimdLevel Level);
+}
@@ -1,6 +1,7 @@
 // Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
 
 #include "VlcMediaUtils.h"
+#include "VlcMediaPrivate.h"
 #include "VlcTypes.h"
 
 
@@ -78,6 +79,18 @@ namespace VlcMedia
 	}
 
 
+	FString SeekModeToString(EVlcMediaSeekMode Mode)
+	{
+		switch (Mode)
+		{
+		case EVlcMediaSeekMode::Fast: return TEXT("Fast");
+		case EVlcMediaSeekMode::Accurate: return TEXT("Accurate");
+		default:
+			return FString::Printf(TEXT("Unknown mode %i"), (int32)Mode);
+		}
+	}
+
+
 	FString StateToString(ELibvlcState State)
 	{
 		switch (State)
@@ -6,6 +6,7 @@
 
 
 enum class ELibvlcState;
+enum class EVlcMediaSeekMode : uint8;
 struct FLibvlcEvent;
 
 
@@ -19,6 +20,14 @@ namespace VlcMedia
 	 */
 	FString EventToString(FLibvlcEvent* Event);
 
+	/**
+	 * Convert a seek mode to string.
+	 *
+	 * @param Mode The seek mode to convert.
+	 * @return The corresponding string.
+	 */
+	FString SeekModeToString(EVlcMediaSeekMode Mode);
+
 	/**
 	 * Convert a LibVLC state to string.
 	 *
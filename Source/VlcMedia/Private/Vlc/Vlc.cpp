@@ -60,6 +60,7 @@ VLC_DEFINE(GetVersion)
 
 VLC_DEFINE(Clock)
 
+VLC_DEFINE(MediaAddOption)
 VLC_DEFINE(MediaEventManager)
 VLC_DEFINE(MediaGetDuration)
 VLC_DEFINE(MediaGetStats)
@@ -67,6 +68,7 @@ VLC_DEFINE(MediaNewCallbacks)
 VLC_DEFINE(MediaNewLocation)
 VLC_DEFINE(MediaNewPath)
 VLC_DEFINE(MediaParseAsync)
+VLC_DEFINE(MediaParseStop)
 VLC_DEFINE(MediaRelease)
 VLC_DEFINE(MediaRetain)
 VLC_DEFINE(MediaTracksGet)
@@ -93,6 +95,7 @@ VLC_DEFINE(MediaPlayerSetRate)
 VLC_DEFINE(MediaPlayerSetTime)
 
 VLC_DEFINE(MediaPlayerIsPlaying)
+VLC_DEFINE(MediaPlayerNextFrame)
 VLC_DEFINE(MediaPlayerPause)
 VLC_DEFINE(MediaPlayerPlay)
 VLC_DEFINE(MediaPlayerSetPause)
@@ -196,6 +199,7 @@ bool FVlc::Initialize()
 
 	VLC_IMPORT(libvlc_clock, Clock)
 
+	VLC_IMPORT(libvlc_media_add_option, MediaAddOption)
 	VLC_IMPORT(libvlc_media_event_manager, MediaEventManager)
 	VLC_IMPORT(libvlc_media_get_duration, MediaGetDuration)
 	VLC_IMPORT(libvlc_media_get_stats, MediaGetStats)
@@ -203,6 +207,7 @@ bool FVlc::Initialize()
 	VLC_IMPORT(libvlc_media_new_location, MediaNewLocation)
 	VLC_IMPORT(libvlc_media_new_path, MediaNewPath)
 	VLC_IMPORT(libvlc_media_parse_async, MediaParseAsync)
+	VLC_IMPORT(libvlc_media_parse_stop, MediaParseStop)
 	VLC_IMPORT(libvlc_media_release, MediaRelease)
 	VLC_IMPORT(libvlc_media_retain, MediaRetain)
 	VLC_IMPORT(libvlc_media_tracks_get, MediaTracksGet)
@@ -229,6 +234,7 @@ bool FVlc::Initialize()
 	VLC_IMPORT(libvlc_media_player_set_time, MediaPlayerSetTime)
 
 	VLC_IMPORT(libvlc_media_player_is_playing, MediaPlayerIsPlaying)
+	VLC_IMPORT(libvlc_media_player_next_frame, MediaPlayerNextFrame)
 	VLC_IMPORT(libvlc_media_player_pause, MediaPlayerPause)
 	VLC_IMPORT(libvlc_media_player_play, MediaPlayerPlay)
 	VLC_IMPORT(libvlc_media_player_set_pause, MediaPlayerSetPause)
@@ -43,6 +43,7 @@ public:
 
 	static FLibvlcClockProc Clock;
 
+	static FLibvlcMediaAddOptionProc MediaAddOption;
 	static FLibvlcMediaEventManagerProc MediaEventManager;
 	static FLibvlcMediaGetDurationProc MediaGetDuration;
 	static FLibvlcMediaGetStatsProc MediaGetStats;
@@ -50,6 +51,7 @@ public:
 	static FLibvlcMediaNewLocationProc MediaNewLocation;
 	static FLibvlcMediaNewPathProc MediaNewPath;
 	static FLibvlcMediaParseAsyncProc MediaParseAsync;
+	static FLibvlcMediaParseStopProc MediaParseStop;
 	static FLibvlcMediaReleaseProc MediaRelease;
 	static FLibvlcMediaRetainProc MediaRetain;
 	static FLibvlcMediaTracksGetProc MediaTracksGet;
@@ -76,6 +78,7 @@ public:
 	static FLibvlcMediaPlayerSetTimeProc MediaPlayerSetTime;
 
 	static FLibvlcMediaPlayerIsPlayingProc MediaPlayerIsPlaying;
+	static FLibvlcMediaPlayerNextFrameProc MediaPlayerNextFrame;
 	static FLibvlcMediaPlayerPauseProc MediaPlayerPause;
 	static FLibvlcMediaPlayerPlayProc MediaPlayerPlay;
 	static FLibvlcMediaPlayerSetPauseProc MediaPlayerSetPause;
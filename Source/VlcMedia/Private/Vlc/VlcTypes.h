@@ -130,7 +130,7 @@ enum class ELibvlcState
 /** Enumerates known track types. */
 enum class ELibvlcTrackType
 {
-	Unknown,
+	Unknown = -1,
 	Audio,
 	Video,
 	Text
@@ -355,6 +355,54 @@ struct FLibvlcMediaStats
 };
 
 
+/**
+ * Structure for VLC video viewpoints (libvlc_video_viewpoint_t).
+ */
+struct FLibvlcVideoViewpoint
+{
+	float Yaw;
+	float Pitch;
+	float Roll;
+	float FieldOfView;
+};
+
+
+/**
+ * Structure for VLC audio track properties (libvlc_audio_track_t).
+ */
+struct FLibvlcAudioTrack
+{
+	uint32 Channels;
+	uint32 Rate;
+};
+
+
+/**
+ * Structure for VLC video track properties (libvlc_video_track_t).
+ */
+struct FLibvlcVideoTrack
+{
+	uint32 Height;
+	uint32 Width;
+	uint32 SarNum;
+	uint32 SarDen;
+	uint32 FrameRateNum;
+	uint32 FrameRateDen;
+	int32 Orientation;
+	int32 Projection;
+	FLibvlcVideoViewpoint Pose;
+};
+
+
+/**
+ * Structure for VLC subtitle track properties (libvlc_subtitle_track_t).
+ */
+struct FLibvlcSubtitleTrack
+{
+	ANSICHAR* Encoding;
+};
+
+
 /**
  * Structure for VLC media tracks (libvlc_media_track).
  */
@@ -366,6 +414,17 @@ struct FLibvlcMediaTrack
 	ELibvlcTrackType Type;
 	int32 Profile;
 	int32 Level;
+
+	union
+	{
+		FLibvlcAudioTrack* Audio;
+		FLibvlcVideoTrack* Video;
+		FLibvlcSubtitleTrack* Subtitle;
+	};
+
+	uint32 Bitrate;
+	ANSICHAR* Language;
+	ANSICHAR* Description;
 };
 
 
@@ -378,15 +437,3 @@ struct FLibvlcTrackDescription
 	ANSICHAR* Name;
 	FLibvlcTrackDescription* Next;
 };
-
-
-/**
- * Structure for VLC video viewpoints (libvlc_video_viewpoint_t).
- */
-struct FLibvlcVideoViewpoint
-{
-	float Yaw;
-	float Pitch;
-	float Roll;
-	float FieldOfView;
-};
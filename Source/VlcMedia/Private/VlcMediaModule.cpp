@@ -12,7 +12,10 @@
 #include "UObject/WeakObjectPtr.h"
 
 #include "Vlc.h"
+#include "VlcMediaFileCache.h"
+#include "VlcMediaReaper.h"
 #include "VlcMediaPlayer.h"
+#include "VlcMediaPlayerPool.h"
 
 
 DEFINE_LOG_CATEGORY(LogVlcMedia);
@@ -47,6 +50,16 @@ public:
 		return MakeShared<FVlcMediaPlayer, ESPMode::ThreadSafe>(EventSink, VlcInstance);
 	}
 
+	virtual IVlcMediaPlayer* GetVlcPlayer(IMediaPlayer& Player) override
+	{
+		if (Player.GetPlayerName() != FName(TEXT("VlcMedia")))
+		{
+			return nullptr;
+		}
+
+		return static_cast<FVlcMediaPlayer*>(&Player);
+	}
+
 public:
 
 	//~ IModuleInterface interface
@@ -137,6 +150,9 @@ public:
 		// register logging callback
 		FVlc::LogSet(VlcInstance, &FVlcMediaModule::HandleVlcLog, nullptr);
 
+		// create reusable players
+		FVlcMediaPlayerPool::Get().Initialize(VlcInstance, Settings->PlayerPoolSize);
+
 		Initialized = true;
 	}
 
@@ -149,6 +165,11 @@ public:
 
 		Initialized = false;
 
+		// release closed players and precached files
+		FVlcMediaReaper::Get().Flush();
+		FVlcMediaPlayerPool::Get().Empty();
+		FVlcMediaFileCache::Get().Empty();
+
 		// unregister logging callback
 		FVlc::LogUnset(VlcInstance);
 
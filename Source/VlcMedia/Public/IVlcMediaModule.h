@@ -7,6 +7,7 @@
 
 class IMediaEventSink;
 class IMediaPlayer;
+class IVlcMediaPlayer;
 
 
 /**
@@ -25,6 +26,14 @@ public:
 	 */
 	virtual TSharedPtr<IMediaPlayer, ESPMode::ThreadSafe> CreatePlayer(IMediaEventSink& EventSink) = 0;
 
+	/**
+	 * Get the VLC specific features of a media player.
+	 *
+	 * @param Player The media player.
+	 * @return The VLC player interface, or nullptr if the player is not a VlcMedia player.
+	 */
+	virtual IVlcMediaPlayer* GetVlcPlayer(IMediaPlayer& Player) = 0;
+
 public:
 
 	/** Virtual destructor. */
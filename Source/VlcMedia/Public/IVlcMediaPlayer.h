@@ -0,0 +1,112 @@
+// Copyright 1998-2017 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMediaOptions;
+
+enum class EVlcMediaSeekMode : uint8;
+
+
+/**
+ * Interface for VLC specific features of VlcMedia players.
+ *
+ * @see IVlcMediaModule::GetVlcPlayer
+ */
+class IVlcMediaPlayer
+{
+public:
+
+	/**
+	 * Start scrubbing, i.e. while the user drags a timeline slider.
+	 *
+	 * While scrubbing, playback is paused and seek requests are coalesced, so
+	 * that only the most recent one is being decoded, and a preview frame is
+	 * output for each of them. Seeks snap to the nearest keyframe only if the
+	 * media has a keyframe index, i.e. for local MP4 and QuickTime files.
+	 * Other media seek to the exact time, so the frames between the preceding
+	 * keyframe and the requested time are still decoded.
+	 *
+	 * @return true if scrubbing started, false if the media cannot seek.
+	 * @see EndScrub, IsScrubbing
+	 */
+	virtual bool BeginScrub() = 0;
+
+	/**
+	 * Discard the media that was queued to play next.
+	 *
+	 * @see QueueNext
+	 */
+	virtual void CancelNext() = 0;
+
+	/**
+	 * Stop scrubbing.
+	 *
+	 * The most recently requested position is decoded using the player's seek
+	 * mode, and playback resumes if it was playing when scrubbing started.
+	 *
+	 * @see BeginScrub
+	 */
+	virtual void EndScrub() = 0;
+
+	/**
+	 * Get the mode that is used for seeking.
+	 *
+	 * @return Seek mode.
+	 * @see SetSeekMode
+	 */
+	virtual EVlcMediaSeekMode GetSeekMode() const = 0;
+
+	/**
+	 * Check whether the media that was queued to play next is opened and primed.
+	 *
+	 * @return true if the next media can be switched to without delay, false otherwise.
+	 * @see QueueNext
+	 */
+	virtual bool IsNextReady() const = 0;
+
+	/**
+	 * Check whether the player is scrubbing.
+	 *
+	 * @return true if scrubbing, false otherwise.
+	 * @see BeginScrub
+	 */
+	virtual bool IsScrubbing() const = 0;
+
+	/**
+	 * Queue the media to play after the current one.
+	 *
+	 * The media is opened on a second VLC player in the background, and its
+	 * first samples are decoded ahead of time. When the current media reaches
+	 * its end, sample output switches over to the queued media, and the player
+	 * sends the same events as if the media had been opened. If a crossfade is
+	 * specified, the switch happens that much earlier and the audio of both
+	 * media is mixed. Queueing another media replaces the previous one.
+	 *
+	 * While media is queued, the current media does not loop. The engine's
+	 * media playlists should not be used on players with queued media.
+	 *
+	 * @param Url The URL of the media to play next.
+	 * @param Options Optional media parameters.
+	 * @param Crossfade Duration of the audio crossfade (0 = switch at the end of the current media).
+	 * @return true if the media is being prepared, false otherwise.
+	 * @see CancelNext, IsNextReady
+	 */
+	virtual bool QueueNext(const FString& Url, const IMediaOptions* Options, FTimespan Crossfade) = 0;
+
+	/**
+	 * Set the mode to use for seeking.
+	 *
+	 * The player's latency statistics are collected separately for each mode.
+	 *
+	 * @param Mode The seek mode (see UVlcMediaSettings::SeekMode for the default).
+	 * @see GetSeekMode
+	 */
+	virtual void SetSeekMode(EVlcMediaSeekMode Mode) = 0;
+
+public:
+
+	/** Virtual destructor. */
+	virtual ~IVlcMediaPlayer() { }
+};
@@ -86,6 +86,14 @@ public:
 			{
 				OutWarnings->Add(LOCTEXT("PrecacheFileWarning", "Precaching is supported for local files only"));
 			}
+
+			if (Options->GetMediaOption("AudioOnly", false) &&
+				(Options->GetMediaOption("ConvertToRgb", false) ||
+				 Options->GetMediaOption("SkipIdenticalFrames", false) ||
+				 (Options->GetMediaOption("MaxOutputDim", (int64)0) > 0)))
+			{
+				OutWarnings->Add(LOCTEXT("AudioOnlyWarning", "Video output options are ignored in audio-only mode"));
+			}
 		}
 
 		return true;
@@ -115,6 +123,8 @@ public:
 
 	virtual bool SupportsFeature(EMediaFeature Feature) const override
 	{
+		// video features are supported unless the AudioOnly media option is set
+		// on the media source, in which case no video tracks or samples are produced
 		return ((Feature == EMediaFeature::AudioSamples) ||
 				(Feature == EMediaFeature::AudioTracks) ||
 				(Feature == EMediaFeature::CaptionTracks) ||
@@ -8,6 +8,16 @@ UVlcMediaSettings::UVlcMediaSettings()
 	, FileCaching(FTimespan::FromMilliseconds(300.0))
 	, LiveCaching(FTimespan::FromMilliseconds(300.0))
 	, NetworkCaching(FTimespan::FromMilliseconds(1000.0))
+	, PrecacheStartMegabytes(8)
+	, PrecacheBudgetMegabytes(1024)
+	, ReadAheadMegabytes(16)
+	, LoopCacheMegabytes(256)
+	, AudioOutputSampleRate(0)
+	, PlayerPoolSize(2)
+	, MaxVideoQueueFrames(8)
+	, MaxVideoQueueMegabytes(0)
+	, VideoQueueDropPolicy(EVlcMediaDropPolicy::DropOldest)
+	, SeekMode(EVlcMediaSeekMode::Accurate)
 	, LogLevel(EVlcMediaLogLevel::Warning)
 	, ShowLogContext(false)
 { }
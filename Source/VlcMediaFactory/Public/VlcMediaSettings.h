@@ -26,6 +26,34 @@ enum class EVlcMediaLogLevel : uint8
 };
 
 
+/**
+ * Available policies for discarding video frames when the output queue is full.
+ */
+UENUM()
+enum class EVlcMediaDropPolicy : uint8
+{
+	/** Discard the oldest queued frame to make room for the new one. */
+	DropOldest = 0,
+
+	/** Discard the newly decoded frame. */
+	DropNewest = 1,
+};
+
+
+/**
+ * Available modes for seeking in media.
+ */
+UENUM()
+enum class EVlcMediaSeekMode : uint8
+{
+	/** Seek to the nearest keyframe, which is output without decoding other frames. */
+	Fast = 0,
+
+	/** Decode from the preceding keyframe and output exactly the requested frame. */
+	Accurate = 1,
+};
+
+
 /**
  * Settings for the VlcMedia plug-in.
  */
@@ -58,6 +86,91 @@ public:
 	UPROPERTY(config, EditAnywhere, Category=Caching)
 	FTimespan NetworkCaching;
 
+	/**
+	 * Amount of a precached file that must be loaded before playback starts (in megabytes; default = 8).
+	 *
+	 * Files opened with the PrecacheFile option are loaded on a background thread,
+	 * and the player opens once this much data is resident in memory.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Caching, meta=(ClampMin=0))
+	int32 PrecacheStartMegabytes;
+
+	/**
+	 * Memory budget for precached files that are shared between players (in megabytes; default = 1024).
+	 *
+	 * Players that precache the same file share a single copy. Files that are no
+	 * longer used are kept for reuse until the budget is exceeded, at which point
+	 * the least recently used ones are released. Files in use are never released.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Caching, meta=(ClampMin=0))
+	int32 PrecacheBudgetMegabytes;
+
+	/**
+	 * Size of the read-ahead window for archive-backed media (in megabytes; 0 = disabled, default = 16).
+	 *
+	 * Media that is streamed from a file archive or pak file is read ahead on a
+	 * background thread, so that the decoder does not stall on slow storage.
+	 * Archives that are already in memory are not read ahead, and the window's
+	 * blocks are only allocated as they are filled.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Caching, meta=(ClampMin=0, ClampMax=256))
+	int32 ReadAheadMegabytes;
+
+	/**
+	 * Memory budget for the decoded samples of a looping media (in megabytes; default = 256).
+	 *
+	 * Media opened with the CacheLoop option keep the samples decoded during the
+	 * first pass, and replay later loops from memory without decoding. Media whose
+	 * decoded samples exceed the budget are decoded on every loop.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Caching, meta=(ClampMin=0))
+	int32 LoopCacheMegabytes;
+
+public:
+
+	/**
+	 * Sample rate of decoded audio (in Hz; 0 = source sample rate, default = 0).
+	 *
+	 * Set this to the sample rate of the audio mixer to let VLC do the only
+	 * resampling step. Otherwise audio is decoded at the source's sample rate
+	 * and the engine resamples it if necessary.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Output, meta=(ClampMin=0, ClampMax=192000))
+	int32 AudioOutputSampleRate;
+
+	/**
+	 * Number of VLC media players to create up front and reuse across Open calls (0 = disabled, default = 2).
+	 *
+	 * Closed players are returned to the pool instead of being destroyed, which
+	 * reduces the time from opening a media source to its first frame.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Output, meta=(ClampMin=0, ClampMax=16))
+	int32 PlayerPoolSize;
+
+	/** Maximum number of decoded video frames waiting for output (0 = unlimited, default = 8). */
+	UPROPERTY(config, EditAnywhere, Category=Output, meta=(ClampMin=0))
+	int32 MaxVideoQueueFrames;
+
+	/** Maximum size of decoded video frames waiting for output (in megabytes; 0 = unlimited, default = 0). */
+	UPROPERTY(config, EditAnywhere, Category=Output, meta=(ClampMin=0))
+	int32 MaxVideoQueueMegabytes;
+
+	/** Which frame to discard when the video output queue is full (default = DropOldest). */
+	UPROPERTY(config, EditAnywhere, Category=Output)
+	EVlcMediaDropPolicy VideoQueueDropPolicy;
+
+	/**
+	 * How players seek unless a different mode is set on the player (default = Accurate).
+	 *
+	 * Fast seeks snap to the nearest keyframe of local MP4 and QuickTime files,
+	 * whose keyframes are indexed in the background when fast seeking is first
+	 * used, so seeks do not snap until the index is built. Other media always
+	 * seek accurately. Seeks while scrubbing are fast seeks regardless of this
+	 * setting, so the same limitation applies to them.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Output)
+	EVlcMediaSeekMode SeekMode;
+
 public:
 
 	/**